@@ -183,6 +183,9 @@ void Configuration::Process(int argc, char *argv[], bool captureOverrides)
 	parser.addOption("threads", {"t"}, "N", "1",
 		"Number of worker threads, clamped to the machine's reported hardware-thread count when available.",
 		"General options");
+	parser.addOption("pin", {}, "none|cores|smt", "none",
+		"Pin worker threads to CPUs: one per physical core first, or both SMT siblings of a core first.",
+		"General options");
 	parser.addOption("max_evals", {"me"}, "N", "1000000000000000000",
 		"Stop after N evaluations (0 = unlimited).",
 		"General options");
@@ -238,6 +241,15 @@ parser.addOption("predistance", {}, "yuv|euclid|ciede|cie94|oklab|rasta", "ciede
 	parser.addOption("cache", {}, "MB", "64",
 		"Line cache size per thread in MB.",
 		"Image processing");
+	parser.addOption("shared_cache", {}, "MB", "0",
+		"Line results shared by all threads in MB (0 = off).",
+		"Image processing");
+	parser.addFlag("lean_cache", {},
+		"Cache line scores without their rendered rows; rows are re-rendered for display and saving.",
+		"Image processing");
+	parser.addOption("errmap", {}, "exact|compact", "exact",
+		"Per-pixel error table: exact 32-bit planes, or quantized 16-bit line tiles.",
+		"Image processing");
 	parser.addOption("details", {}, "FILE", "",
 		"Details-priority mask image (legacy arithmetic-sRGB mode).",
 		"Image processing");
@@ -310,6 +322,24 @@ parser.addOption("predistance", {}, "yuv|euclid|ciede|cie94|oklab|rasta", "ciede
     parser.addOption("unstuck_after", {"ua"}, "N", "0",
 		"Escalate exploration after this many evaluations without improvement (0=never).",
 		"General options");
+	parser.addOption("line_candidates", {"lc"}, "N", "1",
+		"Alternatives tried per line mutation; only the best of them is evaluated (1-16).",
+		"General options");
+	parser.addOption("islands", {}, "global|ring|torus|random|star", "global",
+		"Which workers each worker takes migrant solutions from (global = the published best).",
+		"General options");
+	parser.addOption("island_degree", {}, "N", "2",
+		"Sources per island for /islands=random.",
+		"General options");
+	parser.addOption("migrate_every", {}, "N", "50000",
+		"Evaluations per island between migrations (not /islands=global).",
+		"General options");
+	parser.addOption("migrate_rate", {}, "FLOAT", "1",
+		"Chance (0-1) that an island takes a migrant at each interval.",
+		"General options");
+	parser.addOption("migrate", {}, "best|elite", "best",
+		"What an island offers: its best solution or a random one of its elite.",
+		"General options");
     // Drift: support both --unstuck_drift (primary) and --unstuck_drift_norm (alias)
     parser.addOption("unstuck_drift", {"ud"}, "FLOAT", "0",
         "When stuck, add this normalized drift per evaluation to acceptance thresholds (0=off).",
@@ -514,6 +544,22 @@ else if (dst_name=="yuv")
 	string cache_string = parser.getValue("cache", "64");
 	cache_size = 1024*1024*String2Value<double>(cache_string);
 
+	string shared_cache_string = parser.getValue("shared_cache", "0");
+	shared_cache_size = std::max(0, static_cast<int>(1024*1024*String2Value<double>(shared_cache_string)));
+	lean_line_cache = parser.switchExists("lean_cache");
+
+	{
+		std::string v = parser.getValue("errmap", "exact");
+		for (auto &c : v) c = (char)tolower(c);
+		if (v == "compact")
+			compact_error_map = true;
+		else
+		{
+			if (v != "exact") warning_messages.push_back("Unknown errmap='" + v + "', using 'exact'.");
+			compact_error_map = false;
+		}
+	}
+
 	string seed_val;
 	seed_val = parser.getValue("seed","random");
 
@@ -542,6 +588,20 @@ else if (dst_name=="yuv")
 		threads = static_cast<int>(hardware_threads);
 	}
 
+	{
+		std::string v = parser.getValue("pin", "none");
+		for (auto &c : v) c = (char)tolower(c);
+		if (v == "cores")
+			pin_policy = PinPolicy::Cores;
+		else if (v == "smt")
+			pin_policy = PinPolicy::Smt;
+		else
+		{
+			if (v != "none") warning_messages.push_back("Unknown pin='" + v + "', using 'none'.");
+			pin_policy = PinPolicy::None;
+		}
+	}
+
 	// auto-save is on by default
 	string save_val = parser.getValue("save","auto");
 	if (save_val == "auto" || save_val == "'auto'" || save_val == "\"auto\"")
@@ -618,6 +678,35 @@ else if (dst_name=="yuv")
 		unstuck_after = String2Value<unsigned long long>(ua);
 	}
 
+	{
+		std::string lc = parser.getValue("line_candidates", "1");
+		std::string lc2 = parser.getValue("lc", "");
+		if (!lc2.empty()) lc = lc2;
+		line_candidates = String2Value<int>(lc);
+		if (line_candidates < 1) line_candidates = 1;
+		if (line_candidates > 16) line_candidates = 16;
+	}
+
+	{
+		std::string v = parser.getValue("islands", "global");
+		for (auto &c : v) c = (char)tolower(c);
+		if (!ParseIslandTopology(v, island_topology))
+		{
+			warning_messages.push_back("Unknown islands='" + v + "', using 'global'.");
+			island_topology = IslandTopology::Global;
+		}
+		island_degree = std::max(1, String2Value<int>(parser.getValue("island_degree", "2")));
+		migrate_every = std::max(1ULL,
+			String2Value<unsigned long long>(parser.getValue("migrate_every", "50000")));
+		migrate_rate = std::min(1.0, std::max(0.0,
+			String2Value<double>(parser.getValue("migrate_rate", "1"))));
+		std::string m = parser.getValue("migrate", "best");
+		for (auto &c : m) c = (char)tolower(c);
+		if (m != "best" && m != "elite")
+			warning_messages.push_back("Unknown migrate='" + m + "', using 'best'.");
+		migrate_elite = m == "elite";
+	}
+
     // Parse normalized drift per evaluation when stuck (prefer primary name, accept alias)
     {
         std::string ud = parser.getValue("unstuck_drift", "0");
@@ -840,6 +929,36 @@ else if (dst_name=="yuv")
 		if (dual_dither_rand > 1.0) dual_dither_rand = 1.0;
 	}
 
+	if (dual_mode && compact_error_map)
+	{
+		warning_messages.push_back("Dual mode scores blended pairs, not the error map; ignoring /errmap=compact.");
+		compact_error_map = false;
+	}
+
+	if (dual_mode && shared_cache_size)
+	{
+		warning_messages.push_back("Dual mode renders each frame against the other; ignoring /shared_cache.");
+		shared_cache_size = 0;
+	}
+
+	if (dual_mode && lean_line_cache)
+	{
+		warning_messages.push_back("Dual mode renders against the other frame's cached rows; ignoring /lean_cache.");
+		lean_line_cache = false;
+	}
+
+	if (optimizer == E_OPT_LEGACY && lean_line_cache)
+	{
+		warning_messages.push_back("The legacy optimizer shows the best picture from cached rows; ignoring /lean_cache.");
+		lean_line_cache = false;
+	}
+
+	if ((dual_mode || optimizer == E_OPT_LEGACY) && island_topology != IslandTopology::Global)
+	{
+		warning_messages.push_back("Only the LAHC and DLAS single-frame search runs islands; ignoring /islands.");
+		island_topology = IslandTopology::Global;
+	}
+
 	if (dual_mode && visual_objective != E_OBJECTIVE_LEGACY_TARGET)
 	{
 		warning_messages.push_back("Source-referenced objectives are single-frame experiments; using legacy for dual mode.");
@@ -19,6 +19,8 @@
 #include <assert.h>
 #include "rgb.h"
 #include "Program.h"
+#include "IslandTopology.h"
+#include "WorkerPlacement.h"
 
 enum e_init_type {
 	E_INIT_RANDOM,
@@ -104,9 +106,19 @@ struct Configuration {
 	int save_period;
 	unsigned long initial_seed;
 	int cache_size;
+	// /shared_cache: bytes of line results all worker threads share (0 = off)
+	int shared_cache_size = 0;
+	// /lean_cache: cached line results keep no rows; they are re-rendered
+	// from the published program when shown or saved
+	bool lean_line_cache = false;
+	// /errmap=compact: score from 16-bit quantized line tiles (CompactErrorMap)
+	bool compact_error_map = false;
 
 	bool preprocess_only;
 	int threads;
+	// /pin: worker CPU affinity; pinned runs also replicate the scoring
+	// tables on every NUMA node that has workers
+	PinPolicy pin_policy = PinPolicy::None;
 	int width;
 	int height;
 	GraphicsMode graphics_mode = GraphicsMode::AnticE;
@@ -148,6 +160,20 @@ struct Configuration {
 	// evaluations without improvement (0 = never escalate)
 	unsigned long long unstuck_after = 0ULL;
 
+	// /line_candidates: alternatives tried per primary line mutation, the
+	// best of which goes on to acceptance (1 = plain single mutation)
+	int line_candidates = 1;
+
+	// /islands: which workers each single-frame worker takes migrants from,
+	// every /migrate_every of its evaluations with chance /migrate_rate.
+	// /migrate=elite offers a random one of the island's few best solutions
+	// instead of its best.
+	IslandTopology island_topology = IslandTopology::Global;
+	int island_degree = 2;
+	unsigned long long migrate_every = 50000ULL;
+	double migrate_rate = 1.0;
+	bool migrate_elite = false;
+
 	// When stuck, add this normalized drift to acceptance thresholds per evaluation
 	// Units: normalized distance (same scale as Norm. Dist). 0 = disabled.
 	double unstuck_drift_norm = 0.0;
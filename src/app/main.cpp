@@ -14,6 +14,7 @@
 #include <stdint.h>
 #include "platform/win/ConsoleCtrlWin.h" 
 #include "rasta.h"
+#include "CpuDispatch.h"
 #include "debug_log.h"
 #include "version.h"
 #include "Interrupt.h"
@@ -200,6 +201,8 @@ int main(int argc, char *argv[])
 	// Version display
 	if (cfg.show_version) {
 		std::cout << "RastaConverter " << RASTA_CONVERTER_VERSION << std::endl;
+		std::cout << "Evaluator kernels: " << SimdLevelName(ActiveSimdLevel())
+			<< " (CPU supports " << SimdLevelName(DetectSimdLevel()) << ")" << std::endl;
 		return 0;
 	}
 
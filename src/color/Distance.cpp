@@ -99,19 +99,13 @@ static void RGB2OKLAB(const rgb &c, Lab &result)
 	}
 	rwlock.unlock_shared();
 
+	// Converted before it is published: other threads read the entry as soon
+	// as the lock is released, so it must never hold a placeholder.
+	Lab converted;
+	RGB2OKLABDirect(c, converted);
 	rwlock.lock();
-	auto r = rgb_oklab_map.insert(rgb_oklab_map_t::value_type(c, Lab()));
+	result = rgb_oklab_map.insert(rgb_oklab_map_t::value_type(c, converted)).first->second;
 	rwlock.unlock();
-
-	if (!r.second)
-	{
-		result = r.first->second;
-	}
-	else
-	{
-		RGB2OKLABDirect(c, result);
-		r.first->second = result;
-	}
 }
 
 static inline distance_t OklabDistanceEnergy(const Lab &first, const Lab &second)
@@ -146,6 +140,60 @@ static inline distance_t OklabScaledDistanceEnergy(const Lab &first, const Lab &
 	return (distance_t)(dist + 0.5);
 }
 
+static void RGB2LABDirect(const rgb &c, Lab &result)
+{
+	int ir = c.r;
+	int ig = c.g;
+	int ib = c.b;
+
+	float fr = ((float) ir) / 255.0f;
+	float fg = ((float) ig) / 255.0f;
+	float fb = ((float) ib) / 255.0f;
+
+	if (fr > 0.04045f)
+		fr = powf((fr + 0.055f) / 1.055f, 2.4f);
+	else
+		fr = fr / 12.92f;
+
+	if (fg > 0.04045f)
+		fg = powf((fg + 0.055f) / 1.055f, 2.4f);
+	else
+		fg = fg / 12.92f;
+
+	if (fb > 0.04045f)
+		fb = powf((fb + 0.055f) / 1.055f, 2.4f);
+	else
+		fb = fb / 12.92f;
+
+	// Use white = D65
+	const float x = fr * 0.4124f + fg * 0.3576f + fb * 0.1805f;
+	const float y = fr * 0.2126f + fg * 0.7152f + fb * 0.0722f;
+	const float z = fr * 0.0193f + fg * 0.1192f + fb * 0.9505f;
+
+	float vx = x / 0.95047f;
+	float vy = y;
+	float vz = z / 1.08883f;
+
+	if (vx > 0.008856f)
+		vx = (float) cbrt(vx);
+	else
+		vx = (7.787f * vx) + (16.0f / 116.0f);
+
+	if (vy > 0.008856f)
+		vy = (float) cbrt(vy);
+	else
+		vy = (7.787f * vy) + (16.0f / 116.0f);
+
+	if (vz > 0.008856f)
+		vz = (float) cbrt(vz);
+	else
+		vz = (7.787f * vz) + (16.0f / 116.0f);
+
+	result.L = 116.0f * vy - 16.0f;
+	result.a = 500.0f * (vx - vy);
+	result.b = 200.0f * (vy - vz);
+}
+
 static void RGB2LAB(const rgb &c, Lab &result)
 {
 	static std::shared_mutex rwlock{};
@@ -159,68 +207,12 @@ static void RGB2LAB(const rgb &c, Lab &result)
 	}
 	rwlock.unlock_shared();
 
+	// As in RGB2OKLAB, the entry is only published with its value filled in.
+	Lab converted;
+	RGB2LABDirect(c, converted);
 	rwlock.lock();
-	auto r = rgb_lab_map.insert(rgb_lab_map_t::value_type(c, Lab()));
+	result = rgb_lab_map.insert(rgb_lab_map_t::value_type(c, converted)).first->second;
 	rwlock.unlock();
-
-	if (!r.second)
-	{
-		result = r.first->second;
-	}
-	else
-	{
-				int ir = c.r;
-				int ig = c.g;
-				int ib = c.b;
-
-				float fr = ((float) ir) / 255.0f;
-				float fg = ((float) ig) / 255.0f;
-				float fb = ((float) ib) / 255.0f;
-
-				if (fr > 0.04045f)
-						fr = powf((fr + 0.055f) / 1.055f, 2.4f);
-				else
-						fr = fr / 12.92f;
-
-				if (fg > 0.04045f)
-						fg = powf((fg + 0.055f) / 1.055f, 2.4f);
-				else
-						fg = fg / 12.92f;
-
-				if (fb > 0.04045f)
-						fb = powf((fb + 0.055f) / 1.055f, 2.4f);
-				else
-						fb = fb / 12.92f;
-
-				// Use white = D65
-				const float x = fr * 0.4124f + fg * 0.3576f + fb * 0.1805f;
-				const float y = fr * 0.2126f + fg * 0.7152f + fb * 0.0722f;
-				const float z = fr * 0.0193f + fg * 0.1192f + fb * 0.9505f;
-
-				float vx = x / 0.95047f;
-				float vy = y;
-				float vz = z / 1.08883f;
-
-				if (vx > 0.008856f)
-						vx = (float) cbrt(vx);
-				else
-						vx = (7.787f * vx) + (16.0f / 116.0f);
-
-				if (vy > 0.008856f)
-						vy = (float) cbrt(vy);
-				else
-						vy = (7.787f * vy) + (16.0f / 116.0f);
-
-				if (vz > 0.008856f)
-						vz = (float) cbrt(vz);
-				else
-						vz = (7.787f * vz) + (16.0f / 116.0f);
-
-				result.L = 116.0f * vy - 16.0f;
-				result.a = 500.0f * (vx - vy);
-				result.b = 200.0f * (vy - vz);
-				r.first->second = result;
-	}
 }
 
 double CIE94(const double L1,const double a1,const double b1, 
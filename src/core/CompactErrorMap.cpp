@@ -0,0 +1,88 @@
+#include "CompactErrorMap.h"
+
+#include <algorithm>
+
+namespace
+{
+unsigned BitLength(distance_t value)
+{
+	unsigned length = 0;
+	while (value)
+	{
+		++length;
+		value >>= 1;
+	}
+	return length;
+}
+
+// Rows start on 32-byte boundaries within a tile: one AVX2 vector of errors.
+constexpr size_t k_row_alignment = 16;
+}
+
+unsigned SelectCompactErrorShift(const unsigned long long bit_length_histogram[33],
+	unsigned long long allowed)
+{
+	const unsigned value_bits = 16;
+	for (unsigned shift = 0; shift < 32 - value_bits; ++shift)
+	{
+		unsigned long long saturated = 0;
+		for (unsigned length = value_bits + shift + 1; length <= 32; ++length)
+			saturated += bit_length_histogram[length];
+		if (saturated <= allowed)
+			return shift;
+	}
+	return 32 - value_bits;
+}
+
+void CompactErrorMap::Build(const distance_t* const* planes, unsigned width, unsigned height)
+{
+	const size_t pixels = static_cast<size_t>(width) * height;
+	unsigned long long histogram[33] = {};
+	for (int color = 0; color < colors; ++color)
+	{
+		for (size_t index = 0; index < pixels; ++index)
+			++histogram[BitLength(planes[color][index])];
+	}
+	const unsigned long long entries = static_cast<unsigned long long>(pixels) * colors;
+	const unsigned shift = SelectCompactErrorShift(histogram, entries / 1000);
+
+	m_stride = (static_cast<size_t>(width) + k_row_alignment - 1)
+		/ k_row_alignment * k_row_alignment;
+	m_values.assign(m_stride * colors * height, 0);
+
+	const unsigned long long half = shift ? 1ull << (shift - 1) : 0;
+	unsigned long long saturated = 0;
+	double absError = 0.0;
+	double exactTotal = 0.0;
+	for (unsigned y = 0; y < height; ++y)
+	{
+		for (int color = 0; color < colors; ++color)
+		{
+			const distance_t* source = planes[color] + static_cast<size_t>(y) * width;
+			uint16_t* row = m_values.data() + (static_cast<size_t>(y) * colors + color) * m_stride;
+			for (unsigned x = 0; x < width; ++x)
+			{
+				const unsigned long long exact = source[x];
+				unsigned long long value = (exact + half) >> shift;
+				if (value > max_value)
+				{
+					// Rounding the top of the range up by one is not saturation.
+					if ((exact >> shift) > max_value)
+						++saturated;
+					value = max_value;
+				}
+				row[x] = static_cast<uint16_t>(value);
+				const unsigned long long restored = value << shift;
+				absError += static_cast<double>(
+					restored > exact ? restored - exact : exact - restored);
+				exactTotal += static_cast<double>(exact);
+			}
+		}
+	}
+
+	m_quantization.shift = shift;
+	m_quantization.mean_abs_error = entries ? absError / static_cast<double>(entries) : 0.0;
+	m_quantization.mean_relative_error = exactTotal > 0.0 ? absError / exactTotal : 0.0;
+	m_quantization.saturated_fraction = entries
+		? static_cast<double>(saturated) / static_cast<double>(entries) : 0.0;
+}
@@ -0,0 +1,69 @@
+#ifndef COMPACTERRORMAP_H
+#define COMPACTERRORMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Distance.h"
+
+// 16-bit copy of the picture error map for /errmap=compact. The exact map is
+// 128 full-picture planes of 32-bit errors, so one pixel's candidates are
+// 128 planes apart. Here the 128 colour rows of a picture line sit together
+// in one tile (about 40 KB at 160 pixels). A line is rendered entirely from
+// its tile, which stays in L2 while the line is scored.
+//
+// Stored values are round(error / 2^shift), saturated at 0xFFFF. The shift is
+// the smallest that keeps all but about 0.1% of the errors unsaturated;
+// the saturated ones are candidates far too poor to be chosen. At() scales
+// values back, so scores keep the units of the exact map.
+class CompactErrorMap
+{
+public:
+	static constexpr int colors = 128;
+	static constexpr unsigned max_value = 0xFFFF;
+
+	struct Quantization
+	{
+		unsigned shift = 0;
+		// Mean |dequantized - exact| over every entry, and the same relative
+		// to the mean exact error.
+		double mean_abs_error = 0.0;
+		double mean_relative_error = 0.0;
+		double saturated_fraction = 0.0;
+	};
+
+	// Rebuilds the tiles from the exact planes, reusing storage when the
+	// picture size is unchanged.
+	void Build(const distance_t* const* planes, unsigned width, unsigned height);
+
+	bool Empty() const { return m_values.empty(); }
+	unsigned Shift() const { return m_quantization.shift; }
+	const Quantization& LastQuantization() const { return m_quantization; }
+	size_t Bytes() const { return m_values.size() * sizeof(uint16_t); }
+
+	// Row of `color` for picture line y, indexed by x.
+	const uint16_t* Row(int color, int y) const
+	{
+		return m_values.data()
+			+ (static_cast<size_t>(y) * colors + color) * m_stride;
+	}
+
+	distance_t At(int color, int y, int x) const
+	{
+		return static_cast<distance_t>(Row(color, y)[x]) << m_quantization.shift;
+	}
+
+private:
+	std::vector<uint16_t> m_values;
+	size_t m_stride = 0;
+	Quantization m_quantization;
+};
+
+// Smallest shift that leaves at most `allowed` of the values counted in
+// bit_length_histogram above max_value after rounding. Bucket b counts values
+// whose bit length is b (0..32).
+unsigned SelectCompactErrorShift(const unsigned long long bit_length_histogram[33],
+	unsigned long long allowed);
+
+#endif
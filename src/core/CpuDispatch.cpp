@@ -0,0 +1,122 @@
+#include "CpuDispatch.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <string>
+
+#if RASTA_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace
+{
+#if RASTA_X86
+void Cpuid(int leaf, int subleaf, unsigned registers[4])
+{
+#if defined(_MSC_VER)
+	int values[4];
+	__cpuidex(values, leaf, subleaf);
+	for (int i = 0; i < 4; ++i)
+		registers[i] = static_cast<unsigned>(values[i]);
+#else
+	__cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+// XCR0 tells whether the OS saves the YMM state on a context switch; AVX2
+// reported by cpuid is unusable without it.
+unsigned long long ReadXcr0()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	unsigned eax = 0;
+	unsigned edx = 0;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+#endif
+}
+
+SimdLevel DetectSimdLevel()
+{
+#if RASTA_X86
+	unsigned basic[4];
+	Cpuid(0, 0, basic);
+	const unsigned maxLeaf = basic[0];
+	if (maxLeaf < 1)
+		return SimdLevel::Scalar;
+
+	unsigned features[4];
+	Cpuid(1, 0, features);
+	const bool sse41 = (features[2] & (1u << 19)) != 0;
+	const bool ssse3 = (features[2] & (1u << 9)) != 0;
+	if (!sse41 || !ssse3)
+		return SimdLevel::Scalar;
+
+	const bool osxsave = (features[2] & (1u << 27)) != 0;
+	const bool avx = (features[2] & (1u << 28)) != 0;
+	if (maxLeaf >= 7 && osxsave && avx && (ReadXcr0() & 0x6) == 0x6)
+	{
+		unsigned extended[4];
+		Cpuid(7, 0, extended);
+		if (extended[1] & (1u << 5))
+			return SimdLevel::Avx2;
+	}
+	return SimdLevel::Sse41;
+#else
+	return SimdLevel::Scalar;
+#endif
+}
+
+bool ParseSimdLevel(const char* text, SimdLevel& level, bool& automatic)
+{
+	if (!text)
+		return false;
+	std::string value(text);
+	for (char& c : value)
+		c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+
+	automatic = false;
+	if (value == "auto")
+		automatic = true;
+	else if (value == "scalar" || value == "off" || value == "0")
+		level = SimdLevel::Scalar;
+	else if (value == "sse4.1" || value == "sse4" || value == "sse41")
+		level = SimdLevel::Sse41;
+	else if (value == "avx2")
+		level = SimdLevel::Avx2;
+	else
+		return false;
+	return true;
+}
+
+SimdLevel ActiveSimdLevel()
+{
+	static const SimdLevel active = []
+	{
+		const SimdLevel detected = DetectSimdLevel();
+		SimdLevel requested = detected;
+		bool automatic = true;
+		if (!ParseSimdLevel(std::getenv("RASTA_SIMD"), requested, automatic) || automatic)
+			return detected;
+		return requested < detected ? requested : detected;
+	}();
+	return active;
+}
+
+const char* SimdLevelName(SimdLevel level)
+{
+	switch (level)
+	{
+	case SimdLevel::Avx2: return "avx2";
+	case SimdLevel::Sse41: return "sse4.1";
+	case SimdLevel::Scalar: break;
+	}
+	return "scalar";
+}
@@ -0,0 +1,44 @@
+#ifndef CPUDISPATCH_H
+#define CPUDISPATCH_H
+
+// Runtime selection of the evaluator's vector kernels. A release binary is
+// built for the portable baseline; kernels for newer instruction sets are
+// compiled alongside it and chosen here once, at startup, from cpuid.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RASTA_X86 1
+#else
+#define RASTA_X86 0
+#endif
+
+// Marks a function as compiled for a newer instruction set than the rest of
+// the translation unit. MSVC accepts the intrinsics without it.
+#if RASTA_X86 && (defined(__GNUC__) || defined(__clang__))
+#define RASTA_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define RASTA_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RASTA_TARGET_SSE41
+#define RASTA_TARGET_AVX2
+#endif
+
+enum class SimdLevel
+{
+	Scalar,
+	Sse41,
+	Avx2,
+};
+
+// Highest level this CPU and operating system can run.
+SimdLevel DetectSimdLevel();
+
+// The level the kernels use: the detected level, optionally lowered by the
+// RASTA_SIMD environment variable (scalar, sse4.1, avx2 or auto). A request
+// above what the machine supports is clamped rather than trusted.
+SimdLevel ActiveSimdLevel();
+
+// Parses a RASTA_SIMD value; returns false for anything unrecognised.
+bool ParseSimdLevel(const char* text, SimdLevel& level, bool& automatic);
+
+const char* SimdLevelName(SimdLevel level);
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef EVALUATIONCOUNTERS_H
+#define EVALUATIONCOUNTERS_H
+
+#include <atomic>
+#include <cstddef>
+
+// Evaluation numbers one worker reserved from EvalGlobalState::m_evaluations
+// and has not used yet. Only the owning worker writes its slot; each slot
+// fills a cache line so those writes never invalidate a line another core
+// reads. The coordinator sums the slots on its tick.
+struct alignas(64) EvalWorkerCounters
+{
+	std::atomic<unsigned long long> unused_evaluations{0};
+};
+
+// Takes batch numbers from handedOut for the worker owning slot and returns
+// the first. The slot announces the batch before the numbers are handed out,
+// so a reader that sees the new total also sees the batch as unused.
+inline unsigned long long ReserveEvaluations(std::atomic<unsigned long long>& handedOut,
+	EvalWorkerCounters& slot, unsigned long long batch)
+{
+	slot.unused_evaluations.store(batch, std::memory_order_relaxed);
+	return handedOut.fetch_add(batch, std::memory_order_release) + 1ULL;
+}
+
+// Gives back the numbers the worker owning slot reserved and did not use,
+// when it stops. The slot is cleared after the total drops, so a readout
+// that sees it cleared also sees the lower total.
+inline void ReturnEvaluations(std::atomic<unsigned long long>& handedOut,
+	EvalWorkerCounters& slot, unsigned long long unused)
+{
+	if (unused)
+		handedOut.fetch_sub(unused, std::memory_order_relaxed);
+	slot.unused_evaluations.store(0ULL, std::memory_order_release);
+}
+
+inline unsigned long long SumUnusedEvaluations(const EvalWorkerCounters* slots, size_t count)
+{
+	unsigned long long unused = 0;
+	for (size_t i = 0; i < count; ++i)
+		unused += slots[i].unused_evaluations.load(std::memory_order_acquire);
+	return unused;
+}
+
+// One readout from the total read before the slots, their sum, and the total
+// read after. False when the total moved in between: a reservation or a
+// return there would count a whole batch as done, so the caller reads again.
+inline bool CompletedFromReadout(unsigned long long before, unsigned long long unused,
+	unsigned long long after, unsigned long long& completed)
+{
+	if (before != after)
+		return false;
+	completed = before > unused ? before - unused : 0ULL;
+	return true;
+}
+
+// handedOut less the numbers the workers reserved but have not reached. The
+// total moves once per batch, so a retry is rare and a second one rarer still.
+inline unsigned long long CountCompletedEvaluations(
+	const std::atomic<unsigned long long>& handedOut,
+	const EvalWorkerCounters* slots, size_t count)
+{
+	unsigned long long before = handedOut.load(std::memory_order_acquire);
+	for (;;)
+	{
+		const unsigned long long unused = SumUnusedEvaluations(slots, count);
+		const unsigned long long after = handedOut.load(std::memory_order_acquire);
+		unsigned long long completed = 0;
+		if (CompletedFromReadout(before, unused, after, completed))
+			return completed;
+		before = after;
+	}
+}
+
+#endif
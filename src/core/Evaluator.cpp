@@ -12,12 +12,18 @@
 #include "OptimizerState.h"
 #include "TargetPicture.h"
 #include "StructuredSolver.h"
+#include "PlayfieldSpan.h"
 #include "prng_xoroshiro.h"
+#include "WorkerPlacement.h"
 #include <cfloat>
 #include <chrono>
 #include "debug_log.h"
 #include "debug_log.h"
 
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
 #if defined(__ARM_NEON) || defined(__aarch64__)
 #include <arm_neon.h>
 #define RASTA_HAS_ARM_NEON 1
@@ -25,6 +31,20 @@
 #define RASTA_HAS_ARM_NEON 0
 #endif
 
+// Page faults the calling thread has taken so far; zero where unsupported.
+static void ThreadPageFaults(unsigned long long& minor, unsigned long long& major)
+{
+	minor = major = 0;
+#if defined(__linux__) && defined(RUSAGE_THREAD)
+	struct rusage usage;
+	if (getrusage(RUSAGE_THREAD, &usage) == 0)
+	{
+		minor = static_cast<unsigned long long>(usage.ru_minflt);
+		major = static_cast<unsigned long long>(usage.ru_majflt);
+	}
+#endif
+}
+
 void RasterMutationTransaction::Begin(raster_picture& picture, unsigned long long allocatorEpoch)
 {
 	for (unsigned index : m_touched)
@@ -38,9 +58,11 @@ void RasterMutationTransaction::Begin(raster_picture& picture, unsigned long lon
 	m_picture = &picture;
 	m_memory_saved = false;
 	m_allocator_epoch = allocatorEpoch;
+	m_dirty_first = static_cast<int>(picture.raster_lines.size());
+	m_dirty_last = -1;
 }
 
-void RasterMutationTransaction::SaveMemory()
+void RasterMutationTransaction::SnapshotMemory()
 {
 	if (!m_picture || m_memory_saved)
 		return;
@@ -49,6 +71,24 @@ void RasterMutationTransaction::SaveMemory()
 	m_memory_saved = true;
 }
 
+void RasterMutationTransaction::MarkDirty(int first, int last)
+{
+	m_dirty_first = std::min(m_dirty_first, first);
+	m_dirty_last = std::max(m_dirty_last, last);
+}
+
+void RasterMutationTransaction::SaveMemory()
+{
+	SnapshotMemory();
+	MarkDirty(0, 0);
+}
+
+void RasterMutationTransaction::SaveAttributes(int firstLine, int lastLine)
+{
+	SnapshotMemory();
+	MarkDirty(firstLine, lastLine);
+}
+
 void RasterMutationTransaction::SaveLine(int y)
 {
 	if (!m_picture || y < 0 || y >= static_cast<int>(m_picture->raster_lines.size()))
@@ -68,6 +108,23 @@ void RasterMutationTransaction::SaveMutationNeighborhood(int y)
 	SaveLine(y + 1);
 }
 
+void RasterMutationTransaction::RecacheSavedLines(
+	insn_sequence_cache& cache, linear_allocator& alloc)
+{
+	if (!m_picture)
+		return;
+	for (unsigned index : m_touched)
+	{
+		raster_line& line = m_picture->raster_lines[index];
+		if (line.cache_key == NULL)
+			line.recache_insns(cache, alloc);
+		// Interning maps equal sequences to one key, so an unchanged key means
+		// the line renders exactly as before.
+		if (line.cache_key != m_snapshots[index].cache_key)
+			MarkDirty(static_cast<int>(index), static_cast<int>(index));
+	}
+}
+
 void RasterMutationTransaction::Restore(unsigned long long allocatorEpoch)
 {
 	if (!m_picture)
@@ -101,6 +158,28 @@ struct PmgPixelSnapshot
 	unsigned char shift_emitted[4];
 };
 
+// A run of visible pixels rendered with one register and shifter state. The
+// state only changes when an instruction completes or a player starts
+// shifting, so a line is a handful of spans rather than one state per pixel.
+struct PmgPixelSpan
+{
+	PmgPixelSnapshot state;
+	int first;
+	int end;
+};
+
+// First sprite-check position in [from, to) at which any player starts
+// shifting out, or `to` when none does.
+inline int NextSpriteShiftStart(const unsigned char* start_array, int from, int to)
+{
+	for (int position = from; position < to; ++position)
+	{
+		if (start_array[position])
+			return position;
+	}
+	return to;
+}
+
 struct PmgHposEvent
 {
 	unsigned char sprite;
@@ -109,6 +188,40 @@ struct PmgHposEvent
 	int check_x;
 };
 
+// Everything a line's CPU and shifters contribute to its pixels: the spans
+// with their register states, the player moves and the outgoing registers
+// (before the ANTIC 4 CHBASE suffix). None of it depends on the attribute row
+// or on which pixels end up drawn by players.
+struct LineRegisterTrace
+{
+	register_state new_state;
+	const PmgPixelSpan* spans;
+	const PmgHposEvent* events;
+	int span_count;
+	int event_count;
+};
+
+// Compile-time shape of one render. Mode and width fix the player set, the
+// priority resolver and the sprite origin; Dual swaps the error planes for the
+// blended two-frame objective and its cache. ExecuteRasterProgram picks the
+// instantiation once per call, so the line and pixel loops never test them.
+template<GraphicsMode Mode, PlayfieldWidth Width, bool Dual>
+struct RenderPolicy
+{
+	static constexpr bool antic4 = Mode == GraphicsMode::Antic4;
+	static constexpr bool normal_antic4 = antic4 && Width == PlayfieldWidth::Normal;
+	static constexpr bool dual = Dual;
+	static constexpr int usable_players = normal_antic4 ? 2 : 4;
+	static constexpr int sprite_screen_start = SpriteScreenColorCycleStart(Mode, Width);
+};
+
+typedef RenderPolicy<GraphicsMode::AnticE, PlayfieldWidth::Normal, false> RenderAnticENormal;
+typedef RenderPolicy<GraphicsMode::AnticE, PlayfieldWidth::Wide, false> RenderAnticEWide;
+typedef RenderPolicy<GraphicsMode::Antic4, PlayfieldWidth::Normal, false> RenderAntic4Normal;
+typedef RenderPolicy<GraphicsMode::Antic4, PlayfieldWidth::Wide, false> RenderAntic4Wide;
+// Dual runs are limited to normal-width mode E by configuration.
+typedef RenderPolicy<GraphicsMode::AnticE, PlayfieldWidth::Normal, true> RenderDualAnticENormal;
+
 class ActiveRasterPictureScope
 {
 public:
@@ -192,13 +305,81 @@ EvalGlobalState::EvalGlobalState()
 	, m_condvar_update()
 	, m_thread_count(1) 
 {
-	memset(m_mutation_stats, 0, sizeof(m_mutation_stats));
 }
 
 EvalGlobalState::~EvalGlobalState()
 {
 }
 
+void EvalGlobalState::ResetWorkerCounters(size_t workers)
+{
+	m_worker_counters.reset(workers ? new EvalWorkerCounters[workers] : nullptr);
+	m_worker_counter_count = workers;
+	m_islands.reset(workers ? new IslandSlot[workers] : nullptr);
+	m_island_count = workers;
+}
+
+template<class T, class Better>
+static void RaiseAtomic(std::atomic<T>& target, T value, Better better)
+{
+	T current = target.load(std::memory_order_relaxed);
+	while (better(value, current)
+		&& !target.compare_exchange_weak(current, value, std::memory_order_acq_rel,
+			std::memory_order_relaxed))
+	{
+	}
+}
+
+unsigned long long EvalGlobalState::PublishBestSnapshot(
+	std::shared_ptr<PublishedBestSnapshot> snapshot, unsigned long long evaluation)
+{
+	std::shared_ptr<const PublishedBestSnapshot> current =
+		std::atomic_load_explicit(&m_best_snapshot, std::memory_order_acquire);
+	for (;;)
+	{
+		if (snapshot->cost >= m_best_result.load(std::memory_order_acquire)
+			|| (current && snapshot->cost >= current->cost))
+			return 0;
+		snapshot->version = std::max(current ? current->version : 0ULL,
+			m_best_state_version.load(std::memory_order_acquire)) + 1;
+		std::shared_ptr<const PublishedBestSnapshot> desired = snapshot;
+		if (std::atomic_compare_exchange_weak_explicit(&m_best_snapshot, &current,
+				std::move(desired), std::memory_order_acq_rel, std::memory_order_acquire))
+			break;
+	}
+	// Racing publishers may finish in any order; these only ever improve.
+	RaiseAtomic(m_best_result, snapshot->cost, std::less<double>());
+	RaiseAtomic(m_best_state_version, snapshot->version, std::greater<unsigned long long>());
+	RaiseAtomic(m_last_best_evaluation, evaluation, std::greater<unsigned long long>());
+	return snapshot->version;
+}
+
+void EvalGlobalState::ClearEmigrants()
+{
+	for (size_t i = 0; i < m_island_count; ++i)
+		std::atomic_store_explicit(&m_islands[i].emigrant,
+			std::shared_ptr<const PublishedBestSnapshot>(), std::memory_order_release);
+}
+
+unsigned long long EvalGlobalState::CompletedEvaluations() const
+{
+	return CountCompletedEvaluations(m_evaluations, m_worker_counters.get(),
+		m_worker_counter_count);
+}
+
+double EvalGlobalState::NormalizedDrift(unsigned long long evaluation) const
+{
+	if (m_unstuck_drift_norm <= 0.0 || m_unstuck_after == 0)
+		return 0.0;
+	const unsigned long long lastBest = m_last_best_evaluation.load(std::memory_order_relaxed);
+	if (evaluation <= lastBest)
+		return 0.0;
+	const unsigned long long plateau = evaluation - lastBest;
+	if (plateau < m_unstuck_after)
+		return 0.0;
+	return m_unstuck_drift_norm * static_cast<double>(plateau - m_unstuck_after + 1ULL);
+}
+
 Evaluator::Evaluator()
 	: m_currently_mutated_y(0)
 	, m_best_result(DBL_MAX)
@@ -389,23 +570,43 @@ void Evaluator::FlushCacheDiagnosticsToGlobal()
 {
 	if (!m_gstate)
 		return;
-	m_gstate->m_single_cache_partial_clears.fetch_add(m_cache_partial_clears, std::memory_order_relaxed);
-	m_gstate->m_single_cache_full_clears.fetch_add(m_cache_full_clears, std::memory_order_relaxed);
+	m_gstate->m_cache_evictions.fetch_add(m_line_slots.evictions(), std::memory_order_relaxed);
+	m_gstate->m_cache_eviction_skips.fetch_add(m_line_slots.eviction_skips(), std::memory_order_relaxed);
+	m_gstate->m_cache_slot_overflows.fetch_add(m_line_slots.overflows(), std::memory_order_relaxed);
+	m_gstate->m_cache_trace_clears.fetch_add(m_cache_trace_clears, std::memory_order_relaxed);
+	m_gstate->m_cache_budget_resets.fetch_add(m_cache_budget_resets, std::memory_order_relaxed);
+	m_gstate->m_shared_cache_lookups.fetch_add(m_local_shared_cache_lookups, std::memory_order_relaxed);
+	m_gstate->m_shared_cache_hits.fetch_add(m_local_shared_cache_hits, std::memory_order_relaxed);
+	m_gstate->m_shared_cache_publishes.fetch_add(m_local_shared_cache_publishes, std::memory_order_relaxed);
+	m_gstate->m_shared_cache_rejected_publishes.fetch_add(
+		m_local_shared_cache_rejected_publishes, std::memory_order_relaxed);
 	m_gstate->m_cache_lookups.fetch_add(m_local_cache_lookups, std::memory_order_relaxed);
 	m_gstate->m_cache_hits.fetch_add(m_local_cache_hits, std::memory_order_relaxed);
 	m_gstate->m_cache_misses.fetch_add(m_local_cache_misses, std::memory_order_relaxed);
 	m_gstate->m_cache_lookup_probes.fetch_add(m_local_cache_lookup_probes, std::memory_order_relaxed);
 	AtomicMaxRelaxed(m_gstate->m_cache_max_lookup_probes, m_local_cache_max_lookup_probes);
 	m_gstate->m_cache_inserts.fetch_add(m_local_cache_inserts, std::memory_order_relaxed);
-	m_gstate->m_cache_hash_blocks.fetch_add(m_local_cache_hash_blocks, std::memory_order_relaxed);
+	m_gstate->m_cache_table_growths.fetch_add(m_local_cache_table_growths, std::memory_order_relaxed);
 	m_gstate->m_cache_entry_bytes.fetch_add(
 		m_insn_allocator.allocated_bytes(linear_allocator::LINE_CACHE_ENTRY), std::memory_order_relaxed);
-	m_gstate->m_cache_hash_block_bytes.fetch_add(
-		m_insn_allocator.allocated_bytes(linear_allocator::LINE_CACHE_HASH_BLOCK), std::memory_order_relaxed);
+	m_gstate->m_cache_table_bytes.fetch_add(
+		m_insn_allocator.allocated_bytes(linear_allocator::LINE_CACHE_TABLE), std::memory_order_relaxed);
 	m_gstate->m_cache_color_row_bytes.fetch_add(
 		m_insn_allocator.allocated_bytes(linear_allocator::LINE_CACHE_COLOR_ROW), std::memory_order_relaxed);
 	m_gstate->m_cache_target_row_bytes.fetch_add(
 		m_insn_allocator.allocated_bytes(linear_allocator::LINE_CACHE_TARGET_ROW), std::memory_order_relaxed);
+	m_gstate->m_cache_trace_bytes.fetch_add(
+		m_insn_allocator.allocated_bytes(linear_allocator::LINE_CACHE_TRACE), std::memory_order_relaxed);
+	m_gstate->m_cache_retained_bytes.fetch_add(
+		m_cache_allocator_stats.retained_bytes, std::memory_order_relaxed);
+	m_gstate->m_cache_huge_page_bytes.fetch_add(
+		m_cache_allocator_stats.huge_page_bytes, std::memory_order_relaxed);
+	m_gstate->m_cache_chunk_allocations.fetch_add(
+		m_cache_allocator_stats.chunk_allocations, std::memory_order_relaxed);
+	m_gstate->m_cache_chunk_reuses.fetch_add(
+		m_cache_allocator_stats.chunk_reuses, std::memory_order_relaxed);
+	m_gstate->m_minor_page_faults.fetch_add(m_local_minor_page_faults, std::memory_order_relaxed);
+	m_gstate->m_major_page_faults.fetch_add(m_local_major_page_faults, std::memory_order_relaxed);
 	m_gstate->m_insn_cache_hash_block_bytes.fetch_add(
 		m_insn_allocator.allocated_bytes(linear_allocator::INSN_CACHE_HASH_BLOCK), std::memory_order_relaxed);
 	m_gstate->m_insn_cache_data_bytes.fetch_add(
@@ -420,6 +621,22 @@ void Evaluator::FlushCacheDiagnosticsToGlobal()
 	m_gstate->m_cache_propagation_span.fetch_add(m_local_cache_propagation_span, std::memory_order_relaxed);
 	AtomicMaxRelaxed(m_gstate->m_cache_max_propagation_span, m_local_cache_max_propagation_span);
 	m_gstate->m_cache_pmg_restarts.fetch_add(m_local_cache_pmg_restarts, std::memory_order_relaxed);
+	m_gstate->m_cache_player_free_lines.fetch_add(
+		m_local_cache_player_free_lines, std::memory_order_relaxed);
+	m_gstate->m_cache_trace_hits.fetch_add(m_local_cache_trace_hits, std::memory_order_relaxed);
+	m_gstate->m_cache_trace_inserts.fetch_add(m_local_cache_trace_inserts, std::memory_order_relaxed);
+	m_gstate->m_cache_dirty_range_evaluations.fetch_add(
+		m_local_cache_dirty_range_evaluations, std::memory_order_relaxed);
+	m_gstate->m_cache_prefix_lines.fetch_add(m_local_cache_prefix_lines, std::memory_order_relaxed);
+	m_gstate->m_cache_spliced_lines.fetch_add(m_local_cache_spliced_lines, std::memory_order_relaxed);
+	m_gstate->m_cache_bound_rejections.fetch_add(m_local_cache_bound_rejections, std::memory_order_relaxed);
+	m_gstate->m_cache_bound_skipped_lines.fetch_add(
+		m_local_cache_bound_skipped_lines, std::memory_order_relaxed);
+	m_gstate->m_cache_bound_retries.fetch_add(m_local_cache_bound_retries, std::memory_order_relaxed);
+	m_gstate->m_line_candidate_evaluations.fetch_add(
+		m_local_line_candidate_evaluations, std::memory_order_relaxed);
+	m_gstate->m_line_candidate_switches.fetch_add(
+		m_local_line_candidate_switches, std::memory_order_relaxed);
 	m_gstate->m_lru_updates.fetch_add(m_local_lru_updates, std::memory_order_relaxed);
 	m_gstate->m_lru_search_steps.fetch_add(m_local_lru_search_steps, std::memory_order_relaxed);
 
@@ -468,8 +685,9 @@ Evaluator::AcceptanceOutcome Evaluator::ApplyAcceptanceCore(double result, bool
     double drift = 0.0;
     bool drift_active = false;
     if (m_gstate->m_unstuck_drift_norm > 0.0 && m_gstate->m_unstuck_after > 0) {
-		if (m_gstate->m_evaluations > m_gstate->m_last_best_evaluation) {
-			unsigned long long plateau = m_gstate->m_evaluations - m_gstate->m_last_best_evaluation;
+		const unsigned long long clock = EvaluationClock();
+		if (clock > m_gstate->m_last_best_evaluation) {
+			unsigned long long plateau = clock - m_gstate->m_last_best_evaluation;
 			if (plateau >= m_gstate->m_unstuck_after) {
 				// Accumulate normalized drift per evaluation since threshold
 				unsigned long long evals_since_threshold = plateau - m_gstate->m_unstuck_after + 1ULL;
@@ -514,8 +732,9 @@ Evaluator::AcceptanceOutcome Evaluator::ApplyAcceptanceCore(double result, bool
 			m_gstate->m_best_result = result;  // ← CRITICAL: immediate global update for thread sync
 			m_gstate->m_current_cost = result; // ← FIX: Update current_cost for proper statistics collection
 			
-			// Update created picture and targets (original behavior)
-			if (line_results) {
+			// Update created picture and targets (original behavior). A lean
+			// cache has no rows; the coordinator renders the published program.
+			if (line_results && !m_lean_line_cache) {
 				m_gstate->m_created_picture.resize(m_height);
 				m_gstate->m_created_picture_targets.resize(m_height);
 				
@@ -643,24 +862,139 @@ Evaluator::AcceptanceOutcome Evaluator::ApplyAcceptanceCore(double result, bool
 
 double Evaluator::CalculateAcceptanceDrift()
 {
-	double drift = 0.0;
-	m_gstate->m_current_norm_drift = 0.0;
-	if (m_gstate->m_unstuck_drift_norm <= 0.0 || m_gstate->m_unstuck_after == 0)
-		return drift;
-	if (m_gstate->m_evaluations <= m_gstate->m_last_best_evaluation)
-		return drift;
+	return m_gstate->NormalizedDrift(EvaluationClock()) * m_drift_scale;
+}
+
+EvalWorkerCounters* Evaluator::WorkerCounters() const
+{
+	if (m_thread_id < 0 || static_cast<size_t>(m_thread_id) >= m_gstate->m_worker_counter_count)
+		return nullptr;
+	return &m_gstate->m_worker_counters[m_thread_id];
+}
+
+unsigned long long Evaluator::NextEvaluationNumber()
+{
+	if (m_reserved_next == m_reserved_end)
+	{
+		// Batches shrink as the run nears /max_evals, so a worker stopping
+		// there leaves only a few numbers unused.
+		const unsigned long long handedOut =
+			m_gstate->m_evaluations.load(std::memory_order_relaxed);
+		const unsigned long long remaining = m_gstate->m_max_evals > handedOut
+			? m_gstate->m_max_evals - handedOut : 0ULL;
+		const unsigned long long workers =
+			static_cast<unsigned long long>(std::max(m_gstate->m_thread_count, 1));
+		const unsigned long long batch = std::max(1ULL,
+			std::min(k_evaluation_reservation, remaining / (workers * 8ULL)));
+		if (EvalWorkerCounters* counters = WorkerCounters())
+			m_reserved_next = ReserveEvaluations(m_gstate->m_evaluations, *counters, batch);
+		else
+			m_reserved_next = m_gstate->m_evaluations.fetch_add(batch, std::memory_order_relaxed) + 1ULL;
+		m_reserved_end = m_reserved_next + batch;
+	}
+	m_evaluation_clock = m_reserved_next++;
+	if (EvalWorkerCounters* counters = WorkerCounters())
+		counters->unused_evaluations.store(m_reserved_end - m_reserved_next, std::memory_order_relaxed);
+	return m_evaluation_clock;
+}
+
+void Evaluator::ReturnUnusedEvaluations()
+{
+	const unsigned long long unused = m_reserved_end - m_reserved_next;
+	if (EvalWorkerCounters* counters = WorkerCounters())
+		ReturnEvaluations(m_gstate->m_evaluations, *counters, unused);
+	else if (unused)
+		m_gstate->m_evaluations.fetch_sub(unused, std::memory_order_relaxed);
+	m_reserved_next = m_reserved_end = 0ULL;
+}
+
+unsigned long long Evaluator::EvaluationClock() const
+{
+	return m_evaluation_clock ? m_evaluation_clock
+		: m_gstate->m_evaluations.load(std::memory_order_relaxed);
+}
+
+EvalGlobalState::IslandSlot* Evaluator::Island() const
+{
+	if (m_thread_id < 0 || static_cast<size_t>(m_thread_id) >= m_gstate->m_island_count)
+		return nullptr;
+	return &m_gstate->m_islands[m_thread_id];
+}
 
-	const unsigned long long plateau =
-		m_gstate->m_evaluations - m_gstate->m_last_best_evaluation;
-	if (plateau < m_gstate->m_unstuck_after)
-		return drift;
+void Evaluator::PublishIslandStats(unsigned long long evaluations, unsigned long long accepted,
+	unsigned long long immigrants, double currentCost, double bestCost)
+{
+	EvalGlobalState::IslandSlot* island = Island();
+	if (!island)
+		return;
+	island->evaluations.store(evaluations, std::memory_order_relaxed);
+	island->accepted.store(accepted, std::memory_order_relaxed);
+	island->immigrants.store(immigrants, std::memory_order_relaxed);
+	island->current_cost.store(currentCost, std::memory_order_relaxed);
+	island->best_cost.store(bestCost, std::memory_order_relaxed);
+}
 
-	const unsigned long long evaluationsSinceThreshold =
-		plateau - m_gstate->m_unstuck_after + 1ULL;
-	const double normalizedDrift = m_gstate->m_unstuck_drift_norm
-		* static_cast<double>(evaluationsSinceThreshold);
-	m_gstate->m_current_norm_drift = normalizedDrift;
-	return normalizedDrift * m_drift_scale;
+Evaluator::IslandMigrant Evaluator::ExchangeMigrants(const raster_picture& current, double currentCost)
+{
+	EvalGlobalState::IslandSlot* island = Island();
+	if (!island || static_cast<size_t>(m_thread_id) >= m_gstate->m_island_sources.size())
+		return IslandMigrant();
+
+	// The elite is sampled here rather than on every acceptance, so it costs
+	// one picture copy per interval at most.
+	const bool full = m_island_elite.size() >= k_island_elite;
+	if (!full || currentCost < m_island_elite.back()->cost)
+	{
+		bool duplicate = false;
+		for (const IslandMigrant& entry : m_island_elite)
+			duplicate = duplicate || entry->cost == currentCost;
+		if (!duplicate)
+		{
+			std::shared_ptr<EvalGlobalState::PublishedBestSnapshot> entry =
+				std::make_shared<EvalGlobalState::PublishedBestSnapshot>();
+			entry->picture = current;
+			entry->picture.uncache_insns();
+			entry->cost = currentCost;
+			if (full)
+				m_island_elite.pop_back();
+			auto position = std::upper_bound(m_island_elite.begin(), m_island_elite.end(), currentCost,
+				[](double cost, const IslandMigrant& other) { return cost < other->cost; });
+			m_island_elite.insert(position, std::move(entry));
+		}
+	}
+	const IslandMigrant offer = m_gstate->m_migrate_elite
+		? m_island_elite[Random(static_cast<int>(m_island_elite.size()))]
+		: m_island_elite.front();
+	std::atomic_store_explicit(&island->emigrant, offer, std::memory_order_release);
+
+	const std::vector<int>& sources = m_gstate->m_island_sources[m_thread_id];
+	if (sources.empty())
+		return IslandMigrant();
+	if (m_gstate->m_migrate_rate < 1.0
+		&& Random(1 << 20) >= static_cast<int>(m_gstate->m_migrate_rate * (1 << 20)))
+		return IslandMigrant();
+
+	IslandMigrant migrant;
+	if (m_gstate->m_island_topology == IslandTopology::Star && m_thread_id == 0)
+	{
+		// The hub gathers: the best of everything on offer.
+		for (int source : sources)
+		{
+			IslandMigrant candidate = std::atomic_load_explicit(
+				&m_gstate->m_islands[source].emigrant, std::memory_order_acquire);
+			if (candidate && (!migrant || candidate->cost < migrant->cost))
+				migrant = std::move(candidate);
+		}
+	}
+	else
+	{
+		const int source = sources[Random(static_cast<int>(sources.size()))];
+		migrant = std::atomic_load_explicit(&m_gstate->m_islands[source].emigrant,
+			std::memory_order_acquire);
+	}
+	if (!migrant || migrant->cost >= currentCost)
+		return IslandMigrant();
+	return migrant;
 }
 
 Evaluator::AcceptanceOutcome Evaluator::ApplyIslandAcceptance(
@@ -691,13 +1025,15 @@ Evaluator::AcceptanceOutcome Evaluator::ApplyIslandAcceptance(
 #define RASTA_ALWAYS_INLINE inline
 #endif
 
-RASTA_ALWAYS_INLINE e_target Evaluator::FindClosestColorRegisterDual(sprites_row_memory_t& spriterow,
+template<class Policy>
+RASTA_ALWAYS_INLINE e_target Evaluator::FindClosestColorRegisterDual(uint32_t& sprite_bits,
 	const unsigned char* other_row, unsigned picture_row_index, int x,
-	bool& restart_line, distance_t& best_error)
+	bool& restart_line, distance_t& best_error, uint32_t& pixel_mask)
 {
 	distance_t best_err = DISTANCE_MAX;
 	e_target best_reg = E_COLBAK;
-	int best_sprite_bit = 0;
+	uint32_t best_sprite_bit = 0;
+	pixel_mask = 0;
 	bool sprite_covers_colbak = false;
 	const unsigned char idx_other = other_row ? other_row[x] : 0;
 	const unsigned pix = picture_row_index + static_cast<unsigned>(x);
@@ -745,27 +1081,27 @@ RASTA_ALWAYS_INLINE e_target Evaluator::FindClosestColorRegisterDual(sprites_row
 	for (int target = E_COLPM0; target <= E_COLPM3; ++target)
 	{
 		const int sprite_pos = m_sprite_shift_regs[target - E_COLPM0];
-		const int sprite_x = sprite_pos - SpriteScreenColorCycleStart(
-			ActiveGraphicsMode(), ActivePlayfieldWidth());
+		const int sprite_x = sprite_pos - Policy::sprite_screen_start;
 		const unsigned x_offset = static_cast<unsigned>(x - sprite_x);
 		if (x_offset >= sprite_size)
 			continue;
 
-		const int sprite_bit = static_cast<int>(x_offset >> 2);
-		assert(sprite_bit >= 0 && sprite_bit < 8);
+		const uint32_t sprite_bit = SpriteRowBit(target - E_COLPM0,
+			static_cast<int>(x_offset >> 2));
 		sprite_covers_colbak = true;
-		int sprite_leftover_pixel = 0;
+		uint32_t read_bits = sprite_bit;
 		const int sprite_leftover = static_cast<int>(x_offset)
 			+ m_sprite_shift_emitted[target - E_COLPM0];
 		if (sprite_leftover < sprite_size)
 		{
 			const int sprite_leftover_bit = sprite_leftover >> 2;
 			if (sprite_leftover_bit >= 0 && sprite_leftover_bit < 8)
-				sprite_leftover_pixel = spriterow[target - E_COLPM0][sprite_leftover_bit];
+				read_bits |= SpriteRowBit(target - E_COLPM0, sprite_leftover_bit);
 		}
+		pixel_mask |= read_bits;
 
 		const distance_t distance = pair_distance(target);
-		if (spriterow[target - E_COLPM0][sprite_bit] || sprite_leftover_pixel)
+		if (sprite_bits & read_bits)
 		{
 			best_sprite_bit = sprite_bit;
 			best_reg = static_cast<e_target>(target);
@@ -840,10 +1176,10 @@ RASTA_ALWAYS_INLINE e_target Evaluator::FindClosestColorRegisterDual(sprites_row
 	}
 
 	if (best_reg >= E_COLPM0 && best_reg <= E_COLPM3
-		&& !spriterow[best_reg - E_COLPM0][best_sprite_bit])
+		&& !(sprite_bits & best_sprite_bit))
 	{
 		restart_line = true;
-		spriterow[best_reg - E_COLPM0][best_sprite_bit] = true;
+		sprite_bits |= best_sprite_bit;
 	}
 	best_error = best_err;
 	return best_reg;
@@ -851,279 +1187,6 @@ RASTA_ALWAYS_INLINE e_target Evaluator::FindClosestColorRegisterDual(sprites_row
 
 #undef RASTA_ALWAYS_INLINE
 
-distance_accum_t Evaluator::ExecuteRasterProgramDual(raster_picture *pic, const line_cache_result **results_array, const std::vector<const unsigned char*>& other_rows, bool mutateB)
-{
-	static constexpr int k_max_visible_width = 176;
-	static constexpr int k_max_hpos_events = 64;
-	const int visible_width = std::min(static_cast<int>(m_width), k_max_visible_width);
-	PmgPixelSnapshot pmg_snapshots[k_max_visible_width];
-	PmgHposEvent pmg_hpos_events[k_max_hpos_events];
-	int pmg_hpos_event_count = 0;
-
-#ifdef _DEBUG
-    assert(m_dual_paletteY && m_dual_paletteU && m_dual_paletteV);
-    assert(m_dual_pairYsum && m_dual_pairUsum && m_dual_pairVsum);
-    assert(m_dual_targetY && m_dual_targetU && m_dual_targetV);
-    assert((int)other_rows.size() == (int)m_height);
-#endif
-	// Shared PMG helpers inspect the active picture. Dual candidates are often
-	// moved or destroyed immediately after evaluation, so never retain this
-	// non-owning pointer beyond the call.
-	ActiveRasterPictureScope activePicture(m_active_raster_picture, pic);
-    // Ensure dual cache storage exists
-    if ((int)m_line_caches_dual.size() != (int)m_height) {
-        m_line_caches_dual.clear();
-        m_line_caches_dual.resize(m_height);
-    }
-
-    // Snapshot generation counter of the OTHER frame (for cache invalidation)
-    m_dual_gen_other_snapshot = mutateB ? m_gstate->m_dual_generation_A.load(std::memory_order_acquire)
-                                        : m_gstate->m_dual_generation_B.load(std::memory_order_acquire);
-    if (m_dual_last_other_generation != m_dual_gen_other_snapshot) {
-		ClearLineCacheGeneration();
-        m_dual_last_other_generation = m_dual_gen_other_snapshot;
-    }
-
-    DBG_PRINT("[EVAL] ExecuteRasterProgramDual enter: pic=%p h=%u w=%u", (void*)pic, m_height, m_width);
-    // Memory guard similar to single-run to prevent unbounded growth
-    if (m_cache_allocator_stats.resident_bytes > m_cache_size) {
-        std::unique_lock<std::mutex> cache_lock(m_gstate->m_cache_mutex);
-        if (m_cache_allocator_stats.resident_bytes > m_cache_size) {
-			ClearLineCacheGeneration();
-			++m_cache_partial_clears;
-			if (m_insn_allocator.size() > m_cache_size / k_instruction_cache_budget_divisor) {
-                ++m_cache_full_clears;
-                m_insn_seq_cache.clear();
-                m_insn_allocator.clear();
-				++m_allocator_epoch;
-				if (pic) {
-					const size_t lines = pic->raster_lines.size();
-					for (size_t i = 0; i < lines; ++i) pic->raster_lines[i].cache_key = NULL;
-				}
-				ClearLineActivity();
-            }
-        }
-    }
-    int x,y; // currently processed pixel
-    int cycle;
-    int next_instr_offset;
-    int ip; // instruction pointer
-    const SRasterInstruction *__restrict instr;
-
-    m_reg_a=0; m_reg_x=0; m_reg_y=0;
-    if (m_onoff) TurnOffRegisters(pic);
-    memset(m_sprite_shift_regs,0,sizeof(m_sprite_shift_regs));
-    memcpy(m_mem_regs,pic->mem_regs_init,sizeof(pic->mem_regs_init));
-    memset(m_sprites_memory,0,sizeof(m_sprites_memory));
-
-    bool restart_line=false;
-    bool shift_start_array_dirty = true;
-    distance_accum_t total_error = 0;
-
-    unsigned recomputedLines = 0;
-    int firstMissLine = -1;
-    int lastMissLine = -1;
-    for (y=0; y<(int)m_height; ++y)
-    {
-		pmg_hpos_event_count = 0;
-        const unsigned char* __restrict other_row = other_rows[y];
-		StoreLineRegs();
-
-        raster_line& rline = pic->raster_lines[y];
-        line_cache_key lck; CaptureRegisterState(lck.entry_state);
-        // Ensure instruction sequence pointer is valid before hashing/lookup
-        if (!rline.cache_key) { rline.recache_insns(m_insn_seq_cache, m_insn_allocator); }
-        lck.insn_seq = rline.cache_key;
-        const uint32_t lck_hash = lck.hash();
-
-        unsigned char * __restrict created_picture_row = &m_created_picture[y][0];
-        unsigned char * __restrict created_picture_targets_row = &m_created_picture_targets[y][0];
-
-        // Try dual cache first (separate from single-frame cache)
-        unsigned lookupProbes = 0;
-        const line_cache_result* cached_line_result = m_line_caches_dual[y].find(lck, lck_hash, &lookupProbes);
-        ++m_local_cache_lookups;
-        m_local_cache_lookup_probes += lookupProbes;
-        m_local_cache_max_lookup_probes = std::max(
-            m_local_cache_max_lookup_probes, static_cast<unsigned long long>(lookupProbes));
-        if (cached_line_result)
-        {
-            ++m_local_cache_hits;
-            ++m_local_cache_hits_by_line[y];
-            results_array[y] = cached_line_result;
-            ApplyRegisterState(cached_line_result->new_state);
-            memcpy(m_sprites_memory[y], cached_line_result->sprite_data, sizeof m_sprites_memory[y]);
-            shift_start_array_dirty = true;
-            UpdateLRU(y);
-            total_error += cached_line_result->line_error;
-            continue;
-        }
-
-        ++m_local_cache_misses;
-        ++m_local_cache_misses_by_line[y];
-        ++recomputedLines;
-        if (firstMissLine < 0) firstMissLine = y;
-        lastMissLine = y;
-
-        if (shift_start_array_dirty) { shift_start_array_dirty = false; ResetSpriteShiftStartArray(); }
-
-        const int rastinsncnt = (int)rline.instructions.size();
-        const SRasterInstruction *__restrict rastinsns = rastinsncnt ? &rline.instructions[0] : nullptr;
-
-        restart_line=false; ip=0; cycle=0;
-		next_instr_offset = rastinsncnt
-			? RasterInstructionCompletionOffset(
-				screen_cycles, cycle, rastinsns[ip], false)
-			: 1000;
-        memset(m_sprite_shift_regs,0,sizeof(m_sprite_shift_regs));
-
-        const int picture_row_index = m_width * y;
-        distance_accum_t total_line_error = 0;
-        sprites_row_memory_t& spriterow = m_sprites_memory[y];
-
-        for (x = -SpriteScreenColorCycleStart(
-				ActiveGraphicsMode(), ActivePlayfieldWidth());
-			x < static_cast<int>(m_width) + 16; ++x)
-        {
-            const int sprite_check_x = x + SpriteScreenColorCycleStart(
-				ActiveGraphicsMode(), ActivePlayfieldWidth());
-            const unsigned char sprite_start_mask = m_sprite_shift_start_array[sprite_check_x];
-            if (sprite_start_mask)
-            {
-                if (sprite_start_mask & 1) StartSpriteShift(E_HPOSP0);
-                if (sprite_start_mask & 2) StartSpriteShift(E_HPOSP1);
-                if (sprite_start_mask & 4) StartSpriteShift(E_HPOSP2);
-                if (sprite_start_mask & 8) StartSpriteShift(E_HPOSP3);
-            }
-
-            while(next_instr_offset<x && ip<rastinsncnt)
-            {
-                instr = &rastinsns[ip++];
-				const unsigned hpos_index =
-					static_cast<unsigned>(instr->loose.target - E_HPOSP0);
-				if (hpos_index < 4)
-				{
-					const int new_x = StoredRegisterValue(
-						*instr, m_reg_a, m_reg_x, m_reg_y);
-					const int old_x = m_mem_regs[instr->loose.target];
-					const int visible_left = SpriteScreenColorCycleStart(
-						ActiveGraphicsMode(), ActivePlayfieldWidth()) - sprite_size;
-					const int visible_right = SpriteScreenColorCycleStart(
-						ActiveGraphicsMode(), ActivePlayfieldWidth()) + m_width - 1;
-					if (new_x >= 0 && old_x != new_x
-						&& new_x >= visible_left && new_x <= visible_right)
-					{
-						assert(pmg_hpos_event_count < k_max_hpos_events);
-						PmgHposEvent& event = pmg_hpos_events[pmg_hpos_event_count++];
-						event.sprite = static_cast<unsigned char>(hpos_index);
-						event.old_x = old_x;
-						event.new_x = new_x;
-						event.check_x = sprite_check_x;
-					}
-				}
-                ExecuteInstruction(*instr, sprite_check_x, spriterow, total_line_error);
-                cycle+=GetInstructionCycles(*instr);
-                next_instr_offset = ip < rastinsncnt
-					? RasterInstructionCompletionOffset(
-						screen_cycles, cycle, rastinsns[ip], false)
-					: 1000;
-            }
-
-            if ((unsigned)x < (unsigned)m_width)
-            {
-				PmgPixelSnapshot& snapshot = pmg_snapshots[x];
-				memcpy(snapshot.color_regs, m_mem_regs, sizeof snapshot.color_regs);
-				memcpy(snapshot.shift_regs, m_sprite_shift_regs, sizeof snapshot.shift_regs);
-				memcpy(snapshot.shift_emitted, m_sprite_shift_emitted, sizeof snapshot.shift_emitted);
-
-				distance_t closest_dist;
-				const e_target closest_register = FindClosestColorRegisterDual(
-					spriterow, other_row, static_cast<unsigned>(picture_row_index),
-					x, restart_line, closest_dist);
-				total_line_error += closest_dist;
-				created_picture_row[x] = m_mem_regs[closest_register] >> 1;
-				created_picture_targets_row[x] = closest_register;
-            }
-        }
-
-		if (restart_line)
-		{
-			++m_local_cache_pmg_restarts;
-			register_state outgoing_state;
-			CaptureRegisterState(outgoing_state);
-			bool added_bits;
-			do
-			{
-				added_bits = false;
-				total_line_error = 0;
-				for (x = 0; x < visible_width; ++x)
-				{
-					const PmgPixelSnapshot& snapshot = pmg_snapshots[x];
-					memcpy(m_mem_regs, snapshot.color_regs, sizeof snapshot.color_regs);
-					memcpy(m_sprite_shift_regs, snapshot.shift_regs, sizeof snapshot.shift_regs);
-					memcpy(m_sprite_shift_emitted, snapshot.shift_emitted, sizeof snapshot.shift_emitted);
-
-					bool added_bit = false;
-					distance_t closest_dist;
-					const e_target closest_register = FindClosestColorRegisterDual(
-						spriterow, other_row, static_cast<unsigned>(picture_row_index),
-						x, added_bit, closest_dist);
-					added_bits = added_bits || added_bit;
-					total_line_error += closest_dist;
-					created_picture_row[x] = m_mem_regs[closest_register] >> 1;
-					created_picture_targets_row[x] = closest_register;
-				}
-				if (added_bits)
-					++m_local_cache_pmg_restarts;
-			} while (added_bits);
-
-			for (int event_index = 0; event_index < pmg_hpos_event_count; ++event_index)
-			{
-				const PmgHposEvent& event = pmg_hpos_events[event_index];
-				bool sprite_has_data = false;
-				for (int bit = 7; bit >= 0; --bit)
-				{
-					if (spriterow[event.sprite][bit])
-					{
-						sprite_has_data = true;
-						break;
-					}
-				}
-				if (!sprite_has_data)
-					continue;
-				if (event.old_x - event.check_x <= 6 && event.old_x - event.check_x > 0)
-					total_line_error += 100000;
-				if (event.new_x - event.check_x <= 6 && event.new_x - event.check_x > 0)
-					total_line_error += 100000;
-			}
-			ApplyRegisterState(outgoing_state);
-			restart_line = false;
-		}
-
-		total_error += total_line_error;
-		bool allocatedBlock = false;
-		line_cache_result& result_state = m_line_caches_dual[y].insert(
-			lck, lck_hash, m_line_allocator, &allocatedBlock);
-		++m_local_cache_inserts;
-		if (allocatedBlock) ++m_local_cache_hash_blocks;
-		UpdateLRU(y);
-		result_state.line_error = total_line_error;
-		CaptureRegisterState(result_state.new_state);
-		result_state.color_row = (unsigned char *)m_line_allocator.allocate(
-			m_width, linear_allocator::LINE_CACHE_COLOR_ROW);
-		memcpy(result_state.color_row, created_picture_row, m_width);
-		const size_t targetBytes = line_cache_result::packed_target_bytes(m_width);
-		result_state.packed_target_row = (unsigned char *)m_line_allocator.allocate(
-			targetBytes, linear_allocator::LINE_CACHE_TARGET_ROW);
-		line_cache_result::pack_target_row(
-			result_state.packed_target_row, created_picture_targets_row, m_width);
-		memcpy(result_state.sprite_data, m_sprites_memory[y], sizeof result_state.sprite_data);
-		results_array[y] = &result_state;
-    }
-    RecordCacheEvaluation(recomputedLines, firstMissLine, lastMissLine);
-    return total_error;
-}
-
 #if RASTA_TRACK_LINE_LRU
 void Evaluator::UpdateLRU(int line_index) {
 	++m_local_lru_updates;
@@ -1153,10 +1216,25 @@ void Evaluator::ClearLineCacheGeneration()
 		cache.clear();
 	for (auto& cache : m_line_caches_dual)
 		cache.clear();
-	m_line_allocator.clear();
+	m_line_slots.clear();
+	m_pinned_line_slots.assign(m_height, line_cache_slots::NONE);
+	ClearLineTraces();
+	++m_line_cache_generation;
 	ClearLineActivity();
 }
 
+// Traces are only replayed within the render that finds them, so they can go
+// without invalidating any line result.
+void Evaluator::ClearLineTraces()
+{
+	if (m_line_trace_allocator.size() == 0)
+		return;
+	++m_cache_trace_clears;
+	for (auto& cache : m_line_trace_caches)
+		cache.clear();
+	m_line_trace_allocator.clear();
+}
+
 void Evaluator::RecachePicture(raster_picture* pic, bool force)
 {
     if (!pic) return;
@@ -1180,14 +1258,15 @@ int Evaluator::SelectMutation()
     // Cache stuck state with TTL to avoid repeated recompute
     bool stuck = false;
     if (m_gstate) {
-        if (m_gstate->m_evaluations >= m_stuck_valid_until_eval) {
+        const unsigned long long clock = EvaluationClock();
+        if (clock >= m_stuck_valid_until_eval) {
             unsigned long long thr = m_gstate->m_unstuck_after;
-            if (thr > 0 && m_gstate->m_evaluations > m_gstate->m_last_best_evaluation) {
-                m_cached_stuck = (m_gstate->m_evaluations - m_gstate->m_last_best_evaluation) >= thr;
+            if (thr > 0 && clock > m_gstate->m_last_best_evaluation) {
+                m_cached_stuck = (clock - m_gstate->m_last_best_evaluation) >= thr;
             } else {
                 m_cached_stuck = false;
             }
-            m_stuck_valid_until_eval = m_gstate->m_evaluations + k_stuck_ttl_evals;
+            m_stuck_valid_until_eval = clock + k_stuck_ttl_evals;
         }
         stuck = m_cached_stuck;
     }
@@ -1195,7 +1274,7 @@ int Evaluator::SelectMutation()
     // Recompute weights rarely when not stuck; recompute immediately when stuck
     // Detect dual availability for gating
     bool dual_ok_now = (m_dual_pairYsum || m_dual_pairYsum8) && m_dual_mutation_other_rows != nullptr;
-    bool need_recompute = (m_cached_total_weight <= 0.0) || stuck || (m_gstate && m_gstate->m_evaluations >= m_weights_valid_until_eval) || (dual_ok_now != m_last_dual_ok);
+    bool need_recompute = (m_cached_total_weight <= 0.0) || stuck || (m_gstate && EvaluationClock() >= m_weights_valid_until_eval) || (dual_ok_now != m_last_dual_ok);
     if (need_recompute) {
         m_cached_total_weight = 0.0;
         for (int i = 0; i < active_mutations; i++) {
@@ -1230,9 +1309,9 @@ int Evaluator::SelectMutation()
         }
         // set TTL only in not-stuck mode to amortize cost and record dual gate state
         if (m_gstate && !stuck) {
-            m_weights_valid_until_eval = m_gstate->m_evaluations + k_weights_ttl_evals;
+            m_weights_valid_until_eval = EvaluationClock() + k_weights_ttl_evals;
         } else {
-			m_weights_valid_until_eval = m_gstate ? m_gstate->m_evaluations.load(std::memory_order_relaxed) : 0ULL;
+			m_weights_valid_until_eval = m_gstate ? EvaluationClock() : 0ULL;
         }
         m_last_dual_ok = dual_ok_now;
     }
@@ -1262,6 +1341,8 @@ void Evaluator::Init(unsigned width, unsigned height, const distance_t* const* e
 	m_width = width;
 	m_height = height;
 	m_picture_all_errors = errmap;
+	m_line_error_floor.clear();
+	m_line_facts.clear();
 	const char* dualNeon = std::getenv("RASTA_DUAL_NEON");
 #if RASTA_HAS_ARM_NEON
 	m_use_dual_neon = dualNeon == nullptr
@@ -1277,8 +1358,20 @@ void Evaluator::Init(unsigned width, unsigned height, const distance_t* const* e
 	m_solutions = solutions;
 	m_cache_size = cache_size;
 	m_thread_id = thread_id;
+	m_line_trace_allocator = linear_allocator(std::min<size_t>(linear_allocator::BLOCK_SIZE,
+		std::max<size_t>(cache_size / k_trace_cache_budget_divisor / 4, 65536)),
+		&m_cache_allocator_stats);
+	ConfigureLineSlots();
+	m_row_results.clear();
 	m_allocation_line_weights = allocation_line_weights != nullptr
 		? *allocation_line_weights : std::vector<double>();
+	{
+		std::vector<double> allocationWeights(m_allocation_line_weights.size());
+		for (size_t y = 0; y < allocationWeights.size(); ++y)
+			allocationWeights[y] = std::max(0.0, m_allocation_line_weights[y]);
+		m_allocation_tree.Assign(allocationWeights);
+	}
+	m_line_headroom.Clear();
 	m_allocation_global_period = std::max(2U, allocation_global_period);
 	m_primary_mutation_count = 0;
 	if (scoring_picture != nullptr)
@@ -1319,59 +1412,246 @@ distance_accum_t Evaluator::EvaluateSingle(raster_picture* pic,
 	return ExecuteRasterProgram(pic, line_results);
 }
 
-distance_accum_t Evaluator::EvaluateUnweightedSource(raster_picture* pic)
+distance_accum_t Evaluator::EvaluateWithRows(raster_picture* pic,
+	const line_cache_result** line_results)
 {
-	if (!m_visual_objective.IsInitialized() || pic == nullptr)
-		return 0;
-	std::vector<const line_cache_result*> lineResults(m_height, nullptr);
-	RecachePicture(pic, true);
-	ExecuteRasterProgram(pic, lineResults.data());
-	std::vector<const unsigned char*> rows(m_height, nullptr);
-	for (unsigned y = 0; y < m_height; ++y)
-		rows[y] = lineResults[y]->color_row;
-	return m_visual_objective.DirectMeanScore(rows.data());
+	if (!m_lean_line_cache)
+		return EvaluateSingle(pic, line_results);
+	const size_t colorBytes = m_width;
+	const size_t rowBytes = colorBytes + line_cache_result::packed_target_bytes(m_width);
+	if (m_row_results.size() != m_height)
+	{
+		m_row_results.assign(m_height, line_cache_result());
+		m_row_storage.assign(rowBytes * m_height, 0);
+		for (unsigned y = 0; y < m_height; ++y)
+		{
+			m_row_results[y].color_row = &m_row_storage[rowBytes * y];
+			m_row_results[y].packed_target_row = &m_row_storage[rowBytes * y + colorBytes];
+			m_row_results[y].slot = line_cache_slots::NONE;
+		}
+	}
+	m_render_rows = true;
+	const distance_accum_t error = ExecuteRasterProgram(pic, line_results);
+	m_render_rows = false;
+	return error;
 }
 
-Evaluator::StructuredWindowComparison Evaluator::CompareStructuredWindow(
-	const raster_picture& baseline,
-	size_t first_line,
-	const std::vector<raster_line>& structured_lines)
+void Evaluator::SetLeanLineCache(bool lean)
 {
-	StructuredWindowComparison comparison;
-	if (baseline.raster_lines.size() != m_height
-		|| structured_lines.empty())
-		return comparison;
-	StructuredWindowResult window;
-	window.feasible = true;
-	window.lines = structured_lines;
-	raster_picture candidate;
-	if (!BuildStructuredWindowComparisonCandidate(
-		baseline, first_line, window, candidate))
-		return comparison;
+	if (m_lean_line_cache == lean)
+		return;
+	m_lean_line_cache = lean;
+	ConfigureLineSlots();
+}
 
-	raster_picture baseline_copy = baseline;
-	std::vector<const line_cache_result*> baseline_results(m_height, nullptr);
-	std::vector<const line_cache_result*> candidate_results(m_height, nullptr);
-	comparison.baseline_score = EvaluateSingle(
-		&baseline_copy, baseline_results.data());
-	comparison.structured_score = EvaluateSingle(
-		&candidate, candidate_results.data());
-	comparison.feasible = true;
-	return comparison;
+void Evaluator::ConfigureLineSlots()
+{
+	// Line results get what the instruction and trace budgets leave,
+	// carved in slabs small enough to fill it closely.
+	const size_t slotLimit = m_cache_size - m_cache_size / k_instruction_cache_budget_divisor
+		- m_cache_size / k_trace_cache_budget_divisor;
+	const size_t slabSize = std::min<size_t>(linear_allocator::BLOCK_SIZE,
+		std::max<size_t>(slotLimit / 8, 65536));
+	m_line_slots.configure(
+		std::max(sizeof(line_cache::value_type),
+			sizeof(std::pair<antic4_line_cache_key, line_cache_result>)),
+		m_lean_line_cache ? 0 : m_width, slotLimit, slabSize, &m_cache_allocator_stats);
+	ClearLineCacheGeneration();
 }
 
-Evaluator::StructuredWindowComparison Evaluator::CompareStructuredSourceWindow(
-	const raster_picture& baseline,
-	size_t first_line,
-	size_t line_count,
-	size_t alternate_count,
-	const StructuredBeamOptions& options)
+distance_accum_t Evaluator::EvaluateTransaction(raster_picture* pic,
+	const line_cache_result** line_results,
+	const RasterMutationTransaction& transaction,
+	AcceptedLineResults& accepted,
+	double rejection_limit)
+{
+	accepted.rejection_limit = rejection_limit;
+	accepted.stopped_early = false;
+	return ExecuteRasterProgram(pic, line_results, &transaction, &accepted);
+}
+
+distance_accum_t Evaluator::EvaluateLineWindow(raster_picture* pic,
+	const line_cache_result** line_results,
+	const RasterMutationTransaction& transaction,
+	AcceptedLineResults& accepted, int end_line)
+{
+	accepted.rejection_limit = DBL_MAX;
+	accepted.stopped_early = false;
+	accepted.render_end = end_line;
+	const distance_accum_t error = ExecuteRasterProgram(pic, line_results, &transaction, &accepted);
+	accepted.render_end = INT_MAX;
+	RejectLineResults(accepted, line_results);
+	return error;
+}
+
+void Evaluator::AcceptLineResults(AcceptedLineResults& accepted, distance_accum_t total_error,
+	const line_cache_result* const* line_results, GraphicsMode mode)
+{
+	// After a dirty-range render only the replaced lines differ from the
+	// previously accepted picture.
+	const bool window = accepted.valid
+		&& accepted.cache_generation == m_line_cache_generation
+		&& accepted.prefix_error.size() == m_height + 1
+		&& m_line_headroom.Size() == m_height;
+	const int first = window ? accepted.replaced_first : 0;
+	const int last = window
+		? first + static_cast<int>(accepted.replaced.size()) : static_cast<int>(m_height);
+
+	accepted.valid = true;
+	accepted.cache_generation = m_line_cache_generation;
+	accepted.total_error = total_error;
+	accepted.prefix_error.resize(m_height + 1);
+	accepted.prefix_error[0] = 0;
+	for (unsigned y = first; y < m_height; ++y)
+		accepted.prefix_error[y + 1] = accepted.prefix_error[y] + line_results[y]->line_error;
+	accepted.replaced.clear();
+	for (int y = first; y < last; ++y)
+	{
+		const uint32_t slot = line_results[y]->slot;
+		if (m_pinned_line_slots[y] == slot)
+			continue;
+		if (m_pinned_line_slots[y] != line_cache_slots::NONE)
+			m_line_slots.unpin(m_pinned_line_slots[y]);
+		m_line_slots.pin(slot);
+		m_pinned_line_slots[y] = slot;
+		PublishSharedLine(y, slot, mode);
+	}
+
+	const distance_accum_t* floor = LineErrorFloor();
+	auto headroom = [&](int y) -> unsigned long long
+	{
+		const distance_accum_t excess = line_results[y]->line_error - (floor[y] - floor[y + 1]);
+		return excess > 0 ? static_cast<unsigned long long>(excess) : 0ULL;
+	};
+	if (window)
+	{
+		for (int y = first; y < last; ++y)
+			m_line_headroom.Set(y, headroom(y));
+	}
+	else
+	{
+		std::vector<unsigned long long> weights(m_height);
+		for (int y = 0; y < static_cast<int>(m_height); ++y)
+			weights[y] = headroom(y);
+		m_line_headroom.Assign(weights);
+	}
+}
+
+void Evaluator::PublishSharedLine(int y, uint32_t slot, GraphicsMode mode)
+{
+	if (!m_gstate || !m_gstate->m_shared_line_cache.enabled()
+		|| m_thread_id < 0 || m_thread_id >= static_cast<int>(m_gstate->m_shared_line_cache.shards()))
+		return;
+	shared_line_cache& shared_lines = m_gstate->m_shared_line_cache;
+	const line_cache_key* key;
+	uint64_t attributeRow = 0;
+	const line_cache_result* result;
+	if (mode == GraphicsMode::Antic4)
+	{
+		const auto* value = static_cast<const std::pair<antic4_line_cache_key, line_cache_result>*>(
+			m_line_slots.value(slot));
+		key = &value->first;
+		attributeRow = value->first.attribute_row;
+		result = &value->second;
+	}
+	else
+	{
+		const auto* value = static_cast<const line_cache::value_type*>(m_line_slots.value(slot));
+		key = &value->first;
+		result = &value->second;
+	}
+	const uint32_t hash = shared_line_cache::hash(*key, attributeRow);
+	if (shared_lines.publish(static_cast<unsigned>(m_thread_id), y, *key, attributeRow, hash, *result))
+		++m_local_shared_cache_publishes;
+	else
+		++m_local_shared_cache_rejected_publishes;
+}
+
+const distance_accum_t* Evaluator::LineErrorFloor()
+{
+	if (m_line_error_floor.size() != m_height + 1)
+	{
+		m_line_error_floor.assign(m_height + 1, 0);
+		for (int y = static_cast<int>(m_height) - 1; y >= 0; --y)
+		{
+			distance_accum_t line_floor = 0;
+			for (int x = 0; x < static_cast<int>(m_width); ++x)
+			{
+				const int index = y * static_cast<int>(m_width) + x;
+				distance_t best = DISTANCE_MAX;
+				for (int color = 0; color < 128; ++color)
+					best = std::min(best, PixelError(color, index, x, y));
+				line_floor += best;
+			}
+			m_line_error_floor[y] = m_line_error_floor[y + 1] + line_floor;
+		}
+	}
+	return m_line_error_floor.data();
+}
+
+void Evaluator::RejectLineResults(AcceptedLineResults& accepted,
+	const line_cache_result** line_results)
+{
+	if (!accepted.valid)
+		return;
+	std::copy(accepted.replaced.begin(), accepted.replaced.end(),
+		line_results + accepted.replaced_first);
+	accepted.replaced.clear();
+}
+
+distance_accum_t Evaluator::EvaluateUnweightedSource(raster_picture* pic)
+{
+	if (!m_visual_objective.IsInitialized() || pic == nullptr)
+		return 0;
+	std::vector<const line_cache_result*> lineResults(m_height, nullptr);
+	RecachePicture(pic, true);
+	EvaluateWithRows(pic, lineResults.data());
+	std::vector<const unsigned char*> rows(m_height, nullptr);
+	for (unsigned y = 0; y < m_height; ++y)
+		rows[y] = lineResults[y]->color_row;
+	return m_visual_objective.DirectMeanScore(rows.data());
+}
+
+Evaluator::StructuredWindowComparison Evaluator::CompareStructuredWindow(
+	const raster_picture& baseline,
+	size_t first_line,
+	const std::vector<raster_line>& structured_lines)
+{
+	StructuredWindowComparison comparison;
+	if (baseline.raster_lines.size() != m_height
+		|| structured_lines.empty())
+		return comparison;
+	StructuredWindowResult window;
+	window.feasible = true;
+	window.lines = structured_lines;
+	raster_picture candidate;
+	if (!BuildStructuredWindowComparisonCandidate(
+		baseline, first_line, window, candidate))
+		return comparison;
+
+	raster_picture baseline_copy = baseline;
+	std::vector<const line_cache_result*> baseline_results(m_height, nullptr);
+	std::vector<const line_cache_result*> candidate_results(m_height, nullptr);
+	comparison.baseline_score = EvaluateSingle(
+		&baseline_copy, baseline_results.data());
+	comparison.structured_score = EvaluateSingle(
+		&candidate, candidate_results.data());
+	comparison.feasible = true;
+	return comparison;
+}
+
+Evaluator::StructuredWindowComparison Evaluator::CompareStructuredSourceWindow(
+	const raster_picture& baseline,
+	size_t first_line,
+	size_t line_count,
+	size_t alternate_count,
+	const StructuredBeamOptions& options)
 {
 	if (baseline.raster_lines.size() != m_height)
 		return {};
 	raster_picture target_picture = baseline;
 	std::vector<const line_cache_result*> target_results(m_height, nullptr);
-	EvaluateSingle(&target_picture, target_results.data());
+	EvaluateWithRows(&target_picture, target_results.data());
 	const std::vector<line_target> target_rows = m_created_picture_targets;
 	std::vector<const unsigned char*> target_row_pointers(m_height, nullptr);
 	for (std::size_t line = 0; line < target_rows.size(); ++line)
@@ -1397,7 +1677,7 @@ Evaluator::StructuredWindowComparison Evaluator::ApplyStructuredSourceWindowIfBe
 		return comparison;
 
 	std::vector<const line_cache_result*> baseline_results(m_height, nullptr);
-	comparison.baseline_score = EvaluateSingle(&baseline, baseline_results.data());
+	comparison.baseline_score = EvaluateWithRows(&baseline, baseline_results.data());
 	std::vector<const unsigned char*> baseline_color_rows(m_height, nullptr);
 	for (std::size_t line = 0; line < baseline_results.size(); ++line)
 		baseline_color_rows[line] = baseline_results[line]->color_row;
@@ -1419,7 +1699,7 @@ Evaluator::StructuredWindowComparison Evaluator::ApplyStructuredSourceWindowIfBe
 		return comparison;
 
 	std::vector<const line_cache_result*> candidate_results(m_height, nullptr);
-	comparison.structured_score = EvaluateSingle(
+	comparison.structured_score = EvaluateWithRows(
 		&candidate, candidate_results.data());
 	std::vector<const unsigned char*> candidate_color_rows(m_height, nullptr);
 	for (std::size_t line = 0; line < candidate_results.size(); ++line)
@@ -1465,7 +1745,7 @@ Evaluator::DualStructuredWindowComparison Evaluator::CompareDualStructuredWindow
 		std::vector<color_index_line>& rows,
 		std::vector<const unsigned char*>& pointers) {
 		std::vector<const line_cache_result*> results(m_height, nullptr);
-		ExecuteRasterProgram(&picture, results.data());
+		EvaluateWithRows(&picture, results.data());
 		rows.resize(m_height);
 		pointers.resize(m_height);
 		for (size_t line = 0; line < m_height; ++line)
@@ -1568,7 +1848,14 @@ void Evaluator::ClearAllCaches()
 	// (e.g., bootstrap uses single-frame/quantized target, alternating uses dual/original input target)
 	m_line_caches.clear();
 	m_line_caches_dual.clear();
-	m_line_allocator.clear();
+	m_line_trace_caches.clear();
+	m_line_trace_allocator.clear();
+	m_line_slots.clear();
+	m_pinned_line_slots.assign(m_height, line_cache_slots::NONE);
+	++m_line_cache_generation;
+	// Retargeting rewrites the error planes in place before clearing.
+	m_line_error_floor.clear();
+	m_line_headroom.Clear();
 	m_insn_seq_cache.clear();
 	m_insn_allocator.clear();
 	++m_allocator_epoch;
@@ -1576,10 +1863,10 @@ void Evaluator::ClearAllCaches()
 	// Reset dual cache generation tracking
 	m_dual_last_other_generation = 0ULL;
 	m_dual_gen_other_snapshot = 0ULL;
-	// Resize caches to proper size (will be populated on first use)
+	// Tables are empty until a line is first cached; dual tables are only
+	// created by dual runs.
 	// Note: m_height is guaranteed to be initialized (set in Init() before bootstrap)
 	m_line_caches.resize(m_height);
-	m_line_caches_dual.resize(m_height);
 }
 
 void Evaluator::InvalidateDualCache()
@@ -1598,6 +1885,12 @@ void Evaluator::Start()
 }
 
 void Evaluator::Run() {
+	// Pinned first, so the caches and arenas this thread grows are placed on
+	// its node.
+	if (m_placement_cpu >= 0)
+		PinCurrentThread(m_placement_cpu);
+	unsigned long long minorFaultsAtStart, majorFaultsAtStart;
+	ThreadPageFaults(minorFaultsAtStart, majorFaultsAtStart);
 	const std::shared_ptr<const EvalGlobalState::PublishedBestSnapshot> initialSnapshot =
 		std::atomic_load_explicit(&m_gstate->m_best_snapshot, std::memory_order_acquire);
 	m_best_pic = initialSnapshot ? initialSnapshot->picture : m_gstate->m_best_pic;
@@ -1642,6 +1935,28 @@ void Evaluator::Run() {
 	unsigned long long localUndoLineSnapshots = 0;
 	unsigned long long localUndoRestores = 0;
 	RasterMutationTransaction mutationTransaction;
+	AcceptedLineResults acceptedResults;
+	double islandBestCost = islandState.initialized ? islandState.currentCost : DBL_MAX;
+
+	// Replaces the current solution with a migrant and restarts the
+	// acceptance history from its cost.
+	auto adoptMigrant = [&](const EvalGlobalState::PublishedBestSnapshot& migrant) {
+		const auto copyStart = std::chrono::steady_clock::now();
+		const raster_patch_stats patchStats = patch_raster_picture(
+			currentPicture, migrant.picture);
+		currentPicture.recache_missing_insns(m_insn_seq_cache, m_insn_allocator);
+		acceptedResults.valid = false;
+		localMigrationCopyNs += static_cast<unsigned long long>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - copyStart).count());
+		++localMigrationCopyEvents;
+		localMigrationLinesCopied += patchStats.copied_lines;
+		localMigrationLinesReused += patchStats.reused_lines;
+		++localMigrations;
+		islandState.Initialize(migrant.cost,
+			static_cast<std::size_t>(std::max(m_solutions, 1)));
+		islandBestCost = std::min(islandBestCost, migrant.cost);
+	};
 
 	for (;;) {
 		if (m_gstate->m_pause_requested.load(std::memory_order_acquire)) {
@@ -1663,9 +1978,12 @@ void Evaluator::Run() {
 				currentPicture = m_best_pic;
 				m_best_pic.recache_insns(m_insn_seq_cache, m_insn_allocator);
 				currentPicture.recache_insns(m_insn_seq_cache, m_insn_allocator);
+				acceptedResults.valid = false;
 				islandState.Initialize(
 					m_gstate->m_best_result.load(std::memory_order_acquire),
 					static_cast<std::size_t>(std::max(m_solutions, 1)));
+				islandBestCost = islandState.currentCost;
+				m_island_elite.clear();
 				observedBestVersion =
 					m_gstate->m_best_state_version.load(std::memory_order_acquire);
 				observedObjectiveGeneration = generation;
@@ -1679,10 +1997,14 @@ void Evaluator::Run() {
 
 			// Check again after acquiring the lock (another thread might have cleared)
 			if (m_cache_allocator_stats.resident_bytes > m_cache_size) {
-				ClearLineCacheGeneration();
-				++m_cache_partial_clears;
-				if (m_insn_allocator.size() > m_cache_size / k_instruction_cache_budget_divisor) {
-					++m_cache_full_clears;
+				// Line results are recycled in place at their share of the
+				// budget; only traces and interned sequences can overrun it.
+				if (m_line_trace_allocator.size() > m_cache_size / k_trace_cache_budget_divisor)
+					ClearLineTraces();
+				if (m_insn_allocator.size() + m_insn_seq_cache.table_bytes()
+					> m_cache_size / k_instruction_cache_budget_divisor) {
+					++m_cache_budget_resets;
+					ClearLineCacheGeneration();
 					m_insn_seq_cache.clear();
 					m_insn_allocator.clear();
 					++m_allocator_epoch;
@@ -1691,10 +2013,30 @@ void Evaluator::Run() {
 					if (m_gstate->m_optimizer != EvalGlobalState::OPT_LEGACY)
 						currentPicture.recache_insns(m_insn_seq_cache, m_insn_allocator);
 				}
+				else if (m_cache_allocator_stats.resident_bytes > m_cache_size) {
+					// Slots that overflowed their share for lack of anything
+					// evictable, or a budget smaller than one slab.
+					ClearLineTraces();
+					if (m_cache_allocator_stats.resident_bytes > m_cache_size) {
+						++m_cache_budget_resets;
+						ClearLineCacheGeneration();
+					}
+				}
 			}
 		}
 
-		if (m_gstate->m_optimizer != EvalGlobalState::OPT_LEGACY)
+		if (m_gstate->m_optimizer != EvalGlobalState::OPT_LEGACY
+			&& m_gstate->m_island_topology != IslandTopology::Global)
+		{
+			if (islandState.initialized && localEvaluations > 0
+				&& localEvaluations % m_gstate->m_migrate_every == 0)
+			{
+				const IslandMigrant migrant = ExchangeMigrants(currentPicture, islandState.currentCost);
+				if (migrant)
+					adoptMigrant(*migrant);
+			}
+		}
+		else if (m_gstate->m_optimizer != EvalGlobalState::OPT_LEGACY)
 		{
 			const unsigned long long publishedVersion =
 				m_gstate->m_best_state_version.load(std::memory_order_acquire);
@@ -1705,21 +2047,7 @@ void Evaluator::Run() {
 				if (publishedSnapshot && publishedSnapshot->version != observedBestVersion)
 				{
 					if (!islandState.initialized || publishedSnapshot->cost < islandState.currentCost)
-					{
-						const auto copyStart = std::chrono::steady_clock::now();
-						const raster_patch_stats patchStats = patch_raster_picture(
-							currentPicture, publishedSnapshot->picture);
-						currentPicture.recache_missing_insns(m_insn_seq_cache, m_insn_allocator);
-						localMigrationCopyNs += static_cast<unsigned long long>(
-							std::chrono::duration_cast<std::chrono::nanoseconds>(
-								std::chrono::steady_clock::now() - copyStart).count());
-						++localMigrationCopyEvents;
-						localMigrationLinesCopied += patchStats.copied_lines;
-						localMigrationLinesReused += patchStats.reused_lines;
-						++localMigrations;
-						islandState.Initialize(publishedSnapshot->cost,
-							static_cast<std::size_t>(std::max(m_solutions, 1)));
-					}
+						adoptMigrant(*publishedSnapshot);
 					observedBestVersion = publishedSnapshot->version;
 				}
 			}
@@ -1758,7 +2086,8 @@ void Evaluator::Run() {
 			// Mutate the worker's current solution directly. Only the affected
 			// line neighborhood is snapshotted so a rejection can be rolled back.
 			mutationTransaction.Begin(currentPicture, m_allocator_epoch);
-			MutateRasterProgram(&currentPicture, &mutationTransaction);
+			MutateRasterProgram(&currentPicture, &mutationTransaction,
+				line_results.data(), &acceptedResults);
 			evaluatedPicture = &currentPicture;
 			transactionalCandidate = true;
 			++localUndoCandidates;
@@ -1772,7 +2101,23 @@ void Evaluator::Run() {
 			evaluatedPicture = &new_picture;
 		}
 
-		double result = (double)EvaluateSingle(evaluatedPicture, line_results.data());
+		const OptimizerKind optimizerKind = m_gstate->m_optimizer == EvalGlobalState::OPT_LAHC
+			? OptimizerKind::LAHC : OptimizerKind::DLAS;
+		// A transactional candidate that cannot be accepted and cannot beat the
+		// global best is abandoned as soon as its error bound shows it.
+		double rejectionLimit = DBL_MAX;
+		if (transactionalCandidate && islandState.initialized)
+			rejectionLimit = std::max(
+				islandState.AcceptanceLimit(optimizerKind, CalculateAcceptanceDrift()),
+				m_gstate->m_best_result.load(std::memory_order_acquire));
+		// Only a dirty-range render leaves the accepted results partly in place.
+		if (!transactionalCandidate)
+			acceptedResults.valid = false;
+		distance_accum_t evaluatedError = transactionalCandidate
+			? EvaluateTransaction(evaluatedPicture, line_results.data(),
+				mutationTransaction, acceptedResults, rejectionLimit)
+			: EvaluateSingle(evaluatedPicture, line_results.data());
+		double result = (double)evaluatedError;
 
 		++localEvaluations;
 		if (m_gstate->m_optimizer != EvalGlobalState::OPT_LEGACY)
@@ -1781,7 +2126,7 @@ void Evaluator::Run() {
 			// validate its score. That reconstruction is not a new search evaluation.
 			const unsigned long long evaluationNumber = reconstructingSavedPicture
 				? m_gstate->m_evaluations.load(std::memory_order_relaxed)
-				: m_gstate->m_evaluations.fetch_add(1, std::memory_order_relaxed) + 1ULL;
+				: NextEvaluationNumber();
 
 			if (!m_gstate->m_initialized.load(std::memory_order_acquire))
 			{
@@ -1802,6 +2147,17 @@ void Evaluator::Run() {
 			}
 
 			const double drift = CalculateAcceptanceDrift();
+			if (transactionalCandidate && acceptedResults.stopped_early
+				&& result <= islandState.AcceptanceLimit(optimizerKind, drift))
+			{
+				// The drift grew past the bound since the limit was taken, so
+				// the candidate's exact cost decides after all.
+				RejectLineResults(acceptedResults, line_results.data());
+				evaluatedError = EvaluateTransaction(evaluatedPicture, line_results.data(),
+					mutationTransaction, acceptedResults);
+				result = (double)evaluatedError;
+				++m_local_cache_bound_retries;
+			}
 			const double bestSnapshot = m_gstate->m_best_result.load(std::memory_order_acquire);
 			const bool potentialGlobalImprovement = result < bestSnapshot;
 			const bool statisticsDue = evaluationNumber % 10000ULL == 0ULL;
@@ -1828,6 +2184,7 @@ void Evaluator::Run() {
 			if (out.accepted)
 			{
 				++localAccepted;
+				islandBestCost = std::min(islandBestCost, result);
 				if (!transactionalCandidate)
 				{
 					const bool sampleCopy = (localAccepted & 255ULL) == 0;
@@ -1847,60 +2204,34 @@ void Evaluator::Run() {
 
 			if (potentialGlobalImprovement)
 			{
-				std::unique_lock<std::mutex> publishLock{m_gstate->m_mutex};
-				if (result < m_gstate->m_best_result.load(std::memory_order_relaxed))
+				// The snapshot is built before it is known to win, so two
+				// workers improving at once may both copy, but neither waits.
+				const auto copyStart = std::chrono::steady_clock::now();
+				std::shared_ptr<EvalGlobalState::PublishedBestSnapshot> snapshot =
+					std::make_shared<EvalGlobalState::PublishedBestSnapshot>();
+				snapshot->picture = *evaluatedPicture;
+				snapshot->picture.uncache_insns();
+				snapshot->cost = result;
+				snapshot->optimizer = islandState;
+				const unsigned long long version =
+					m_gstate->PublishBestSnapshot(std::move(snapshot), evaluationNumber);
+				localPublicationCopyNs += static_cast<unsigned long long>(
+					std::chrono::duration_cast<std::chrono::nanoseconds>(
+						std::chrono::steady_clock::now() - copyStart).count());
+				++localPublicationCopyEvents;
+				if (version)
 				{
-					const auto copyStart = std::chrono::steady_clock::now();
 					++localGlobalImprovements;
-					m_gstate->m_last_best_evaluation.store(evaluationNumber, std::memory_order_relaxed);
-					std::shared_ptr<EvalGlobalState::PublishedBestSnapshot> snapshot =
-						std::make_shared<EvalGlobalState::PublishedBestSnapshot>();
-					snapshot->picture = *evaluatedPicture;
-					snapshot->picture.uncache_insns();
-					snapshot->cost = result;
-					m_gstate->m_best_result.store(result, std::memory_order_release);
-					m_gstate->m_previous_results = islandState.history;
-					m_gstate->m_previous_results_index = islandState.historyIndex;
-					m_gstate->m_current_cost = islandState.currentCost;
-					m_gstate->m_cost_max = islandState.costMax;
-					m_gstate->m_N = islandState.maxCount;
-					observedBestVersion =
-						m_gstate->m_best_state_version.load(std::memory_order_relaxed) + 1;
-					snapshot->version = observedBestVersion;
-					std::atomic_store_explicit(&m_gstate->m_best_snapshot,
-						std::shared_ptr<const EvalGlobalState::PublishedBestSnapshot>(std::move(snapshot)),
-						std::memory_order_release);
-					m_gstate->m_best_state_version.store(observedBestVersion, std::memory_order_release);
-					m_gstate->m_created_picture.resize(m_height);
-					m_gstate->m_created_picture_targets.resize(m_height);
-					for (int y = 0; y < (int)m_height; ++y) {
-						const line_cache_result& lcr = *line_results[y];
-						m_gstate->m_created_picture[y].assign(lcr.color_row, lcr.color_row + m_width);
-						m_gstate->m_created_picture_targets[y].resize(m_width);
-						lcr.copy_target_row(m_gstate->m_created_picture_targets[y].data(), m_width);
-					}
-					memcpy(&m_gstate->m_sprites_memory, m_sprites_memory, sizeof m_gstate->m_sprites_memory);
-					localPublicationCopyNs += static_cast<unsigned long long>(
-						std::chrono::duration_cast<std::chrono::nanoseconds>(
-							std::chrono::steady_clock::now() - copyStart).count());
-					++localPublicationCopyEvents;
-					m_gstate->m_update_improvement = true;
+					observedBestVersion = version;
 					for (int i = 0; i < E_MUTATION_MAX; ++i) {
 						if (m_current_mutations[i]) {
-							m_gstate->m_mutation_stats[i] += m_current_mutations[i];
+							m_gstate->m_mutation_stats[i].fetch_add(m_current_mutations[i],
+								std::memory_order_relaxed);
 						}
 					}
-					m_gstate->m_condvar_update.notify_one();
-				}
-				if (statisticsDue) {
-					statistics_point stats;
-					stats.evaluations = evaluationNumber;
-					stats.seconds = (unsigned)(time(NULL) - m_gstate->m_time_start);
-					stats.distance = m_gstate->m_best_result.load(std::memory_order_relaxed);
-					m_gstate->m_statistics.push_back(stats);
 				}
 			}
-			else if (statisticsDue)
+			if (statisticsDue)
 			{
 				std::unique_lock<std::mutex> statsLock{m_gstate->m_mutex};
 				statistics_point stats;
@@ -1910,11 +2241,21 @@ void Evaluator::Run() {
 				m_gstate->m_statistics.push_back(stats);
 			}
 
+			if ((localEvaluations % k_island_stats_period) == 0 || stopAfterIteration)
+				PublishIslandStats(localEvaluations, localAccepted, localMigrations,
+					islandState.currentCost, islandBestCost);
+
 			if (transactionalCandidate && !out.accepted)
 			{
 				mutationTransaction.Restore(m_allocator_epoch);
+				RejectLineResults(acceptedResults, line_results.data());
 				++localUndoRestores;
 			}
+			else if (out.accepted || evaluatedPicture == &currentPicture)
+				AcceptLineResults(acceptedResults, evaluatedError, line_results.data(),
+					evaluatedPicture->graphics_mode);
+			else
+				acceptedResults.valid = false;
 
 			if (stopAfterIteration)
 				break;
@@ -1938,6 +2279,7 @@ void Evaluator::Run() {
 		const unsigned long long evaluationNumber = reconstructingSavedPicture
 			? m_gstate->m_evaluations.load(std::memory_order_relaxed)
 			: ++m_gstate->m_evaluations;
+		m_evaluation_clock = evaluationNumber;
 
 		// Initialize DLAS on first evaluation
 		if (!m_gstate->m_initialized) {
@@ -1999,7 +2341,14 @@ void Evaluator::Run() {
 
 	}
 
+	ReturnUnusedEvaluations();
 	FlushMutationDiagnosticsToGlobal();
+	{
+		unsigned long long minorFaults, majorFaults;
+		ThreadPageFaults(minorFaults, majorFaults);
+		m_local_minor_page_faults += minorFaults - minorFaultsAtStart;
+		m_local_major_page_faults += majorFaults - majorFaultsAtStart;
+	}
 	FlushCacheDiagnosticsToGlobal();
 	std::unique_lock<std::mutex> lock{ m_gstate->m_mutex };
 	m_gstate->m_single_accepted.fetch_add(localAccepted, std::memory_order_relaxed);
@@ -2024,199 +2373,256 @@ void Evaluator::Run() {
 	m_gstate->m_condvar_update.notify_one();
 }
 
-e_target Evaluator::FindClosestColorRegister(sprites_row_memory_t& spriterow,
+template<class Policy>
+e_target Evaluator::FindClosestColorRegister(uint32_t& sprite_bits,
 	int index, int x, int y, bool& restart_line, distance_t& best_error,
-	unsigned char& output_color)
-{
-	const bool antic4 = m_active_raster_picture
-		&& m_active_raster_picture->graphics_mode == GraphicsMode::Antic4;
-	if (m_active_raster_picture)
-	{
-		struct PlayerPixel
-		{
-			bool covered = false;
-			bool active = false;
-			int bit = 0;
-		};
-		PlayerPixel players[4];
-		unsigned activeMask = 0;
-		const bool normalPlayfield = antic4
-			&& ActivePlayfieldWidth() == PlayfieldWidth::Normal;
-		const int usablePlayers = normalPlayfield ? 2 : 4;
-		for (int player = 0; player < usablePlayers; ++player)
-		{
-			const int spriteX = m_sprite_shift_regs[player]
-				- SpriteScreenColorCycleStart(
-					ActiveGraphicsMode(), ActivePlayfieldWidth());
-			const unsigned xOffset = static_cast<unsigned>(x - spriteX);
-			if (xOffset >= sprite_size)
-				continue;
+	unsigned char& output_color, uint32_t& pixel_mask)
+{
+	assert(m_active_raster_picture);
+	struct PlayerPixel
+	{
+		bool covered = false;
+		bool active = false;
+		uint32_t bit = 0;
+	};
+	PlayerPixel players[4];
+	unsigned activeMask = 0;
+	pixel_mask = 0;
+	for (int player = 0; player < Policy::usable_players; ++player)
+	{
+		const int spriteX = m_sprite_shift_regs[player] - Policy::sprite_screen_start;
+		const unsigned xOffset = static_cast<unsigned>(x - spriteX);
+		if (xOffset >= sprite_size)
+			continue;
 
-			PlayerPixel& pixel = players[player];
-			pixel.covered = true;
-			pixel.bit = static_cast<int>(xOffset >> 2);
-			assert(pixel.bit >= 0 && pixel.bit < 8);
-			pixel.active = spriterow[player][pixel.bit];
+		PlayerPixel& pixel = players[player];
+		pixel.covered = true;
+		pixel.bit = SpriteRowBit(player, static_cast<int>(xOffset >> 2));
+		uint32_t readBits = pixel.bit;
 
-			const int leftover = static_cast<int>(xOffset)
-				+ m_sprite_shift_emitted[player];
-			if (leftover < sprite_size)
-			{
-				const int leftoverBit = leftover >> 2;
-				if (leftoverBit >= 0 && leftoverBit < 8)
-					pixel.active =
-						pixel.active || spriterow[player][leftoverBit];
-			}
-			if (pixel.active)
-				activeMask |= 1u << player;
+		const int leftover = static_cast<int>(xOffset)
+			+ m_sprite_shift_emitted[player];
+		if (leftover < sprite_size)
+		{
+			const int leftoverBit = leftover >> 2;
+			if (leftoverBit >= 0 && leftoverBit < 8)
+				readBits |= SpriteRowBit(player, leftoverBit);
 		}
+		pixel_mask |= readBits;
+		pixel.active = (sprite_bits & readBits) != 0;
+		if (pixel.active)
+			activeMask |= 1u << player;
+	}
 
-		const bool alternate = antic4
-			&& m_active_raster_picture->antic4_attribute(y / 8, x / 4);
-		const e_target playfieldTargets[4] = {
-			E_COLBAK, E_COLOR0, E_COLOR1,
-			alternate ? E_COLOR3 : E_COLOR2
-		};
-		e_target bestPlayfield = E_COLBAK;
-		int bestAddedPlayer = -1;
-		distance_t bestDistance = DISTANCE_MAX;
-		unsigned char bestColor = 0;
+	const bool alternate = Policy::antic4
+		&& m_active_raster_picture->antic4_attribute(y / 8, x / 4);
+	const e_target playfieldTargets[4] = {
+		E_COLBAK, E_COLOR0, E_COLOR1,
+		alternate ? E_COLOR3 : E_COLOR2
+	};
+	e_target bestPlayfield = E_COLBAK;
+	int bestAddedPlayer = -1;
+	distance_t bestDistance = DISTANCE_MAX;
+	unsigned char bestColor = 0;
 
-		auto consider = [&](unsigned playerMask, int addedPlayer)
+	auto consider = [&](unsigned playerMask, int addedPlayer)
+	{
+		for (e_target playfield : playfieldTargets)
 		{
-			for (e_target playfield : playfieldTargets)
-			{
-				const unsigned char color = !antic4
-					? ResolveGtiaPriority4ColorIndex(
+			const unsigned char color = !Policy::antic4
+				? ResolveGtiaPriority4ColorIndex(
+					m_mem_regs, playfield, playerMask)
+				: Policy::normal_antic4
+					? ResolveGtiaPriorityFColorIndex(
 						m_mem_regs, playfield, playerMask)
-					: normalPlayfield
-						? ResolveGtiaPriorityFColorIndex(
-							m_mem_regs, playfield, playerMask)
-						: ResolveGtiaPriority0ColorIndex(
-							m_mem_regs, playfield, playerMask);
-				const distance_t distance =
-					m_picture_all_errors[color][index];
-				if (distance < bestDistance)
-				{
-					bestDistance = distance;
-					bestPlayfield = playfield;
-					bestAddedPlayer = addedPlayer;
-					bestColor = color;
-				}
-			}
-		};
-
-		consider(activeMask, -1);
-		for (int player = 0; player < usablePlayers; ++player)
-		{
-			if (players[player].covered && !players[player].active
-				&& !spriterow[player][players[player].bit])
+					: ResolveGtiaPriority0ColorIndex(
+						m_mem_regs, playfield, playerMask);
+			const distance_t distance = PixelError(color, index, x, y);
+			if (distance < bestDistance)
 			{
-				consider(activeMask | (1u << player), player);
+				bestDistance = distance;
+				bestPlayfield = playfield;
+				bestAddedPlayer = addedPlayer;
+				bestColor = color;
 			}
 		}
+	};
 
-		if (bestAddedPlayer >= 0)
+	consider(activeMask, -1);
+	for (int player = 0; player < Policy::usable_players; ++player)
+	{
+		if (players[player].covered && !players[player].active)
 		{
-			PlayerPixel& pixel = players[bestAddedPlayer];
-			assert(pixel.covered && !spriterow[bestAddedPlayer][pixel.bit]);
-			spriterow[bestAddedPlayer][pixel.bit] = true;
-			restart_line = true;
+			consider(activeMask | (1u << player), player);
 		}
-		best_error = bestDistance;
-		output_color = bestColor;
-		return bestPlayfield;
 	}
 
-	distance_t distance;
-	int sprite_bit;
-	int best_sprite_bit;
-	e_target result=E_COLBAK;
-	distance_t min_distance = DISTANCE_MAX;
-	bool sprite_covers_colbak=false;
-
-	// check sprites
-
-	// Sprites priority is 0,1,2,3
-
-	for (int temp=E_COLPM0;temp<=E_COLPM3;++temp)
+	if (bestAddedPlayer >= 0)
 	{
-		int sprite_pos=m_sprite_shift_regs[temp-E_COLPM0];
-
-		int sprite_x = sprite_pos - SpriteScreenColorCycleStart(
-			ActiveGraphicsMode(), ActivePlayfieldWidth());
-
-		unsigned x_offset = (unsigned)(x - sprite_x);
-		if (x_offset < sprite_size)		// (x>=sprite_x && x<sprite_x+sprite_size)
-		{
-			sprite_bit=x_offset >> 2; // bit of this sprite memory
-			assert(sprite_bit<8);
-
-			sprite_covers_colbak=true;
-
-			// never shifted out remaining sprite pixels combine with sprite memory
-			int sprite_leftover_pixel = 0;
-			int sprite_leftover = x_offset + m_sprite_shift_emitted[temp - E_COLPM0];
-			if (sprite_leftover < sprite_size)
-			{
-				int sprite_leftover_bit = sprite_leftover >> 2;
-				sprite_leftover_pixel = spriterow[temp - E_COLPM0][sprite_leftover_bit];
-			}
-
-//			distance = T_distance_function(pixel,atari_palette[mem_regs[temp]/2]);
-			distance = m_picture_all_errors[m_mem_regs[temp]/2][index];
-			if (spriterow[temp-E_COLPM0][sprite_bit] || sprite_leftover_pixel)
-			{
-				// priority of sprites - next sprites are hidden below that one, so they are not processed
-				best_sprite_bit=sprite_bit;
-				result=(e_target) temp;
-				min_distance = distance;
-				break;
-			}
-			if (distance<min_distance)
-			{
-				best_sprite_bit=sprite_bit;
-				result=(e_target) temp;
-				min_distance=distance;
-			}
-		}
+		PlayerPixel& pixel = players[bestAddedPlayer];
+		assert(pixel.covered && !(sprite_bits & pixel.bit));
+		sprite_bits |= pixel.bit;
+		restart_line = true;
 	}
+	best_error = bestDistance;
+	output_color = bestColor;
+	return bestPlayfield;
+}
 
-	// check standard colors
+template<class Policy>
+distance_t Evaluator::ScorePlayerPixel(uint32_t& sprite_bits,
+	const unsigned char* other_row, int picture_row_index, int y, int x,
+	bool& restart_line, unsigned char* color_row, unsigned char* target_row,
+	PlayerPixelRecord& record)
+{
+	record.seen = sprite_bits;
+	distance_t closest_dist;
+	if constexpr (Policy::dual)
+	{
+		const e_target closest_register = FindClosestColorRegisterDual<Policy>(
+			sprite_bits, other_row, static_cast<unsigned>(picture_row_index),
+			x, restart_line, closest_dist, record.mask);
+		color_row[x] = m_mem_regs[closest_register] >> 1;
+		target_row[x] = closest_register;
+	}
+	else
+	{
+		unsigned char outputColor = 0;
+		const e_target closest_register = FindClosestColorRegister<Policy>(
+			sprite_bits, picture_row_index + x, x, y, restart_line,
+			closest_dist, outputColor, record.mask);
+		color_row[x] = outputColor;
+		target_row[x] = closest_register;
+	}
+	record.seen &= record.mask;
+	record.error = closest_dist;
+	return closest_dist;
+}
 
-	const bool alternate = false;
-	const e_target playfieldTargets[4] = {
-		E_COLOR0, E_COLOR1, alternate ? E_COLOR3 : E_COLOR2, E_COLBAK
+template<class Policy>
+void Evaluator::LoadPlayfieldSpanRegisters(int picture_row_index, int y,
+	PlayfieldSpanRegisters& registers,
+	CompactPlayfieldSpanRegisters& compactRegisters) const
+{
+	static const e_target slotRegisters[E_PLAYFIELD_SLOT_MAX] = {
+		E_COLBAK, E_COLOR0, E_COLOR1, E_COLOR2, E_COLOR3
 	};
-	const int playfieldCount = sprite_covers_colbak ? 3 : 4;
-	for (int candidate = 0; candidate < playfieldCount; ++candidate)
+	for (int slot = 0; slot < E_PLAYFIELD_SLOT_MAX; ++slot)
 	{
-		const e_target temp = playfieldTargets[candidate];
-//		distance = T_distance_function(pixel,atari_palette[mem_regs[temp]/2]);
-		distance = m_picture_all_errors[m_mem_regs[temp]/2][index];
-		if (distance<min_distance)
+		const unsigned char color = m_mem_regs[slotRegisters[slot]] >> 1;
+		if (m_compact_errors)
+		{
+			compactRegisters.rows[slot] = m_compact_errors->Row(color, y);
+			compactRegisters.colors[slot] = color;
+			compactRegisters.targets[slot] = static_cast<unsigned char>(slotRegisters[slot]);
+		}
+		else
 		{
-			min_distance=distance;
-			result=(e_target) temp;
+			registers.rows[slot] = m_picture_all_errors[color] + picture_row_index;
+			registers.colors[slot] = color;
+			registers.targets[slot] = static_cast<unsigned char>(slotRegisters[slot]);
 		}
 	}
+	registers.alternate_columns = Policy::antic4
+		? m_active_raster_picture->antic4_attributes[y / 8] : 0;
+	if (m_compact_errors)
+	{
+		compactRegisters.alternate_columns = registers.alternate_columns;
+		compactRegisters.shift = m_compact_errors->Shift();
+	}
+}
+
+template<class Policy>
+distance_accum_t Evaluator::ScorePixelRun(uint32_t& sprite_bits,
+	const unsigned char* other_row, int picture_row_index, int y,
+	int first, int end, bool& restart_line,
+	unsigned char* color_row, unsigned char* target_row,
+	PlayerPixelRecord* records)
+{
+	assert(m_active_raster_picture);
+	distance_accum_t total = 0;
+	if constexpr (Policy::dual)
+	{
+		// The blended objective depends on the other frame's pixel, so there
+		// is no per-register error plane for the span kernel to scan.
+		for (int x = first; x < end; ++x)
+			total += ScorePlayerPixel<Policy>(sprite_bits, other_row,
+				picture_row_index, y, x, restart_line, color_row, target_row,
+				records[x]);
+		return total;
+	}
+
+	// Shift registers are constant for the whole run, so each player covers
+	// one fixed interval of it.
+	int playerLeft[4];
+	for (int player = 0; player < Policy::usable_players; ++player)
+		playerLeft[player] = m_sprite_shift_regs[player] - Policy::sprite_screen_start;
 
-	// the best color is in sprite, then set the proper bit of the sprite memory and then restart this line
-	if (result>=E_COLPM0 && result<=E_COLPM3)
+	PlayfieldSpanRegisters registers;
+	CompactPlayfieldSpanRegisters compactRegisters;
+	LoadPlayfieldSpanRegisters<Policy>(picture_row_index, y, registers, compactRegisters);
+
+	int x = first;
+	while (x < end)
 	{
-		// if PMG bit has been modified, then restart this line, because previous pixels of COLBAK may be covered
-		if (spriterow[result-E_COLPM0][best_sprite_bit]==false)
+		bool covered = false;
+		int uncoveredEnd = end;
+		for (int player = 0; player < Policy::usable_players; ++player)
+		{
+			const int left = playerLeft[player];
+			if (static_cast<unsigned>(x - left) < sprite_size)
+				covered = true;
+			else if (left > x && left < uncoveredEnd)
+				uncoveredEnd = left;
+		}
+		if (!covered)
 		{
-			restart_line=true;
-			spriterow[result-E_COLPM0][best_sprite_bit]=true;
+			for (int uncovered = x; uncovered < uncoveredEnd; ++uncovered)
+				records[uncovered].mask = 0;
+			total += m_compact_errors
+				? ScoreCompactPlayfieldSpan(
+					compactRegisters, x, uncoveredEnd, color_row, target_row)
+				: ScorePlayfieldSpan(
+					registers, x, uncoveredEnd, color_row, target_row);
+			x = uncoveredEnd;
+			continue;
 		}
 
+		total += ScorePlayerPixel<Policy>(sprite_bits, other_row,
+			picture_row_index, y, x, restart_line, color_row, target_row,
+			records[x]);
+		++x;
 	}
+	return total;
+}
 
-	best_error = min_distance;
-	output_color = static_cast<unsigned char>(m_mem_regs[result] >> 1);
-
-	return result;
+template<class Policy>
+distance_accum_t Evaluator::ScorePlayfieldRun(const unsigned char* other_row,
+	int picture_row_index, int y, int first, int end,
+	unsigned char* color_row, unsigned char* target_row)
+{
+	if constexpr (Policy::dual)
+	{
+		// No player covers the run, so the resolver never adds data bits.
+		uint32_t sprite_bits = 0;
+		bool restart_line = false;
+		PlayerPixelRecord record;
+		distance_accum_t total = 0;
+		for (int x = first; x < end; ++x)
+			total += ScorePlayerPixel<Policy>(sprite_bits, other_row,
+				picture_row_index, y, x, restart_line, color_row, target_row, record);
+		assert(!restart_line);
+		return total;
+	}
+	else
+	{
+		PlayfieldSpanRegisters registers;
+		CompactPlayfieldSpanRegisters compactRegisters;
+		LoadPlayfieldSpanRegisters<Policy>(picture_row_index, y, registers, compactRegisters);
+		return m_compact_errors
+			? ScoreCompactPlayfieldSpan(compactRegisters, first, end, color_row, target_row)
+			: ScorePlayfieldSpan(registers, first, end, color_row, target_row);
+	}
 }
 
 void Evaluator::TurnOffRegisters(raster_picture *pic)
@@ -2240,23 +2646,69 @@ void Evaluator::TurnOffRegisters(raster_picture *pic)
 	}
 }
 
-distance_accum_t Evaluator::ExecuteRasterProgram(raster_picture *pic, const line_cache_result **results_array)
+const RasterLineSchedule* Evaluator::LineSchedules(GraphicsMode mode, PlayfieldWidth width)
+{
+	if (m_line_schedules.size() != m_height || m_line_schedule_mode != mode
+		|| m_line_schedule_width != width)
+	{
+		m_line_schedules.resize(m_height);
+		for (int y = 0; y < (int)m_height; ++y)
+			m_line_schedules[y] = GetRasterLineSchedule(mode, y, m_height, width);
+		m_line_schedule_mode = mode;
+		m_line_schedule_width = width;
+		m_line_facts.clear();
+	}
+	return m_line_schedules.data();
+}
+
+const Evaluator::LineInsnFacts& Evaluator::LineFacts(int y, const insn_sequence* seq,
+	const RasterLineSchedule& schedule, bool antic4)
+{
+	if (m_line_facts.size() != m_height)
+		m_line_facts.assign(m_height, LineInsnFacts());
+	LineInsnFacts& facts = m_line_facts[y];
+	if (facts.insn_seq != seq || facts.allocator_epoch != m_allocator_epoch)
+	{
+		facts.insn_seq = seq;
+		facts.allocator_epoch = m_allocator_epoch;
+		facts.live = LineEntryLiveRegisters(seq->insns, seq->insn_count,
+			schedule, antic4, static_cast<int>(m_width) + 16);
+		facts.moves_players = false;
+		for (unsigned i = 0; i < seq->insn_count; ++i)
+		{
+			const SRasterInstruction& insn = seq->insns[i];
+			if (insn.loose.instruction >= E_RASTER_STA
+				&& insn.loose.target >= E_HPOSP0 && insn.loose.target <= E_HPOSP3)
+			{
+				facts.moves_players = true;
+				break;
+			}
+		}
+	}
+	return facts;
+}
+
+template<class Policy>
+distance_accum_t Evaluator::RenderRasterProgram(raster_picture *pic,
+	const line_cache_result **results_array,
+	const std::vector<const unsigned char*>* other_rows,
+	const RasterMutationTransaction* transaction,
+	AcceptedLineResults* accepted)
 {
 	static constexpr int k_max_visible_width = 176;
 	static constexpr int k_max_hpos_events = 64;
 	const int visible_width = std::min(static_cast<int>(m_width), k_max_visible_width);
-	PmgPixelSnapshot pmg_snapshots[k_max_visible_width];
+	PmgPixelSpan pmg_spans[k_max_visible_width];
+	int pmg_span_count = 0;
 	PmgHposEvent pmg_hpos_events[k_max_hpos_events];
 	int pmg_hpos_event_count = 0;
+	PlayerPixelRecord pixel_records[k_max_visible_width];
 
 	int x,y; // currently processed pixel
-#if defined(_DEBUG) || !defined(NDEBUG)
-	if (!pic) { DBG_PRINT("[EVAL] ExecuteRasterProgram: pic=null"); return 0; }
-#endif
 
 	// Memory guard: keep single-frame path bounded like worker loop and dual path
-	// Keep line-result generations plus stable instruction interning within the
-	// configured per-evaluator budget.
+	// Line-result slots recycle themselves at their share of the configured
+	// per-evaluator budget; traces and instruction interning are cut back here.
 	if (m_cache_allocator_stats.resident_bytes > m_cache_size)
 	{
 		// Acquire a mutex to coordinate cache clearing across evaluators
@@ -2264,11 +2716,13 @@ distance_accum_t Evaluator::ExecuteRasterProgram(raster_picture *pic, const line
 		// Check again after acquiring the lock (another thread might have cleared)
 		if (m_cache_allocator_stats.resident_bytes > m_cache_size)
 		{
-			ClearLineCacheGeneration();
-			++m_cache_partial_clears;
-			if (m_insn_allocator.size() > m_cache_size / k_instruction_cache_budget_divisor)
+			if (m_line_trace_allocator.size() > m_cache_size / k_trace_cache_budget_divisor)
+				ClearLineTraces();
+			if (m_insn_allocator.size() + m_insn_seq_cache.table_bytes()
+				> m_cache_size / k_instruction_cache_budget_divisor)
 			{
-				++m_cache_full_clears;
+				++m_cache_budget_resets;
+				ClearLineCacheGeneration();
 				m_insn_seq_cache.clear();
 				m_insn_allocator.clear();
 				++m_allocator_epoch;
@@ -2279,11 +2733,38 @@ distance_accum_t Evaluator::ExecuteRasterProgram(raster_picture *pic, const line
 				}
 				ClearLineActivity();
 			}
+			else if (m_cache_allocator_stats.resident_bytes > m_cache_size)
+			{
+				ClearLineTraces();
+				if (m_cache_allocator_stats.resident_bytes > m_cache_size)
+				{
+					++m_cache_budget_resets;
+					ClearLineCacheGeneration();
+				}
+			}
 		}
 	}
 
-	// Single-frame path: keep hot; picture should have been recached by caller (m_best_pic.recache_insns).
+	// Shared PMG helpers inspect the active picture. Dual candidates are often
+	// moved or destroyed immediately after evaluation, so never retain this
+	// non-owning pointer beyond the call.
 	ActiveRasterPictureScope activePicture(m_active_raster_picture, pic);
+	std::vector<line_cache>& line_caches = Policy::dual ? m_line_caches_dual : m_line_caches;
+	m_line_slots.begin_render();
+	// Traces only pay off when a candidate toggles attributes: the lines it
+	// re-renders are the accepted ones under a different attribute row, and
+	// recording every other miss would only crowd the cache budget.
+	bool trace_lines = false;
+	if constexpr (Policy::antic4)
+	{
+		trace_lines = m_current_mutations[E_MUTATION_TOGGLE_ANTIC4_ATTRIBUTE] != 0;
+		if (trace_lines && m_line_trace_caches.size() != m_height)
+			m_line_trace_caches.resize(m_height);
+	}
+	const RasterLineSchedule* schedules = LineSchedules(pic->graphics_mode, pic->playfield_width);
+	const bool render_rows = !Policy::dual && m_render_rows;
+	shared_line_cache* shared_lines = !Policy::dual && !render_rows && m_gstate
+		&& m_gstate->m_shared_line_cache.enabled() ? &m_gstate->m_shared_line_cache : nullptr;
 
 	int cycle;
 	int next_instr_offset;
@@ -2300,70 +2781,152 @@ distance_accum_t Evaluator::ExecuteRasterProgram(raster_picture *pic, const line
 
 	memset(m_sprite_shift_regs,0,sizeof(m_sprite_shift_regs));
 	memcpy(m_mem_regs,pic->mem_regs_init,sizeof(pic->mem_regs_init));
-	memset(m_sprites_memory,0,sizeof(m_sprites_memory));
+
+	// A transactional candidate differs from the accepted picture only from
+	// its first dirty line on, and only until a line below the last dirty one
+	// is entered with the accepted register state. Everything outside that
+	// window keeps the accepted results already in results_array; sprite rows
+	// outside it are stale and only the line results carry them.
+	const bool dirty_range = accepted && accepted->valid
+		&& accepted->cache_generation == m_line_cache_generation;
+	int first_line = 0;
+	int converge_line = static_cast<int>(m_height);
+	if (dirty_range)
+	{
+		first_line = std::min(transaction->DirtyFirst(), static_cast<int>(m_height));
+		converge_line = transaction->DirtyLast() + 1;
+		if (first_line > 0 && first_line < static_cast<int>(m_height))
+			ApplyRegisterState(results_array[first_line - 1]->new_state);
+		accepted->replaced_first = first_line;
+		accepted->replaced.clear();
+	}
+	else
+	{
+		if (accepted)
+			accepted->valid = false;
+		memset(m_sprites_memory,0,sizeof(m_sprites_memory));
+	}
+	
+	// With a rejection limit, the accepted error above the window plus the
+	// floor of every line not yet rendered bounds the candidate from below.
+	const distance_accum_t* error_floor = nullptr;
+	distance_accum_t prefix_error = 0;
+	if (dirty_range && accepted->rejection_limit < DBL_MAX)
+	{
+		error_floor = LineErrorFloor();
+		prefix_error = accepted->prefix_error[first_line];
+	}
 	
 	bool restart_line=false;
 	bool shift_start_array_dirty = true;
 	distance_accum_t total_error = 0;
+	distance_accum_t rejection_bound = 0;
 	unsigned recomputedLines = 0;
 	int firstMissLine = -1;
 	int lastMissLine = -1;
 
-	for (y=0; y<(int)m_height; ++y)
+	for (y=first_line; y<(int)m_height; ++y)
 	{
-		const RasterLineSchedule lineSchedule =
-			GetRasterLineSchedule(pic->graphics_mode, y, m_height,
-				pic->playfield_width);
+		const RasterLineSchedule& lineSchedule = schedules[y];
+		const unsigned char* __restrict other_row = Policy::dual ? (*other_rows)[y] : nullptr;
 		pmg_hpos_event_count = 0;
-		if (restart_line)
-		{
-			RestoreLineRegs();
-			shift_start_array_dirty = true;
-		}
-		else
-		{
-			StoreLineRegs();
-		}
+		StoreLineRegs();
 
-		// snapshot current machine state
 		raster_line& rline = pic->raster_lines[y];
 		// Ensure instruction sequence pointer is valid before hashing/lookup in case allocator was cleared above
 		if (!rline.cache_key) { rline.recache_insns(m_insn_seq_cache, m_insn_allocator); }
+		// Registers the line defines before observing them cannot change its
+		// result, so they are left out of the key and the convergence test.
+		const LineInsnFacts& facts = LineFacts(
+			y, rline.cache_key, lineSchedule, Policy::antic4);
+		const register_state& live = facts.live;
+
+		if (dirty_range)
+		{
+			if (y >= accepted->render_end)
+				break;
+			if (y >= converge_line)
+			{
+				const line_cache_result* accepted_previous = y - 1 >= first_line
+					? accepted->replaced[y - 1 - first_line] : results_array[y - 1];
+				if (MaskedRegisterStatesEqual(m_old_reg_state,
+						accepted_previous->new_state, live))
+					break;
+			}
+			if (error_floor && y > first_line)
+			{
+				rejection_bound = prefix_error + total_error + error_floor[y];
+				if (static_cast<double>(rejection_bound) > accepted->rejection_limit)
+				{
+					accepted->stopped_early = true;
+					break;
+				}
+			}
+			accepted->replaced.push_back(results_array[y]);
+		}
 
+		// snapshot current machine state
 		line_cache_key lck;
 		CaptureRegisterState(lck.entry_state);
+		MaskRegisterState(lck.entry_state, live);
 		lck.insn_seq = rline.cache_key;
 		antic4_line_cache_key antic4_lck;
-		const bool antic4Cache = pic->graphics_mode == GraphicsMode::Antic4;
-		if (antic4Cache)
+		if constexpr (Policy::antic4)
 		{
 			static_cast<line_cache_key&>(antic4_lck) = lck;
 			antic4_lck.attribute_row = pic->antic4_attributes[y / 8];
 		}
 		const uint32_t lck_hash =
-			antic4Cache ? antic4_lck.hash() : lck.hash();
+			Policy::antic4 ? antic4_lck.hash() : lck.hash();
 
 		// check line cache
 		unsigned char * __restrict created_picture_row = &m_created_picture[y][0];
 		unsigned char * __restrict created_picture_targets_row = &m_created_picture_targets[y][0];
 
-		unsigned lookupProbes = 0;
-		const line_cache_result* cached_line_result = antic4Cache
-			? m_line_caches[y].find(antic4_lck, lck_hash, &lookupProbes)
-			: m_line_caches[y].find(lck, lck_hash, &lookupProbes);
-		++m_local_cache_lookups;
-		m_local_cache_lookup_probes += lookupProbes;
-		m_local_cache_max_lookup_probes = std::max(
-			m_local_cache_max_lookup_probes,
-			static_cast<unsigned long long>(lookupProbes));
+		// Rows for a lean cache come from rendering the line, never from it.
+		const line_cache_result* cached_line_result = nullptr;
+		if (!render_rows)
+		{
+			unsigned lookupProbes = 0;
+			cached_line_result = Policy::antic4
+				? line_caches[y].find(antic4_lck, lck_hash, &lookupProbes)
+				: line_caches[y].find(lck, lck_hash, &lookupProbes);
+			++m_local_cache_lookups;
+			m_local_cache_lookup_probes += lookupProbes;
+			m_local_cache_max_lookup_probes = std::max(
+				m_local_cache_max_lookup_probes,
+				static_cast<unsigned long long>(lookupProbes));
+		}
+		if (!cached_line_result && shared_lines)
+		{
+			// Another worker may have rendered this line already. Its result
+			// is adopted into the private cache, then used like a private hit.
+			const uint64_t attributeRow = Policy::antic4 ? antic4_lck.attribute_row : 0;
+			const uint32_t sharedHash = shared_line_cache::hash(lck, attributeRow);
+			++m_local_shared_cache_lookups;
+			if (const shared_line_record* record = shared_lines->find(y, lck, attributeRow, sharedHash))
+			{
+				++m_local_shared_cache_hits;
+				bool grewTable = false;
+				line_cache_result& adopted = Policy::antic4
+					? line_caches[y].insert(antic4_lck, lck_hash, m_line_slots, &grewTable)
+					: line_caches[y].insert(lck, lck_hash, m_line_slots, &grewTable);
+				++m_local_cache_inserts;
+				if (grewTable)
+					++m_local_cache_table_growths;
+				shared_lines->copy(*record, adopted);
+				cached_line_result = &adopted;
+			}
+		}
 		if (cached_line_result)
 		{
 			++m_local_cache_hits;
 			++m_local_cache_hits_by_line[y];
 			// sweet! cache hit!!
 			results_array[y] = cached_line_result;
+			m_line_slots.touch(*cached_line_result);
 			ApplyRegisterState(cached_line_result->new_state);
-			memcpy(m_sprites_memory[y], cached_line_result->sprite_data, sizeof m_sprites_memory[y]);
+			UnpackSpriteRow(m_sprites_memory[y], cached_line_result->sprite_bits);
 			shift_start_array_dirty = true;
 			UpdateLRU(y);
 
@@ -2371,13 +2934,40 @@ distance_accum_t Evaluator::ExecuteRasterProgram(raster_picture *pic, const line
 			continue;
 		}
 
-		++m_local_cache_misses;
-		++m_local_cache_misses_by_line[y];
+		if (!render_rows)
+		{
+			++m_local_cache_misses;
+			++m_local_cache_misses_by_line[y];
+		}
 		++recomputedLines;
 		if (firstMissLine < 0) firstMissLine = y;
 		lastMissLine = y;
 
-		if (shift_start_array_dirty)
+		// The attribute row only changes how pixels are scored. A line already
+		// simulated under other attributes replays its trace instead.
+		const LineRegisterTrace* trace = nullptr;
+		uint32_t trace_hash = 0;
+		if (trace_lines)
+		{
+			trace_hash = lck.hash();
+			trace = m_line_trace_caches[y].find<line_cache_key, LineRegisterTrace>(
+				lck, trace_hash);
+		}
+		const PmgPixelSpan* line_spans = pmg_spans;
+		const PmgHposEvent* line_events = pmg_hpos_events;
+
+		// A line that never stores HPOS and enters with every player outside
+		// the picture draws playfield pixels only: nothing starts shifting
+		// where it could be seen and no data bit can be set. A line whose
+		// trace is recorded still needs the full walk's spans.
+		bool players_hidden = !trace_lines && !facts.moves_players;
+		for (int player = 0; players_hidden && player < Policy::usable_players; ++player)
+		{
+			const int left = m_mem_regs[E_HPOSP0 + player] - Policy::sprite_screen_start;
+			players_hidden = left + sprite_size <= 0 || left >= static_cast<int>(m_width);
+		}
+
+		if (shift_start_array_dirty && !trace && !players_hidden)
 		{
 			shift_start_array_dirty = false;
 
@@ -2391,10 +2981,9 @@ distance_accum_t Evaluator::ExecuteRasterProgram(raster_picture *pic, const line
 		ip=0;
 		cycle=0;
 		const ScreenCycle* lineCycles = lineSchedule.timing->cycles.data();
-		const bool antic4Timing = pic->graphics_mode == GraphicsMode::Antic4;
 		next_instr_offset = rastinsncnt
 			? RasterInstructionCompletionOffset(
-				lineCycles, cycle, rastinsns[ip], antic4Timing)
+				lineCycles, cycle, rastinsns[ip], Policy::antic4)
 			: 1000;
 
 		// on new line clear sprite shifts and wait to be taken from mem_regs
@@ -2403,123 +2992,217 @@ distance_accum_t Evaluator::ExecuteRasterProgram(raster_picture *pic, const line
 		const int picture_row_index = m_width * y;
 
 		distance_accum_t total_line_error = 0;
+		distance_accum_t store_penalty = 0;
+		uint32_t sprite_bits = 0;
 
-		sprites_row_memory_t& spriterow = m_sprites_memory[y];
+		const int sprite_screen_start = Policy::sprite_screen_start;
+		const int line_end = static_cast<int>(m_width) + 16;
+		pmg_span_count = 0;
 
-		for (x = -SpriteScreenColorCycleStart(
-				ActiveGraphicsMode(), ActivePlayfieldWidth());
-			x < static_cast<int>(m_width) + 16; ++x)
+		if (trace)
 		{
-			// check position of sprites
-			const int sprite_check_x = x + SpriteScreenColorCycleStart(
-				ActiveGraphicsMode(), ActivePlayfieldWidth());
-
-			const unsigned char sprite_start_mask = m_sprite_shift_start_array[sprite_check_x];
-
-			if (sprite_start_mask)
+			++m_local_cache_trace_hits;
+			line_spans = trace->spans;
+			line_events = trace->events;
+			pmg_span_count = trace->span_count;
+			pmg_hpos_event_count = trace->event_count;
+			// Store penalties need player data drawn earlier on the line, which
+			// only a restart has; without one there is none to penalise.
+			for (int span_index = 0; span_index < pmg_span_count; ++span_index)
 			{
-				//if (sprite_start_mask & 1) m_sprite_shift_regs[0] = m_mem_regs[E_HPOSP0];
-				//if (sprite_start_mask & 2) m_sprite_shift_regs[1] = m_mem_regs[E_HPOSP1];
-				//if (sprite_start_mask & 4) m_sprite_shift_regs[2] = m_mem_regs[E_HPOSP2];
-				//if (sprite_start_mask & 8) m_sprite_shift_regs[3] = m_mem_regs[E_HPOSP3];
-				if (sprite_start_mask & 1) StartSpriteShift(E_HPOSP0);
-				if (sprite_start_mask & 2) StartSpriteShift(E_HPOSP1);
-				if (sprite_start_mask & 4) StartSpriteShift(E_HPOSP2);
-				if (sprite_start_mask & 8) StartSpriteShift(E_HPOSP3);
+				const PmgPixelSpan& span = line_spans[span_index];
+				memcpy(m_mem_regs, span.state.color_regs, sizeof span.state.color_regs);
+				memcpy(m_sprite_shift_regs, span.state.shift_regs, sizeof span.state.shift_regs);
+				memcpy(m_sprite_shift_emitted, span.state.shift_emitted, sizeof span.state.shift_emitted);
+				total_line_error += ScorePixelRun<Policy>(sprite_bits, other_row,
+					picture_row_index, y, span.first, span.end, restart_line,
+					created_picture_row, created_picture_targets_row, pixel_records);
 			}
+			ApplyRegisterState(trace->new_state);
+			// Player starts still reflect the entry positions.
+			shift_start_array_dirty = true;
+		}
+		else if (players_hidden)
+		{
+			++m_local_cache_player_free_lines;
+			// Only instruction completions split the line into runs.
+			for (x = -sprite_screen_start; x < line_end; )
+			{
+				while (next_instr_offset < x && ip < rastinsncnt)
+				{
+					instr = &rastinsns[ip++];
+					ExecuteInstruction(*instr, x + sprite_screen_start, sprite_bits, store_penalty);
+					cycle += GetInstructionCycles(*instr);
+					next_instr_offset = ip < rastinsncnt
+						? RasterInstructionCompletionOffset(
+							lineCycles, cycle, rastinsns[ip], Policy::antic4)
+						: 1000;
+				}
 
-			while(next_instr_offset<x && ip<rastinsncnt) // execute instructions
+				int span_end = line_end;
+				if (ip < rastinsncnt && next_instr_offset + 1 < span_end)
+					span_end = next_instr_offset + 1;
+				const int first_pixel = std::max(x, 0);
+				const int end_pixel = std::min(span_end, static_cast<int>(m_width));
+				if (first_pixel < end_pixel)
+					total_line_error += ScorePlayfieldRun<Policy>(other_row,
+						picture_row_index, y, first_pixel, end_pixel,
+						created_picture_row, created_picture_targets_row);
+				x = span_end;
+			}
+		}
+		else
+		{
+			// Walk the line event by event. Sprite starts and instruction
+			// completions are applied at the colour clock where they take effect;
+			// every pixel up to the next event sees the same registers, so it is
+			// rendered as one run without re-checking either source per pixel.
+			for (x = -sprite_screen_start; x < line_end; )
 			{
 				// check position of sprites
+				const int sprite_check_x = x + sprite_screen_start;
+
+				const unsigned char sprite_start_mask = m_sprite_shift_start_array[sprite_check_x];
 
-				instr = &rastinsns[ip++];
+				if (sprite_start_mask)
+				{
+					if (sprite_start_mask & 1) StartSpriteShift(E_HPOSP0);
+					if (sprite_start_mask & 2) StartSpriteShift(E_HPOSP1);
+					if (sprite_start_mask & 4) StartSpriteShift(E_HPOSP2);
+					if (sprite_start_mask & 8) StartSpriteShift(E_HPOSP3);
+				}
 
-				//if (cycle<4) // in the previous line
-				//	ExecuteInstruction(*instr,x+200);
-				//else
-				//	ExecuteInstruction(*instr,x);
-				const unsigned hpos_index =
-					static_cast<unsigned>(instr->loose.target - E_HPOSP0);
-				if (hpos_index < 4)
+				while(next_instr_offset<x && ip<rastinsncnt) // execute instructions
 				{
-					const int new_x = StoredRegisterValue(
-						*instr, m_reg_a, m_reg_x, m_reg_y);
-					const int old_x = m_mem_regs[instr->loose.target];
-					const int visible_left = SpriteScreenColorCycleStart(
-						ActiveGraphicsMode(), ActivePlayfieldWidth()) - sprite_size;
-					const int visible_right = SpriteScreenColorCycleStart(
-						ActiveGraphicsMode(), ActivePlayfieldWidth()) + m_width - 1;
-					if (new_x >= 0 && old_x != new_x
-						&& new_x >= visible_left && new_x <= visible_right)
+					instr = &rastinsns[ip++];
+
+					const unsigned hpos_index =
+						static_cast<unsigned>(instr->loose.target - E_HPOSP0);
+					if (hpos_index < 4)
 					{
-						assert(pmg_hpos_event_count < k_max_hpos_events);
-						PmgHposEvent& event = pmg_hpos_events[pmg_hpos_event_count++];
-						event.sprite = static_cast<unsigned char>(hpos_index);
-						event.old_x = old_x;
-						event.new_x = new_x;
-						event.check_x = sprite_check_x;
+						const int new_x = StoredRegisterValue(
+							*instr, m_reg_a, m_reg_x, m_reg_y);
+						const int old_x = m_mem_regs[instr->loose.target];
+						const int visible_left = sprite_screen_start - sprite_size;
+						const int visible_right = sprite_screen_start + m_width - 1;
+						if (new_x >= 0 && old_x != new_x
+							&& new_x >= visible_left && new_x <= visible_right)
+						{
+							assert(pmg_hpos_event_count < k_max_hpos_events);
+							PmgHposEvent& event = pmg_hpos_events[pmg_hpos_event_count++];
+							event.sprite = static_cast<unsigned char>(hpos_index);
+							event.old_x = old_x;
+							event.new_x = new_x;
+							event.check_x = sprite_check_x;
+						}
 					}
-				}
 
-				ExecuteInstruction(*instr, sprite_check_x, spriterow, total_line_error);
+					ExecuteInstruction(*instr, sprite_check_x, sprite_bits, store_penalty);
+
+					cycle+=GetInstructionCycles(*instr);
+					next_instr_offset = ip < rastinsncnt
+						? RasterInstructionCompletionOffset(
+							lineCycles, cycle, rastinsns[ip], Policy::antic4)
+						: 1000;
+				}
 
-				cycle+=GetInstructionCycles(*instr);
-				next_instr_offset = ip < rastinsncnt
-					? RasterInstructionCompletionOffset(
-						lineCycles, cycle, rastinsns[ip], antic4Timing)
-					: 1000;
+				// The pending instruction lands on the first clock past its
+				// completion offset; an HPOS write may have moved a start earlier.
+				int span_end = line_end;
+				if (ip < rastinsncnt && next_instr_offset + 1 < span_end)
+					span_end = next_instr_offset + 1;
+				span_end = NextSpriteShiftStart(m_sprite_shift_start_array,
+					sprite_check_x + 1, span_end + sprite_screen_start)
+					- sprite_screen_start;
+
+				const int first_pixel = std::max(x, 0);
+				const int end_pixel = std::min(span_end, static_cast<int>(m_width));
+				if (first_pixel < end_pixel)
+				{
+					PmgPixelSpan& span = pmg_spans[pmg_span_count++];
+					memcpy(span.state.color_regs, m_mem_regs, sizeof span.state.color_regs);
+					memcpy(span.state.shift_regs, m_sprite_shift_regs, sizeof span.state.shift_regs);
+					memcpy(span.state.shift_emitted, m_sprite_shift_emitted, sizeof span.state.shift_emitted);
+					span.first = first_pixel;
+					span.end = end_pixel;
+
+					// put pixels closest to one of the current color registers
+					total_line_error += ScorePixelRun<Policy>(sprite_bits, other_row,
+						picture_row_index, y, first_pixel, end_pixel, restart_line,
+						created_picture_row, created_picture_targets_row, pixel_records);
+				}
+				x = span_end;
 			}
 
-			if ((unsigned)x < (unsigned)m_width)		// x>=0 && x<m_width
+			if (trace_lines)
 			{
-				PmgPixelSnapshot& snapshot = pmg_snapshots[x];
-				memcpy(snapshot.color_regs, m_mem_regs, sizeof snapshot.color_regs);
-				memcpy(snapshot.shift_regs, m_sprite_shift_regs, sizeof snapshot.shift_regs);
-				memcpy(snapshot.shift_emitted, m_sprite_shift_emitted, sizeof snapshot.shift_emitted);
-
-				// put pixel closest to one of the current color registers
-				distance_t closest_dist;
-				unsigned char outputColor = 0;
-				e_target closest_register = FindClosestColorRegister(
-					spriterow, picture_row_index + x, x, y, restart_line,
-					closest_dist, outputColor);
-				total_line_error += closest_dist;
-				created_picture_row[x] = outputColor;
-				created_picture_targets_row[x]=closest_register;
+				LineRegisterTrace& recorded =
+					m_line_trace_caches[y].insert<line_cache_key, LineRegisterTrace>(
+						lck, trace_hash, m_line_trace_allocator);
+				++m_local_cache_trace_inserts;
+				CaptureRegisterState(recorded.new_state);
+				recorded.span_count = pmg_span_count;
+				recorded.event_count = pmg_hpos_event_count;
+				PmgPixelSpan* spans = static_cast<PmgPixelSpan*>(m_line_trace_allocator.allocate(
+					pmg_span_count * sizeof *spans, linear_allocator::LINE_CACHE_TRACE));
+				memcpy(spans, pmg_spans, pmg_span_count * sizeof *spans);
+				recorded.spans = spans;
+				PmgHposEvent* events = nullptr;
+				if (pmg_hpos_event_count)
+				{
+					events = static_cast<PmgHposEvent*>(m_line_trace_allocator.allocate(
+						pmg_hpos_event_count * sizeof *events, linear_allocator::LINE_CACHE_TRACE));
+					memcpy(events, pmg_hpos_events, pmg_hpos_event_count * sizeof *events);
+				}
+				recorded.events = events;
 			}
 		}
 
-		if (restart_line)
+		// First-pass store penalties stand unless a restart recounts them
+		// from the final player data.
+		if (!restart_line)
+			total_line_error += store_penalty;
+		else
 		{
 			++m_local_cache_pmg_restarts;
 
 			// Pixel choices do not affect CPU/register evolution. Reuse the first
-			// pass's visible-pixel states until PMG bits reach the same fixed point
-			// as full line restarts, then retain the already-known outgoing state.
+			// pass's span states until PMG bits reach the same fixed point as
+			// full line restarts, then retain the already-known outgoing state.
+			// A pixel's choice depends only on its span's registers and on the
+			// data bits it reads, so each pass rescores just the pixels whose
+			// bits changed since they were last scored; the rest would repeat
+			// their previous choice, which added nothing.
 			register_state outgoing_state;
 			CaptureRegisterState(outgoing_state);
 			bool added_bits;
 			do
 			{
 				added_bits = false;
-				total_line_error = 0;
-				for (x = 0; x < visible_width; ++x)
+				for (int span_index = 0; span_index < pmg_span_count; ++span_index)
 				{
-					const PmgPixelSnapshot& snapshot = pmg_snapshots[x];
-					memcpy(m_mem_regs, snapshot.color_regs, sizeof snapshot.color_regs);
-					memcpy(m_sprite_shift_regs, snapshot.shift_regs, sizeof snapshot.shift_regs);
-					memcpy(m_sprite_shift_emitted, snapshot.shift_emitted, sizeof snapshot.shift_emitted);
-
-					bool added_bit = false;
-					distance_t closest_dist;
-					unsigned char outputColor = 0;
-					const e_target closest_register = FindClosestColorRegister(
-						spriterow, picture_row_index + x, x, y, added_bit,
-						closest_dist, outputColor);
-					added_bits = added_bits || added_bit;
-					total_line_error += closest_dist;
-					created_picture_row[x] = outputColor;
-					created_picture_targets_row[x] = closest_register;
+					const PmgPixelSpan& span = line_spans[span_index];
+					const int span_end = std::min(span.end, visible_width);
+					bool span_loaded = false;
+					for (int px = span.first; px < span_end; ++px)
+					{
+						PlayerPixelRecord& record = pixel_records[px];
+						if (!record.mask || (sprite_bits & record.mask) == record.seen)
+							continue;
+						if (!span_loaded)
+						{
+							memcpy(m_mem_regs, span.state.color_regs, sizeof span.state.color_regs);
+							memcpy(m_sprite_shift_regs, span.state.shift_regs, sizeof span.state.shift_regs);
+							memcpy(m_sprite_shift_emitted, span.state.shift_emitted, sizeof span.state.shift_emitted);
+							span_loaded = true;
+						}
+						total_line_error -= record.error;
+						bool added_bit = false;
+						total_line_error += ScorePlayerPixel<Policy>(sprite_bits, other_row,
+							picture_row_index, y, px, added_bit,
+							created_picture_row, created_picture_targets_row, record);
+						added_bits = added_bits || added_bit;
+					}
 				}
 				if (added_bits)
 					++m_local_cache_pmg_restarts;
@@ -2527,17 +3210,8 @@ distance_accum_t Evaluator::ExecuteRasterProgram(raster_picture *pic, const line
 
 			for (int event_index = 0; event_index < pmg_hpos_event_count; ++event_index)
 			{
-				const PmgHposEvent& event = pmg_hpos_events[event_index];
-				bool sprite_has_data = false;
-				for (int bit = 7; bit >= 0; --bit)
-				{
-					if (spriterow[event.sprite][bit])
-					{
-						sprite_has_data = true;
-						break;
-					}
-				}
-				if (!sprite_has_data)
+				const PmgHposEvent& event = line_events[event_index];
+				if (!SpriteRowPlayerBits(sprite_bits, event.sprite))
 					continue;
 				if (event.old_x - event.check_x <= 6 && event.old_x - event.check_x > 0)
 					total_line_error += 100000;
@@ -2548,50 +3222,142 @@ distance_accum_t Evaluator::ExecuteRasterProgram(raster_picture *pic, const line
 			restart_line = false;
 		}
 
-		if (lineSchedule.chbase_transition)
+		if (Policy::antic4 && lineSchedule.chbase_transition)
 		{
 			// The fixed LDA #>charset_N / STA CHBASE suffix intentionally
 			// clobbers A. The concrete generator uses ten 1 KiB sets at $8000.
 			m_reg_a = static_cast<unsigned char>(0x80 + 4 * (y / 24 + 1));
 		}
 
-		if (!restart_line)
-		{
-			total_error += total_line_error;
+		total_error += total_line_error;
+		UnpackSpriteRow(m_sprites_memory[y], sprite_bits);
 
-			// add this to line cache
-			bool allocatedBlock = false;
-			line_cache_result& result_state = antic4Cache
-				? m_line_caches[y].insert(
-					antic4_lck, lck_hash, m_line_allocator, &allocatedBlock)
-				: m_line_caches[y].insert(
-					lck, lck_hash, m_line_allocator, &allocatedBlock);
+		// add this to line cache
+		line_cache_result* stored_result = render_rows ? &m_row_results[y] : nullptr;
+		if (!stored_result)
+		{
+			bool grewTable = false;
+			stored_result = Policy::antic4
+				? &line_caches[y].insert(
+					antic4_lck, lck_hash, m_line_slots, &grewTable)
+				: &line_caches[y].insert(
+					lck, lck_hash, m_line_slots, &grewTable);
 			++m_local_cache_inserts;
-			if (allocatedBlock)
-				++m_local_cache_hash_blocks;
-			UpdateLRU(y);
-			result_state.line_error = total_line_error;
-			CaptureRegisterState(result_state.new_state);
-			result_state.color_row = (unsigned char *)m_line_allocator.allocate(
-				m_width, linear_allocator::LINE_CACHE_COLOR_ROW);
+			if (grewTable)
+				++m_local_cache_table_growths;
+		}
+		line_cache_result& result_state = *stored_result;
+		UpdateLRU(y);
+		result_state.line_error = total_line_error;
+		CaptureRegisterState(result_state.new_state);
+		if (result_state.color_row)
+		{
 			memcpy(result_state.color_row, created_picture_row, m_width);
-
-			const size_t targetBytes = line_cache_result::packed_target_bytes(m_width);
-			result_state.packed_target_row = (unsigned char *)m_line_allocator.allocate(
-				targetBytes, linear_allocator::LINE_CACHE_TARGET_ROW);
 			line_cache_result::pack_target_row(
 				result_state.packed_target_row, created_picture_targets_row, m_width);
+		}
+
+		result_state.sprite_bits = sprite_bits;
 
-			memcpy(result_state.sprite_data, m_sprites_memory[y], sizeof result_state.sprite_data);
+		results_array[y] = &result_state;
+	}
 
-			results_array[y] = &result_state;
+	if (dirty_range)
+	{
+		if (accepted->stopped_early)
+		{
+			// Lines from y on still hold accepted results; the caller rejects
+			// the candidate and puts back the ones it replaced.
+			total_error = rejection_bound;
+			++m_local_cache_bound_rejections;
+			m_local_cache_bound_skipped_lines += static_cast<unsigned long long>(
+				static_cast<int>(m_height) - y);
+		}
+		else if (accepted->render_end < static_cast<int>(m_height))
+		{
+			// Lines above the window and from y to render_end are accepted.
+			const int end = accepted->render_end;
+			total_error += accepted->prefix_error[std::min(first_line, end)];
+			if (y < end)
+				total_error += accepted->prefix_error[end] - accepted->prefix_error[y];
+		}
+		else
+		{
+			distance_accum_t replaced_error = 0;
+			for (const line_cache_result* replaced : accepted->replaced)
+				replaced_error += replaced->line_error;
+			total_error += accepted->total_error - replaced_error;
+			m_local_cache_spliced_lines += static_cast<unsigned long long>(
+				static_cast<int>(m_height) - first_line
+				- static_cast<int>(accepted->replaced.size()));
 		}
+		// Mutations read the registers a render leaves behind as the sprite
+		// positions. Finish in the accepted picture's final state, which is
+		// what a full render leaves when the candidate converged; an abandoned
+		// candidate leaves it too, as it is about to be rolled back.
+		if (m_height > 0)
+			ApplyRegisterState(results_array[m_height - 1]->new_state);
+		++m_local_cache_dirty_range_evaluations;
+		m_local_cache_prefix_lines += static_cast<unsigned long long>(first_line);
 	}
 
 	RecordCacheEvaluation(recomputedLines, firstMissLine, lastMissLine);
 	return total_error;
 }
 
+distance_accum_t Evaluator::ExecuteRasterProgram(raster_picture *pic, const line_cache_result **results_array,
+	const RasterMutationTransaction* transaction, AcceptedLineResults* accepted)
+{
+#if defined(_DEBUG) || !defined(NDEBUG)
+	if (!pic) { DBG_PRINT("[EVAL] ExecuteRasterProgram: pic=null"); return 0; }
+#endif
+	// Single-frame path: keep hot; picture should have been recached by caller (m_best_pic.recache_insns).
+	const bool wide = pic->playfield_width == PlayfieldWidth::Wide;
+	if (pic->graphics_mode == GraphicsMode::Antic4)
+	{
+		return wide
+			? RenderRasterProgram<RenderAntic4Wide>(pic, results_array, nullptr,
+				transaction, accepted)
+			: RenderRasterProgram<RenderAntic4Normal>(pic, results_array, nullptr,
+				transaction, accepted);
+	}
+	return wide
+		? RenderRasterProgram<RenderAnticEWide>(pic, results_array, nullptr,
+			transaction, accepted)
+		: RenderRasterProgram<RenderAnticENormal>(pic, results_array, nullptr,
+			transaction, accepted);
+}
+
+distance_accum_t Evaluator::ExecuteRasterProgramDual(raster_picture *pic, const line_cache_result **results_array, const std::vector<const unsigned char*>& other_rows, bool mutateB)
+{
+#ifdef _DEBUG
+    assert(m_dual_paletteY && m_dual_paletteU && m_dual_paletteV);
+    assert(m_dual_pairYsum && m_dual_pairUsum && m_dual_pairVsum);
+    assert(m_dual_targetY && m_dual_targetU && m_dual_targetV);
+    assert((int)other_rows.size() == (int)m_height);
+#endif
+	assert(pic->graphics_mode == GraphicsMode::AnticE
+		&& pic->playfield_width == PlayfieldWidth::Normal);
+    // Ensure dual cache storage exists
+    if ((int)m_line_caches_dual.size() != (int)m_height) {
+		// Slots name the caches they are linked into; resizing moves them.
+		ClearLineCacheGeneration();
+        m_line_caches_dual.clear();
+        m_line_caches_dual.resize(m_height);
+    }
+
+    // Snapshot generation counter of the OTHER frame (for cache invalidation)
+    m_dual_gen_other_snapshot = mutateB ? m_gstate->m_dual_generation_A.load(std::memory_order_acquire)
+                                        : m_gstate->m_dual_generation_B.load(std::memory_order_acquire);
+    if (m_dual_last_other_generation != m_dual_gen_other_snapshot) {
+		ClearLineCacheGeneration();
+        m_dual_last_other_generation = m_dual_gen_other_snapshot;
+    }
+
+    DBG_PRINT("[EVAL] ExecuteRasterProgramDual enter: pic=%p h=%u w=%u", (void*)pic, m_height, m_width);
+	return RenderRasterProgram<RenderDualAnticENormal>(pic, results_array, &other_rows);
+}
+
 template<fn_rgb_distance& T_distance_function>
 distance_accum_t Evaluator::CalculateLineDistance(const screen_line &r, const screen_line &l)
 {
@@ -2608,7 +3374,7 @@ distance_accum_t Evaluator::CalculateLineDistance(const screen_line &r, const sc
 };
 
 //inline void Evaluator::ExecuteInstruction(const SRasterInstruction &instr, int x)
-inline void Evaluator::ExecuteInstruction(const SRasterInstruction &instr, int sprite_check_x, sprites_row_memory_t &spriterow, distance_accum_t &total_line_error)
+inline void Evaluator::ExecuteInstruction(const SRasterInstruction &instr, int sprite_check_x, uint32_t sprite_bits, distance_accum_t &total_line_error)
 {
 	int reg_value=-1;
 	switch(instr.loose.instruction)
@@ -2652,17 +3418,11 @@ inline void Evaluator::ExecuteInstruction(const SRasterInstruction &instr, int s
 			if (sprite_old_x != sprite_new_x && sprite_new_x >= sprites_visible_left && sprite_new_x <= sprites_visible_right)
 			{
 				// check if anything to display
-				int sprite_bits;
-				const int sprite = hpos_index;
-				for (sprite_bits = 7; sprite_bits >= 0; --sprite_bits)
-				{
-					if (spriterow[sprite][sprite_bits])
-						break;
-				}
-				if (sprite_bits >= 0 && sprite_old_x - sprite_check_x <= 6 && sprite_old_x - sprite_check_x > 0)
+				const bool sprite_has_data = SpriteRowPlayerBits(sprite_bits, hpos_index) != 0;
+				if (sprite_has_data && sprite_old_x - sprite_check_x <= 6 && sprite_old_x - sprite_check_x > 0)
 					// too late to prevent display at old position
 					total_line_error += 100000;
-				if (sprite_bits >= 0 && sprite_new_x - sprite_check_x <= 6 && sprite_new_x - sprite_check_x > 0)
+				if (sprite_has_data && sprite_new_x - sprite_check_x <= 6 && sprite_new_x - sprite_check_x > 0)
 					// too late to change display to new position
 					total_line_error += 100000;
 			}
@@ -2700,8 +3460,9 @@ void Evaluator::MutateLine(raster_line& prog, raster_picture& pic)
     bool stuck = false;
     if (m_gstate) {
         unsigned long long thr = m_gstate->m_unstuck_after;
-        if (thr > 0 && m_gstate->m_evaluations > m_gstate->m_last_best_evaluation) {
-            unsigned long long plateau = m_gstate->m_evaluations - m_gstate->m_last_best_evaluation;
+        const unsigned long long clock = EvaluationClock();
+        if (thr > 0 && clock > m_gstate->m_last_best_evaluation) {
+            unsigned long long plateau = clock - m_gstate->m_last_best_evaluation;
             stuck = (plateau >= thr);
         }
     }
@@ -2714,15 +3475,16 @@ void Evaluator::MutateLine(raster_line& prog, raster_picture& pic)
     for (int i = 0; i < mutation_count; ++i) {
         MutateOnce(prog, pic);
     }
-	prog.rehash();
+	// MutateOnce keeps the hash current instruction by instruction.
+	assert(prog.hash == prog.content_hash());
 }
 
 void Evaluator::MutateOnce(raster_line& prog, raster_picture& pic)
 {
 	int i1, i2, c, x;
-	const RasterLineSchedule currentSchedule =
-		GetRasterLineSchedule(pic.graphics_mode, m_currently_mutated_y, m_height,
-			pic.playfield_width);
+	const RasterLineSchedule* schedules =
+		LineSchedules(pic.graphics_mode, pic.playfield_width);
+	const RasterLineSchedule& currentSchedule = schedules[m_currently_mutated_y];
 	const int currentCycleLimit = currentSchedule.optimizer_cycle_limit;
 	auto randomWritableTarget = [&]() -> e_target {
 		if (pic.graphics_mode == GraphicsMode::Antic4)
@@ -2750,6 +3512,9 @@ void Evaluator::MutateOnce(raster_line& prog, raster_picture& pic)
 	}
 
 	SRasterInstruction temp;
+	// Value edits below adjust prog.hash from the instruction they replaced.
+	const SRasterInstruction original = prog.instructions.empty()
+		? SRasterInstruction() : prog.instructions[i1];
 
 	// Use smart selection instead of random
 	int mutation = SelectMutation();
@@ -2765,6 +3530,7 @@ void Evaluator::MutateOnce(raster_line& prog, raster_picture& pic)
 			if (next_line.cycles > currentCycleLimit)
 				break;
 			prog = next_line;
+			prog.rehash();
 			m_current_mutations[E_MUTATION_COPY_LINE_TO_NEXT_ONE]++;
 			++m_mutation_applied_count[E_MUTATION_COPY_LINE_TO_NEXT_ONE];
 			++m_selector_applied_count[mutation];
@@ -2777,14 +3543,14 @@ void Evaluator::MutateOnce(raster_line& prog, raster_picture& pic)
 			int prev_y = m_currently_mutated_y - 1;
 			raster_line& prev_line = pic.raster_lines[prev_y];
 			c = GetInstructionCycles(prog.instructions[i1]);
-			const int previousLimit = GetRasterLineSchedule(
-				pic.graphics_mode, prev_y, m_height,
-				pic.playfield_width).optimizer_cycle_limit;
+			const int previousLimit = schedules[prev_y].optimizer_cycle_limit;
 			if (prev_line.cycles + c <= previousLimit)
 			{
 				// add it to prev line but do not remove it from the current
 				prev_line.cycles += c;
 				prev_line.instructions.push_back(prog.instructions[i1]);
+				prev_line.hash += raster_line::instruction_hash(
+					prev_line.instructions.size() - 1, prev_line.instructions.back());
 				prev_line.cache_key = NULL;
 				m_current_mutations[E_MUTATION_PUSH_BACK_TO_PREV]++;
 				++m_mutation_applied_count[E_MUTATION_PUSH_BACK_TO_PREV];
@@ -2798,12 +3564,12 @@ void Evaluator::MutateOnce(raster_line& prog, raster_picture& pic)
 		{
 			int prev_y = m_currently_mutated_y - 1;
 			raster_line& prev_line = pic.raster_lines[prev_y];
-			const int previousLimit = GetRasterLineSchedule(
-				pic.graphics_mode, prev_y, m_height,
-				pic.playfield_width).optimizer_cycle_limit;
+			const int previousLimit = schedules[prev_y].optimizer_cycle_limit;
 			if (prog.cycles > previousLimit || prev_line.cycles > currentCycleLimit)
 				break;
 			prog.swap(prev_line);
+			prog.rehash();
+			prev_line.rehash();
 			m_current_mutations[E_MUTATION_SWAP_LINE_WITH_PREV_ONE]++;
 			++m_mutation_applied_count[E_MUTATION_SWAP_LINE_WITH_PREV_ONE];
 			++m_selector_applied_count[mutation];
@@ -2825,6 +3591,7 @@ void Evaluator::MutateOnce(raster_line& prog, raster_picture& pic)
 					std::swap(prog.instructions[i], prog.instructions[i - 1]);
 				}
 
+				prog.rehash();
 				prog.cache_key = NULL;
 				prog.cycles += 4;
 			}
@@ -2849,6 +3616,7 @@ void Evaluator::MutateOnce(raster_line& prog, raster_picture& pic)
 					std::swap(prog.instructions[i], prog.instructions[i - 1]);
 				}
 
+				prog.rehash();
 				prog.cache_key = NULL;
 				prog.cycles += 2;
 			}
@@ -2869,6 +3637,7 @@ void Evaluator::MutateOnce(raster_line& prog, raster_picture& pic)
 				// Preserve order: erase at position i1
 				prog.instructions.erase(prog.instructions.begin() + i1);
 
+				prog.rehash();
 				prog.cache_key = NULL;
 				assert(prog.cycles > 0);
 				m_current_mutations[E_MUTATION_REMOVE_INSTRUCTION]++;
@@ -2885,6 +3654,8 @@ void Evaluator::MutateOnce(raster_line& prog, raster_picture& pic)
 			temp = prog.instructions[i1];
 			prog.instructions[i1] = prog.instructions[i2];
 			prog.instructions[i2] = temp;
+			prog.instruction_changed(i1, original);
+			prog.instruction_changed(i2, prog.instructions[i1]);
 			prog.cache_key = NULL;
 			m_current_mutations[E_MUTATION_SWAP_INSTRUCTION]++;
 			++m_mutation_applied_count[E_MUTATION_SWAP_INSTRUCTION];
@@ -2894,6 +3665,7 @@ void Evaluator::MutateOnce(raster_line& prog, raster_picture& pic)
 	case E_MUTATION_CHANGE_TARGET:
 		++m_mutation_attempt_count[E_MUTATION_CHANGE_TARGET];
 		prog.instructions[i1].loose.target = randomWritableTarget();
+		prog.instruction_changed(i1, original);
 		prog.cache_key = NULL;
 		m_current_mutations[E_MUTATION_CHANGE_TARGET]++;
 		++m_mutation_applied_count[E_MUTATION_CHANGE_TARGET];
@@ -2920,6 +3692,7 @@ void Evaluator::MutateOnce(raster_line& prog, raster_picture& pic)
 				c *= 16;
 			prog.instructions[i1].loose.value += c;
 		}
+		prog.instruction_changed(i1, original);
 		prog.cache_key = NULL;
 		m_current_mutations[E_MUTATION_CHANGE_VALUE]++;
 		++m_mutation_applied_count[E_MUTATION_CHANGE_VALUE];
@@ -2960,6 +3733,7 @@ void Evaluator::MutateOnce(raster_line& prog, raster_picture& pic)
 		while (Random(5) == 0 && i2 + 1 < (int)m_height)
 			++i2;
 		prog.instructions[i1].loose.value = FindAtariColorIndex(m_picture[i2][x]) * 2;
+		prog.instruction_changed(i1, original);
 		prog.cache_key = NULL;
 		m_current_mutations[E_MUTATION_CHANGE_VALUE_TO_COLOR]++;
 		++m_mutation_applied_count[E_MUTATION_CHANGE_VALUE_TO_COLOR];
@@ -3001,6 +3775,7 @@ void Evaluator::MutateOnce(raster_line& prog, raster_picture& pic)
 				if (xx < 0 || xx >= (int)m_width) xx = Random(m_width);
 				int yy = m_currently_mutated_y; while (Random(5) == 0 && yy + 1 < (int)m_height) ++yy;
 				prog.instructions[i1].loose.value = FindAtariColorIndex(m_picture[yy][xx]) * 2;
+				prog.instruction_changed(i1, original);
 				prog.cache_key = NULL;
 				m_current_mutations[E_MUTATION_CHANGE_VALUE_TO_COLOR]++;
 				++m_mutation_attempt_count[E_MUTATION_CHANGE_VALUE_TO_COLOR];
@@ -3094,6 +3869,7 @@ void Evaluator::MutateOnce(raster_line& prog, raster_picture& pic)
 			}
 
 			prog.instructions[i1].loose.value = (unsigned char)(bestIdx * 2);
+			prog.instruction_changed(i1, original);
 			prog.cache_key = NULL;
 			m_current_mutations[E_MUTATION_COMPLEMENT_VALUE_DUAL]++;
 			++m_mutation_applied_count[E_MUTATION_COMPLEMENT_VALUE_DUAL];
@@ -3117,7 +3893,8 @@ void Evaluator::RestoreMutationTransaction(RasterMutationTransaction& transactio
 	transaction.Restore(m_allocator_epoch);
 }
 
-void Evaluator::MutateRasterProgram(raster_picture* pic, RasterMutationTransaction* transaction)
+void Evaluator::MutateRasterProgram(raster_picture* pic, RasterMutationTransaction* transaction,
+	const line_cache_result** line_results, AcceptedLineResults* accepted)
 {
 	// Evaluation owns m_active_raster_picture only while its stack frame is
 	// live. Mutation must use the candidate passed here, never stale context
@@ -3129,8 +3906,9 @@ void Evaluator::MutateRasterProgram(raster_picture* pic, RasterMutationTransacti
 	bool stuck = false;
 	if (m_gstate) {
 		unsigned long long thr = m_gstate->m_unstuck_after;
-		if (thr > 0 && m_gstate->m_evaluations > m_gstate->m_last_best_evaluation) {
-			stuck = (m_gstate->m_evaluations - m_gstate->m_last_best_evaluation) >= thr;
+		const unsigned long long clock = EvaluationClock();
+		if (thr > 0 && clock > m_gstate->m_last_best_evaluation) {
+			stuck = (clock - m_gstate->m_last_best_evaluation) >= thr;
 		}
 	}
 
@@ -3154,9 +3932,12 @@ void Evaluator::MutateRasterProgram(raster_picture* pic, RasterMutationTransacti
 		else
 			m_currently_mutated_y = SelectAllocatedLine(region_start, region_end);
 	} else {
-		// Prefer mutating lines in this thread's region (80% of the time)
+		// Prefer mutating lines in this thread's region (80% of the time),
+		// weighted by how far each accepted line is from its error floor
 		if (Random(100) < 80 && region_end > region_start) {
-			m_currently_mutated_y = region_start + Random(region_end - region_start);
+			m_currently_mutated_y = m_line_headroom.Size() == m_height
+				? SelectWeightedLine(m_line_headroom, region_start, region_end)
+				: region_start + Random(region_end - region_start);
 		}
 		// Otherwise, allow some exploration outside the region (20% of time)
 		else if (m_currently_mutated_y >= (int)pic->raster_lines.size()) {
@@ -3172,10 +3953,10 @@ void Evaluator::MutateRasterProgram(raster_picture* pic, RasterMutationTransacti
 	// measurable, and tests exactly one coupled 4x8 cell at a time.
 	if (pic->graphics_mode == GraphicsMode::Antic4 && Random(12) == 0)
 	{
-		if (transaction)
-			transaction->SaveMemory();
 		const int characterRow =
 			Random(static_cast<int>(pic->antic4_attributes.size()));
+		if (transaction)
+			transaction->SaveAttributes(characterRow * 8, characterRow * 8 + 7);
 		const int column = Random(
 			PlayfieldVisibleCharacters(pic->playfield_width));
 		pic->set_antic4_attribute(characterRow, column,
@@ -3211,9 +3992,18 @@ void Evaluator::MutateRasterProgram(raster_picture* pic, RasterMutationTransacti
 		pic->mem_regs_init[targ] += c;
 	}
 	raster_line& current_line = pic->raster_lines[m_currently_mutated_y];
+	// Alternatives share their entry state only while nothing above the
+	// mutated neighborhood has changed.
+	const bool lineCandidates = transaction && line_results && accepted
+		&& m_gstate->m_line_candidates > 1
+		&& accepted->valid && accepted->cache_generation == m_line_cache_generation
+		&& transaction->DirtyFirst() > transaction->DirtyLast();
 	if (transaction)
 		transaction->SaveMutationNeighborhood(m_currently_mutated_y);
-	MutateLine(current_line, *pic);
+	if (lineCandidates)
+		MutateLineCandidates(*pic, *transaction, line_results, *accepted);
+	else
+		MutateLine(current_line, *pic);
 
     // Longer multi-line chains when stuck
     int chain_prob = stuck ? 5 : 20;
@@ -3247,32 +4037,98 @@ void Evaluator::MutateRasterProgram(raster_picture* pic, RasterMutationTransacti
 		}
 	}
 
-	// recache any lines that have changed
-	for (int y = 0; y < (int)m_height; ++y) {
-		raster_line& rline = pic->raster_lines[y];
-		if (rline.cache_key == NULL)
-			rline.recache_insns(m_insn_seq_cache, m_insn_allocator);
+	// recache any lines that have changed; a transaction knows which ones
+	if (transaction)
+		transaction->RecacheSavedLines(m_insn_seq_cache, m_insn_allocator);
+	else
+	{
+		for (int y = 0; y < (int)m_height; ++y) {
+			raster_line& rline = pic->raster_lines[y];
+			if (rline.cache_key == NULL)
+				rline.recache_insns(m_insn_seq_cache, m_insn_allocator);
+		}
 	}
 	assert(ValidateRasterPicture(*pic) == E_RASTER_VALID);
 }
 
+void Evaluator::MutateLineCandidates(raster_picture& pic, RasterMutationTransaction& transaction,
+	const line_cache_result** line_results, AcceptedLineResults& accepted)
+{
+	// MutateOnce may also rewrite the lines next to the mutated one.
+	const int y = m_currently_mutated_y;
+	const int first = std::max(0, y - 1);
+	const int last = std::min(static_cast<int>(m_height) - 1, y + 1);
+	const int count = last - first + 1;
+	for (int i = 0; i < count; ++i)
+		m_candidate_original_lines[i] = pic.raster_lines[first + i];
+	int startMutations[E_MUTATION_MAX];
+	int bestMutations[E_MUTATION_MAX];
+	memcpy(startMutations, m_current_mutations, sizeof startMutations);
+
+	const int candidates = m_gstate->m_line_candidates;
+	distance_accum_t bestError = 0;
+	int best = -1;
+	for (int candidate = 0; candidate < candidates; ++candidate)
+	{
+		if (candidate > 0)
+		{
+			for (int i = 0; i < count; ++i)
+				pic.raster_lines[first + i] = m_candidate_original_lines[i];
+			memcpy(m_current_mutations, startMutations, sizeof startMutations);
+		}
+		MutateLine(pic.raster_lines[y], pic);
+		transaction.RecacheSavedLines(m_insn_seq_cache, m_insn_allocator);
+		// Every alternative's window lands in the line cache, so the full
+		// evaluation of the one kept finds its lines there.
+		const distance_accum_t error = EvaluateLineWindow(
+			&pic, line_results, transaction, accepted, last + 1);
+		++m_local_line_candidate_evaluations;
+		if (!accepted.valid)
+		{
+			// The render had to clear the line cache, so the accepted results
+			// the alternatives were scored against are gone; keep this one.
+			return;
+		}
+		if (best < 0 || error < bestError)
+		{
+			best = candidate;
+			bestError = error;
+			memcpy(bestMutations, m_current_mutations, sizeof bestMutations);
+			if (candidate + 1 < candidates)
+			{
+				for (int i = 0; i < count; ++i)
+					m_candidate_best_lines[i] = pic.raster_lines[first + i];
+			}
+		}
+	}
+
+	if (best != candidates - 1)
+	{
+		for (int i = 0; i < count; ++i)
+			pic.raster_lines[first + i].swap(m_candidate_best_lines[i]);
+		memcpy(m_current_mutations, bestMutations, sizeof bestMutations);
+	}
+	if (best > 0)
+		++m_local_line_candidate_switches;
+}
+
 int Evaluator::SelectAllocatedLine(int first, int last)
 {
 	first = std::max(0, first);
-	last = std::min(static_cast<int>(m_allocation_line_weights.size()), last);
+	last = std::min(static_cast<int>(m_allocation_tree.Size()), last);
 	if (last <= first) return Random(static_cast<int>(m_height));
-	double total = 0.0;
-	for (int y = first; y < last; ++y)
-		total += std::max(0.0, m_allocation_line_weights[y]);
-	if (!(total > 0.0)) return first + Random(last - first);
-	const double target = total * Random(1000000) / 1000000.0;
-	double cumulative = 0.0;
-	for (int y = first; y < last; ++y)
-	{
-		cumulative += std::max(0.0, m_allocation_line_weights[y]);
-		if (target < cumulative) return y;
-	}
-	return last - 1;
+	return SelectWeightedLine(m_allocation_tree, first, last);
+}
+
+template<typename T>
+int Evaluator::SelectWeightedLine(const LineWeightTree<T>& tree, int first, int last)
+{
+	const T base = tree.Prefix(static_cast<size_t>(first));
+	const T total = tree.Prefix(static_cast<size_t>(last)) - base;
+	if (!(total > T{})) return first + Random(last - first);
+	const T target = static_cast<T>(total * (Random(1000000) / 1000000.0));
+	const int y = static_cast<int>(tree.Find(base + target));
+	return std::min(std::max(y, first), last - 1);
 }
 
 void Evaluator::CaptureRegisterState(register_state& rs) const
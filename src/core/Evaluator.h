@@ -2,27 +2,35 @@
 #define EVALUATOR_H
 
 // Retired line-order tracking can be restored for regression diagnostics with
-// -DRASTA_TRACK_LINE_LRU=1. Result eviction is generation-wide and does not
-// consume this ordering in production.
+// -DRASTA_TRACK_LINE_LRU=1. Nothing evicts by this ordering: line results
+// are recycled by the CLOCK hand in line_cache_slots.
 #ifndef RASTA_TRACK_LINE_LRU
 #define RASTA_TRACK_LINE_LRU 0
 #endif
 
+#include <climits>
 #include <vector>
 #include <map>
 #include <mutex>
 #include <condition_variable>
 
+#include "CompactErrorMap.h"
 #include "Distance.h"
+#include "EvaluationCounters.h"
 #include "VisualObjective.h"
 
 struct StructuredBeamOptions;
 struct StructuredPairedWindowResult;
 struct StructuredPairedWindowProblem;
+struct PlayfieldSpanRegisters;
+struct CompactPlayfieldSpanRegisters;
 #include "Program.h"
 #include "LinearAllocator.h"
 #include "LineCache.h"
+#include "SharedLineCache.h"
+#include "LineWeightTree.h"
 #include "OptimizerState.h"
+#include "IslandTopology.h"
 #include <atomic>
 #include <cfloat>
 #include <memory>
@@ -40,13 +48,26 @@ class RasterMutationTransaction
 {
 public:
 	void Begin(raster_picture& picture, unsigned long long allocatorEpoch);
+	// Initial registers feed line 0, so saving them dirties it.
 	void SaveMemory();
+	// ANTIC 4 attributes only feed the lines of their character row.
+	void SaveAttributes(int firstLine, int lastLine);
 	void SaveLine(int y);
 	void SaveMutationNeighborhood(int y);
+	// Interns the saved lines whose instructions changed and marks them
+	// dirty. Saved lines that ended up unchanged keep their old key.
+	void RecacheSavedLines(insn_sequence_cache& cache, linear_allocator& alloc);
 	void Restore(unsigned long long allocatorEpoch);
 	unsigned long long SavedLineCount() const;
+	// Lines whose cache key may differ from the picture before Begin(); empty
+	// when DirtyFirst() > DirtyLast().
+	int DirtyFirst() const { return m_dirty_first; }
+	int DirtyLast() const { return m_dirty_last; }
 
 private:
+	void SnapshotMemory();
+	void MarkDirty(int first, int last);
+
 	raster_picture* m_picture = nullptr;
 	std::vector<raster_line> m_snapshots;
 	std::vector<unsigned char> m_saved;
@@ -55,6 +76,30 @@ private:
 	std::vector<uint64_t> m_attribute_snapshot;
 	bool m_memory_saved = false;
 	unsigned long long m_allocator_epoch = 0;
+	int m_dirty_first = 0;
+	int m_dirty_last = -1;
+};
+
+// Line results of a worker's accepted picture. While valid, the caller's
+// result array holds them, except for the lines the last transactional
+// candidate replaced; those accepted pointers are kept here so a rejection
+// can put them back without rendering.
+struct AcceptedLineResults
+{
+	bool valid = false;
+	unsigned long long cache_generation = 0;
+	distance_accum_t total_error = 0;
+	// prefix_error[y] is the accepted error of lines [0, y).
+	std::vector<distance_accum_t> prefix_error;
+	int replaced_first = 0;
+	std::vector<const line_cache_result*> replaced;
+	// Set per candidate: once its error provably exceeds rejection_limit the
+	// render stops, returns that lower bound and sets stopped_early.
+	double rejection_limit = DBL_MAX;
+	bool stopped_early = false;
+	// Lines from render_end on are not rendered; the render returns the
+	// candidate's error over lines [0, render_end) instead of the frame's.
+	int render_end = INT_MAX;
 };
 
 struct OnOffMap
@@ -72,11 +117,17 @@ typedef std::vector<statistics_point> statistics_list;
 
 struct EvalGlobalState
 {
+	// Immutable once published; workers and the coordinator share it through
+	// std::atomic_load/store on m_best_snapshot. It holds the program only:
+	// rows are rendered from it by whoever displays or saves it.
 	struct PublishedBestSnapshot
 	{
 		raster_picture picture;
 		double cost = DBL_MAX;
 		unsigned long long version = 0;
+		// Acceptance history of the island that found it, for the
+		// .optstate file; not initialized when published by the coordinator.
+		OptimizerState optimizer;
 	};
 	std::vector < std::vector < unsigned char > > m_possible_colors_for_each_line;
 
@@ -100,8 +151,13 @@ struct EvalGlobalState
 
 	unsigned long long m_save_period;
 	unsigned long long m_max_evals;
-	std::atomic<unsigned long long> m_evaluations;
-	std::atomic<unsigned long long> m_last_best_evaluation;
+	// Evaluation numbers handed out. Single-frame island workers take them in
+	// batches (Evaluator::NextEvaluationNumber), so this line is written once
+	// per batch rather than once per evaluation; CompletedEvaluations() leaves
+	// out the reserved numbers not used yet. Kept apart from the fields every
+	// worker reads on each evaluation.
+	alignas(64) std::atomic<unsigned long long> m_evaluations;
+	alignas(64) std::atomic<unsigned long long> m_last_best_evaluation;
 
 	raster_picture m_best_pic;
 	std::atomic<double> m_best_result;
@@ -111,7 +167,7 @@ struct EvalGlobalState
 	std::vector < color_index_line > m_created_picture;
 	std::vector < line_target > m_created_picture_targets;
 
-	int m_mutation_stats[E_MUTATION_MAX];
+	std::atomic<int> m_mutation_stats[E_MUTATION_MAX]{};
 
 	// Number of threads configured (add this)
 	int m_thread_count;
@@ -178,8 +234,15 @@ struct EvalGlobalState
 	std::atomic<unsigned long long> m_migration_copy_ns{0};
 	std::atomic<unsigned long long> m_migration_lines_copied{0};
 	std::atomic<unsigned long long> m_migration_lines_reused{0};
-	std::atomic<unsigned long long> m_single_cache_partial_clears{0};
-	std::atomic<unsigned long long> m_single_cache_full_clears{0};
+	std::atomic<unsigned long long> m_cache_evictions{0};
+	std::atomic<unsigned long long> m_cache_eviction_skips{0};
+	std::atomic<unsigned long long> m_cache_slot_overflows{0};
+	std::atomic<unsigned long long> m_cache_trace_clears{0};
+	std::atomic<unsigned long long> m_cache_budget_resets{0};
+	std::atomic<unsigned long long> m_shared_cache_lookups{0};
+	std::atomic<unsigned long long> m_shared_cache_hits{0};
+	std::atomic<unsigned long long> m_shared_cache_publishes{0};
+	std::atomic<unsigned long long> m_shared_cache_rejected_publishes{0};
 	std::atomic<unsigned long long> m_single_candidate_full_copies{0};
 	std::atomic<unsigned long long> m_single_undo_candidates{0};
 	std::atomic<unsigned long long> m_single_undo_line_snapshots{0};
@@ -190,11 +253,18 @@ struct EvalGlobalState
 	std::atomic<unsigned long long> m_cache_lookup_probes{0};
 	std::atomic<unsigned long long> m_cache_max_lookup_probes{0};
 	std::atomic<unsigned long long> m_cache_inserts{0};
-	std::atomic<unsigned long long> m_cache_hash_blocks{0};
+	std::atomic<unsigned long long> m_cache_table_growths{0};
 	std::atomic<unsigned long long> m_cache_entry_bytes{0};
-	std::atomic<unsigned long long> m_cache_hash_block_bytes{0};
+	std::atomic<unsigned long long> m_cache_table_bytes{0};
 	std::atomic<unsigned long long> m_cache_color_row_bytes{0};
 	std::atomic<unsigned long long> m_cache_target_row_bytes{0};
+	std::atomic<unsigned long long> m_cache_trace_bytes{0};
+	std::atomic<unsigned long long> m_cache_retained_bytes{0};
+	std::atomic<unsigned long long> m_cache_huge_page_bytes{0};
+	std::atomic<unsigned long long> m_cache_chunk_allocations{0};
+	std::atomic<unsigned long long> m_cache_chunk_reuses{0};
+	std::atomic<unsigned long long> m_minor_page_faults{0};
+	std::atomic<unsigned long long> m_major_page_faults{0};
 	std::atomic<unsigned long long> m_insn_cache_hash_block_bytes{0};
 	std::atomic<unsigned long long> m_insn_cache_data_bytes{0};
 	std::atomic<unsigned long long> m_cache_evaluations{0};
@@ -205,6 +275,17 @@ struct EvalGlobalState
 	std::atomic<unsigned long long> m_cache_propagation_span{0};
 	std::atomic<unsigned long long> m_cache_max_propagation_span{0};
 	std::atomic<unsigned long long> m_cache_pmg_restarts{0};
+	std::atomic<unsigned long long> m_cache_player_free_lines{0};
+	std::atomic<unsigned long long> m_cache_trace_hits{0};
+	std::atomic<unsigned long long> m_cache_trace_inserts{0};
+	std::atomic<unsigned long long> m_cache_dirty_range_evaluations{0};
+	std::atomic<unsigned long long> m_cache_prefix_lines{0};
+	std::atomic<unsigned long long> m_cache_spliced_lines{0};
+	std::atomic<unsigned long long> m_cache_bound_rejections{0};
+	std::atomic<unsigned long long> m_cache_bound_skipped_lines{0};
+	std::atomic<unsigned long long> m_cache_bound_retries{0};
+	std::atomic<unsigned long long> m_line_candidate_evaluations{0};
+	std::atomic<unsigned long long> m_line_candidate_switches{0};
 	std::atomic<unsigned long long> m_lru_updates{0};
 	std::atomic<unsigned long long> m_lru_search_steps{0};
 	std::vector<unsigned long long> m_cache_hits_by_line;
@@ -225,11 +306,63 @@ struct EvalGlobalState
 
 	// Aggressive search trigger threshold (0 = never)
 	unsigned long long m_unstuck_after = 1000000ULL;
+	// /line_candidates: alternatives proposed per primary line mutation
+	int m_line_candidates = 1;
+	// /shared_cache: line results every single-frame worker can adopt on a
+	// private miss. Cleared only while the workers are paused.
+	shared_line_cache m_shared_line_cache;
 	// Normalized drift per evaluation added to acceptance thresholds when stuck
 	double m_unstuck_drift_norm = 0.0;
-	// Current normalized drift applied (for UI/reporting)
+	// Current normalized drift applied (for UI/reporting). Island workers do
+	// not write it; the coordinator refreshes it from NormalizedDrift().
 	std::atomic<double> m_current_norm_drift{0.0};
 
+	// One slot per worker thread, indexed by thread id.
+	std::unique_ptr<EvalWorkerCounters[]> m_worker_counters;
+	size_t m_worker_counter_count = 0;
+
+	// /islands. One slot per single-frame worker, indexed by thread id; only
+	// the owning worker writes it.
+	struct alignas(64) IslandSlot
+	{
+		// Refreshed every few thousand evaluations for LiveStats.
+		std::atomic<unsigned long long> evaluations{0};
+		std::atomic<unsigned long long> accepted{0};
+		std::atomic<unsigned long long> immigrants{0};
+		std::atomic<double> current_cost{DBL_MAX};
+		std::atomic<double> best_cost{DBL_MAX};
+		// What the island offers its neighbours, replaced at each of its
+		// migration intervals. Loaded and stored with std::atomic_*.
+		std::shared_ptr<const PublishedBestSnapshot> emigrant;
+	};
+	IslandTopology m_island_topology = IslandTopology::Global;
+	// Per island, the islands it takes migrants from.
+	std::vector<std::vector<int>> m_island_sources;
+	unsigned long long m_migrate_every = 50000ULL;
+	double m_migrate_rate = 1.0;
+	bool m_migrate_elite = false;
+	std::unique_ptr<IslandSlot[]> m_islands;
+	size_t m_island_count = 0;
+
+	// Makes snapshot the published best if it beats both m_best_result and
+	// the snapshot already published, with one compare-and-swap and no lock.
+	// Raises m_best_result and m_best_state_version to match. Returns the
+	// version it was published as, or 0 when a better one was already there.
+	unsigned long long PublishBestSnapshot(std::shared_ptr<PublishedBestSnapshot> snapshot,
+		unsigned long long evaluation);
+
+	// Also resets the island slots, one per worker.
+	void ResetWorkerCounters(size_t workers);
+	// Drops every island's offer; their costs are on the scale of an
+	// objective that just changed. Workers must be paused.
+	void ClearEmigrants();
+	// Evaluations finished or in progress: m_evaluations less the numbers the
+	// workers reserved but have not reached. Equals m_evaluations once every
+	// worker stopped.
+	unsigned long long CompletedEvaluations() const;
+	// The /unstuck_drift_norm drift at the given evaluation number.
+	double NormalizedDrift(unsigned long long evaluation) const;
+
 
 	EvalGlobalState();
 	~EvalGlobalState();
@@ -269,25 +402,82 @@ public:
 
 	void Run();
 
-	e_target FindClosestColorRegister(sprites_row_memory_t& spriterow,
+	// The render loop and its pixel scorers are instantiated per RenderPolicy
+	// (Evaluator.cpp): graphics mode, playfield width and single or dual
+	// objective are compile-time constants inside them.
+	// Both resolvers report in `pixel_mask` the player data bits the pixel
+	// reads (see SpriteRowBit) and may set one of them in `sprite_bits`.
+	template<class Policy>
+	e_target FindClosestColorRegister(uint32_t& sprite_bits,
 		int index, int x, int y, bool& restart_line, distance_t& error,
-		unsigned char& output_color);
-	e_target FindClosestColorRegisterDual(sprites_row_memory_t& spriterow,
+		unsigned char& output_color, uint32_t& pixel_mask);
+	template<class Policy>
+	e_target FindClosestColorRegisterDual(uint32_t& sprite_bits,
 		const unsigned char* other_row, unsigned picture_row_index, int x,
-		bool& restart_line, distance_t& error);
+		bool& restart_line, distance_t& error, uint32_t& pixel_mask);
+	// What a pixel was last scored against: the data bits it reads and their
+	// values at the time. A pixel whose bits are unchanged scores the same.
+	struct PlayerPixelRecord
+	{
+		distance_t error;
+		uint32_t mask;
+		uint32_t seen;
+	};
+	template<class Policy>
+	distance_t ScorePlayerPixel(uint32_t& sprite_bits,
+		const unsigned char* other_row, int picture_row_index, int y, int x,
+		bool& restart_line, unsigned char* color_row, unsigned char* target_row,
+		PlayerPixelRecord& record);
+	// Scores pixels [first, end) of a constant-register span. Single-frame
+	// runs no player covers go through the playfield span kernel; the rest
+	// are resolved pixel by pixel and recorded in `records`.
+	template<class Policy>
+	distance_accum_t ScorePixelRun(uint32_t& sprite_bits,
+		const unsigned char* other_row, int picture_row_index, int y,
+		int first, int end, bool& restart_line,
+		unsigned char* color_row, unsigned char* target_row,
+		PlayerPixelRecord* records);
+	// Scores pixels [first, end) of a span on a line no player reaches.
+	template<class Policy>
+	distance_accum_t ScorePlayfieldRun(const unsigned char* other_row,
+		int picture_row_index, int y, int first, int end,
+		unsigned char* color_row, unsigned char* target_row);
+	template<class Policy>
+	void LoadPlayfieldSpanRegisters(int picture_row_index, int y,
+		PlayfieldSpanRegisters& registers,
+		CompactPlayfieldSpanRegisters& compactRegisters) const;
+	template<class Policy>
+	distance_accum_t RenderRasterProgram(raster_picture* pic,
+		const line_cache_result** results_array,
+		const std::vector<const unsigned char*>* other_rows,
+		const RasterMutationTransaction* transaction = nullptr,
+		AcceptedLineResults* accepted = nullptr);
 	void TurnOffRegisters(raster_picture *pic);
-	distance_accum_t ExecuteRasterProgram(raster_picture *pic, const line_cache_result **results);
+	distance_accum_t ExecuteRasterProgram(raster_picture *pic, const line_cache_result **results,
+		const RasterMutationTransaction* transaction = nullptr,
+		AcceptedLineResults* accepted = nullptr);
+	// Per-line DMA schedules of the current picture shape. They depend only on
+	// mode, width and height, so the table is rebuilt when one of those changes.
+	const RasterLineSchedule* LineSchedules(GraphicsMode mode, PlayfieldWidth width);
 
 	template<fn_rgb_distance& T_distance_function>
 	distance_accum_t CalculateLineDistance(const screen_line &r, const screen_line &l);
 
 	//inline void ExecuteInstruction(const SRasterInstruction &instr, int x);
-	inline void ExecuteInstruction(const SRasterInstruction &instr, int sprite_check_x, sprites_row_memory_t &spriterow, distance_accum_t &total_line_error);
+	inline void ExecuteInstruction(const SRasterInstruction &instr, int sprite_check_x, uint32_t sprite_bits, distance_accum_t &total_line_error);
 
-	void MutateRasterProgram(raster_picture *pic, RasterMutationTransaction* transaction = nullptr);
+	// With a transaction and the accepted results it was taken against, the
+	// primary line mutation may be chosen among /line_candidates alternatives.
+	void MutateRasterProgram(raster_picture *pic, RasterMutationTransaction* transaction = nullptr,
+		const line_cache_result** line_results = nullptr, AcceptedLineResults* accepted = nullptr);
 	void BeginMutationTransaction(raster_picture& pic, RasterMutationTransaction& transaction);
 	void RestoreMutationTransaction(RasterMutationTransaction& transaction);
 	void MutateLine(raster_line &, raster_picture &pic);
+	// Mutates m_currently_mutated_y m_gstate->m_line_candidates times from
+	// the same starting lines and keeps the alternative with the least error
+	// over the lines it can touch, rendered from their shared entry state.
+	void MutateLineCandidates(raster_picture& pic, RasterMutationTransaction& transaction,
+		const line_cache_result** line_results, AcceptedLineResults& accepted);
 	void MutateOnce(raster_line &, raster_picture &pic);
 
 	int Random(int range);
@@ -297,6 +487,9 @@ public:
 
 	// Access sprites memory for saving exports (read-only)
 	const sprites_memory_t& GetSpritesMemory() const { return m_sprites_memory; }
+	// Bumped whenever the instruction allocator is cleared; pictures kept
+	// across evaluations must drop their cache keys when it changes.
+	unsigned long long AllocatorEpoch() const { return m_allocator_epoch; }
 	const std::vector<color_index_line>& GetCreatedPicture() const { return m_created_picture; }
 	const std::vector<line_target>& GetCreatedPictureTargets() const { return m_created_picture_targets; }
 
@@ -331,6 +524,25 @@ public:
 	// Configure temporal penalty weights
 	void SetDualTemporalWeights(float luma, float chroma);
 
+	// Score single-frame pixels from a /errmap=compact map instead of the exact
+	// planes (nullptr restores them). The map is not owned and must outlive
+	// every evaluation; cached line results from the other map are stale.
+	void SetCompactErrorMap(const CompactErrorMap* map)
+	{
+		m_compact_errors = map;
+		m_line_error_floor.clear();
+	}
+
+	// /pin: the CPU Run() pins its thread to before touching its arenas;
+	// -1 leaves the thread unpinned.
+	void SetPlacementCpu(int cpu) { m_placement_cpu = cpu; }
+	int PlacementCpu() const { return m_placement_cpu; }
+
+	// /lean_cache: cached line results keep only their scalars, not their
+	// colour and target rows, so the same budget holds several times more
+	// lines. Drops every cached line; set before the evaluator runs.
+	void SetLeanLineCache(bool lean);
+
 	// Flush this evaluator's current mutation counters into the shared
 	// global-best contribution stats. Intended to be called only on
 	// genuine improvements to minimize overhead.
@@ -350,13 +562,44 @@ public:
 	void FlushMutationDiagnosticsToGlobal();
 	void FlushCacheDiagnosticsToGlobal();
 	// Return the current absolute acceptance drift for a worker-local optimizer
-	// state. The normalized value remains published for UI/reporting.
+	// state, measured at this worker's evaluation clock.
 	double CalculateAcceptanceDrift();
 	AcceptanceOutcome ApplyAcceptanceCore(double result, bool force_best = false, 
 		const raster_picture* new_picture = nullptr, const line_cache_result** line_results = nullptr);
 
 	// Thin wrappers for clarity (no extra runtime cost expected)
 	distance_accum_t EvaluateSingle(raster_picture* pic, const line_cache_result** line_results);
+	// EvaluateSingle for callers that read the results' colour and target
+	// rows. A lean line cache keeps none, so every line is rendered again into
+	// rows this evaluator owns until its next render.
+	distance_accum_t EvaluateWithRows(raster_picture* pic, const line_cache_result** line_results);
+	// Evaluates a transactional candidate whose accepted results are still in
+	// `line_results`. Lines above the transaction's dirty range keep them
+	// without a lookup; below it, rendering stops at the first line entered
+	// with the accepted register state and the rest is spliced in. Falls back
+	// to a full render when `accepted` is not valid for the current cache.
+	// A candidate whose error plus the error floor of its unrendered lines
+	// exceeds `rejection_limit` is abandoned part way; see stopped_early.
+	distance_accum_t EvaluateTransaction(raster_picture* pic,
+		const line_cache_result** line_results,
+		const RasterMutationTransaction& transaction,
+		AcceptedLineResults& accepted,
+		double rejection_limit = DBL_MAX);
+	// Error of a transactional candidate's lines [0, end_line), rendering
+	// only its dirty lines above end_line; `line_results` is left as it was.
+	distance_accum_t EvaluateLineWindow(raster_picture* pic,
+		const line_cache_result** line_results,
+		const RasterMutationTransaction& transaction,
+		AcceptedLineResults& accepted, int end_line);
+	// `line_results` now holds the accepted picture's full render. Also
+	// refreshes the headroom weights of the lines that changed and publishes
+	// them to the shared tier.
+	void AcceptLineResults(AcceptedLineResults& accepted, distance_accum_t total_error,
+		const line_cache_result* const* line_results, GraphicsMode mode);
+	void PublishSharedLine(int y, uint32_t slot, GraphicsMode mode);
+	// Puts back the accepted results a rejected transactional candidate replaced.
+	void RejectLineResults(AcceptedLineResults& accepted,
+		const line_cache_result** line_results);
 	distance_accum_t EvaluateUnweightedSource(raster_picture* pic);
 	StructuredWindowComparison CompareStructuredWindow(
 		const raster_picture& baseline,
@@ -404,6 +647,7 @@ public:
 
 private:
 	int m_thread_id;
+	int m_placement_cpu = -1;
 	// The retired ordering implementation remains build-selectable for regression
 	// diagnosis, but production calls compile to no-ops.
 #if RASTA_TRACK_LINE_LRU
@@ -416,6 +660,7 @@ private:
 	inline void ClearLineActivity() {}
 #endif
 	void ClearLineCacheGeneration();
+	void ClearLineTraces();
 	void RecordCacheEvaluation(unsigned recomputedLines, int firstMissLine, int lastMissLine);
 
 	unsigned long long m_mutation_accepted_count[E_MUTATION_MAX];
@@ -461,6 +706,19 @@ private:
 	unsigned m_width;
 	unsigned m_height;
 	const distance_t *const *m_picture_all_errors;
+	const CompactErrorMap* m_compact_errors = nullptr;
+	// Error of palette colour `color` at pixel (x, y); index is the pixel's
+	// offset in the exact planes.
+	distance_t PixelError(int color, int index, int x, int y) const
+	{
+		return m_compact_errors ? m_compact_errors->At(color, y, x)
+			: m_picture_all_errors[color][index];
+	}
+	// m_line_error_floor[y] is the least error lines [y, height) can have:
+	// every pixel's error against its closest palette colour. Built on first
+	// use and dropped whenever the error planes may have changed.
+	std::vector<distance_accum_t> m_line_error_floor;
+	const distance_accum_t* LineErrorFloor();
 	bool m_use_dual_neon = false;
 	const screen_line *m_picture;
 	const raster_picture* m_active_raster_picture = nullptr;
@@ -481,24 +739,43 @@ private:
 	DisplayFilteredObjective m_visual_objective;
 	int m_currently_mutated_y;
 	int SelectAllocatedLine(int first, int last);
+	// Draws a line of [first, last) in proportion to its weight in `tree`;
+	// uniformly when the range carries no weight.
+	template<typename T>
+	int SelectWeightedLine(const LineWeightTree<T>& tree, int first, int last);
 	std::vector<double> m_allocation_line_weights;
+	LineWeightTree<double> m_allocation_tree;
+	// Per-line headroom of the accepted picture: its line error minus the
+	// line's error floor. Region picks favour lines that can still improve.
+	LineWeightTree<unsigned long long> m_line_headroom;
 	unsigned m_allocation_global_period = 5;
 	unsigned long long m_primary_mutation_count = 0;
 	int m_solutions;
 	size_t m_cache_size;
 	static constexpr size_t k_instruction_cache_budget_divisor = 8;
+	static constexpr size_t k_trace_cache_budget_divisor = 8;
 
 	unsigned long long m_randseed;
-	unsigned long long m_cache_partial_clears = 0;
-	unsigned long long m_cache_full_clears = 0;
+	unsigned long long m_cache_trace_clears = 0;
+	unsigned long long m_cache_budget_resets = 0;
+	unsigned long long m_local_shared_cache_lookups = 0;
+	unsigned long long m_local_shared_cache_hits = 0;
+	unsigned long long m_local_shared_cache_publishes = 0;
+	unsigned long long m_local_shared_cache_rejected_publishes = 0;
+	// Page faults taken by the thread running Run(), where the OS reports them.
+	unsigned long long m_local_minor_page_faults = 0;
+	unsigned long long m_local_major_page_faults = 0;
 	unsigned long long m_allocator_epoch = 0;
+	// Bumped whenever line results are freed, so accepted result pointers
+	// can tell whether they still point into live cache entries.
+	unsigned long long m_line_cache_generation = 0;
 	unsigned long long m_local_cache_lookups = 0;
 	unsigned long long m_local_cache_hits = 0;
 	unsigned long long m_local_cache_misses = 0;
 	unsigned long long m_local_cache_lookup_probes = 0;
 	unsigned long long m_local_cache_max_lookup_probes = 0;
 	unsigned long long m_local_cache_inserts = 0;
-	unsigned long long m_local_cache_hash_blocks = 0;
+	unsigned long long m_local_cache_table_growths = 0;
 	unsigned long long m_local_cache_evaluations = 0;
 	unsigned long long m_local_cache_recomputed_lines = 0;
 	unsigned long long m_local_antic4_attribute_cache_evaluations = 0;
@@ -507,6 +784,20 @@ private:
 	unsigned long long m_local_cache_propagation_span = 0;
 	unsigned long long m_local_cache_max_propagation_span = 0;
 	unsigned long long m_local_cache_pmg_restarts = 0;
+	unsigned long long m_local_cache_player_free_lines = 0;
+	unsigned long long m_local_cache_trace_hits = 0;
+	unsigned long long m_local_cache_trace_inserts = 0;
+	unsigned long long m_local_cache_dirty_range_evaluations = 0;
+	unsigned long long m_local_cache_prefix_lines = 0;
+	unsigned long long m_local_cache_spliced_lines = 0;
+	unsigned long long m_local_cache_bound_rejections = 0;
+	unsigned long long m_local_cache_bound_skipped_lines = 0;
+	unsigned long long m_local_cache_bound_retries = 0;
+	unsigned long long m_local_line_candidate_evaluations = 0;
+	unsigned long long m_local_line_candidate_switches = 0;
+	// Scratch lines of MutateLineCandidates, kept to reuse their storage.
+	raster_line m_candidate_original_lines[3];
+	raster_line m_candidate_best_lines[3];
 	unsigned long long m_local_lru_updates = 0;
 	unsigned long long m_local_lru_search_steps = 0;
 	std::vector<unsigned long long> m_local_cache_hits_by_line;
@@ -515,13 +806,48 @@ private:
 	raster_picture m_best_pic;
 	double m_best_result;
 
-	// Instruction identities outlive ordinary result-generation eviction. The
-	// two arenas share one resident-byte budget and cumulative attribution.
+	// Instruction identities outlive line-result eviction. Interned sequences,
+	// line-result slots and ANTIC 4 traces share one resident-byte budget and
+	// cumulative attribution; the slots take what the other two leave.
 	linear_allocator::statistics m_cache_allocator_stats;
 	linear_allocator m_insn_allocator{linear_allocator::BLOCK_SIZE, &m_cache_allocator_stats};
-	linear_allocator m_line_allocator{linear_allocator::BLOCK_SIZE, &m_cache_allocator_stats};
+	linear_allocator m_line_trace_allocator{linear_allocator::BLOCK_SIZE, &m_cache_allocator_stats};
+	line_cache_slots m_line_slots;
+	void ConfigureLineSlots();
+	bool m_lean_line_cache = false;
+	// Set while EvaluateWithRows renders a lean evaluator's rows: lines are
+	// neither looked up nor cached, and results go to m_row_results, whose
+	// rows point into m_row_storage.
+	bool m_render_rows = false;
+	std::vector<line_cache_result> m_row_results;
+	std::vector<unsigned char> m_row_storage;
+	// Slot of each line result of the accepted picture, pinned so that
+	// eviction never recycles a result the next dirty-range render reuses.
+	std::vector<uint32_t> m_pinned_line_slots;
+
+	std::vector<RasterLineSchedule> m_line_schedules;
+	GraphicsMode m_line_schedule_mode = GraphicsMode::AnticE;
+	PlayfieldWidth m_line_schedule_width = PlayfieldWidth::Normal;
+	// What the renderer needs to know about a line's program before running
+	// it: the entry registers it observes (see LineEntryLiveRegisters) and
+	// whether it stores to any HPOS register. The mask depends on the line's
+	// DMA schedule as well as its instructions, so the facts are memoised per
+	// line for the interned sequence they were computed from.
+	struct LineInsnFacts
+	{
+		const insn_sequence* insn_seq = nullptr;
+		unsigned long long allocator_epoch = 0;
+		register_state live;
+		bool moves_players = false;
+	};
+	std::vector<LineInsnFacts> m_line_facts;
+	const LineInsnFacts& LineFacts(int y, const insn_sequence* seq,
+		const RasterLineSchedule& schedule, bool antic4);
 
 	std::vector<line_cache> m_line_caches;
+	// ANTIC 4 register timelines keyed without the attribute row, so lines
+	// that differ only in attributes replay the trace instead of the CPU.
+	std::vector<line_cache> m_line_trace_caches;
 	// Dual-mode dedicated caches (separate from single-frame caches)
 	std::vector<line_cache> m_line_caches_dual;
 	// Dual-mode: generation snapshot of other frame for cache invalidation
@@ -591,6 +917,32 @@ private:
 	bool m_cached_stuck = false;
 	unsigned long long m_stuck_valid_until_eval = 0ULL; // recompute after TTL
 	static constexpr unsigned long long k_stuck_ttl_evals = 1024ULL;
+
+	// Evaluation numbers come from a batch reserved in m_gstate->m_evaluations.
+	// Stuck detection and drift read the last number taken here instead of the
+	// shared counter.
+	unsigned long long NextEvaluationNumber();
+	void ReturnUnusedEvaluations();
+	unsigned long long EvaluationClock() const;
+	EvalWorkerCounters* WorkerCounters() const;
+	unsigned long long m_reserved_next = 0ULL;
+	unsigned long long m_reserved_end = 0ULL;
+	unsigned long long m_evaluation_clock = 0ULL;
+	static constexpr unsigned long long k_evaluation_reservation = 256ULL;
+
+	// /islands other than global. At each migration interval the island
+	// files its current solution among its elite if it is good enough,
+	// offers the best or a random elite to its neighbours, and returns a
+	// neighbour's offer better than currentCost, if it takes one.
+	typedef std::shared_ptr<const EvalGlobalState::PublishedBestSnapshot> IslandMigrant;
+	IslandMigrant ExchangeMigrants(const raster_picture& current, double currentCost);
+	void PublishIslandStats(unsigned long long evaluations, unsigned long long accepted,
+		unsigned long long immigrants, double currentCost, double bestCost);
+	EvalGlobalState::IslandSlot* Island() const;
+	// Best first; cleared when the objective changes.
+	std::vector<IslandMigrant> m_island_elite;
+	static constexpr size_t k_island_elite = 4;
+	static constexpr unsigned long long k_island_stats_period = 4096ULL;
 };
 
 #endif
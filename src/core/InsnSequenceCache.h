@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <cstring>
+#include <vector>
 
 #include "RasterInstruction.h"
 #include "LinearAllocator.h"
@@ -11,7 +12,8 @@ struct insn_sequence
 {
 	const SRasterInstruction *insns;
 	unsigned insn_count;
-	uint32_t hash;
+	// raster_line::hash of the instructions.
+	uint64_t hash;
 
 	bool operator==(const insn_sequence &other) const
 	{
@@ -26,93 +28,158 @@ struct insn_sequence
 	}
 };
 
+// Interns instruction sequences so equal lines share one identity, which the
+// line caches key on. insert() runs for every mutated line of every candidate.
+// The table is open-addressed on the 64-bit line hash, probed linearly and
+// kept at most half full, so a lookup reads one or two slots and compares
+// instructions only when the full hashes already agree. Interned sequences
+// live in the caller's allocator and never move; the table grows by doubling
+// and gives its storage back when cleared.
 class insn_sequence_cache
 {
 public:
-	// Sized so a full-budget cache (tens of thousands of interned sequences,
-	// see Evaluator.h k_instruction_cache_budget_divisor) keeps chains short;
-	// insert() below does a full linear scan per chain on every mutation
-	// candidate, so bucket count directly bounds that scan's cost.
-	static const int HTSIZE = 32768;
+	static const size_t MIN_CAPACITY = 1024;
 
-	struct hash_block
+	insn_sequence_cache()
+		: m_size(0)
+		, m_stats(NULL)
 	{
-		static const int N = 63;
+	}
 
-		insn_sequence nodes[N];
-		hash_block *next;
-	};
+	insn_sequence_cache(const insn_sequence_cache&) = delete;
+	insn_sequence_cache& operator=(const insn_sequence_cache&) = delete;
 
-	struct hash_chain
+	insn_sequence_cache(insn_sequence_cache&& other) noexcept
+		: m_slots(std::move(other.m_slots))
+		, m_size(other.m_size)
+		, m_stats(other.m_stats)
 	{
-		hash_block *first;
-		int offset;
-	};
+		other.m_size = 0;
+		other.m_stats = NULL;
+	}
 
-	insn_sequence_cache()
+	insn_sequence_cache& operator=(insn_sequence_cache&& other) noexcept
+	{
+		if (this != &other)
+		{
+			release();
+			m_slots = std::move(other.m_slots);
+			m_size = other.m_size;
+			m_stats = other.m_stats;
+			other.m_slots.clear();
+			other.m_size = 0;
+			other.m_stats = NULL;
+		}
+		return *this;
+	}
+
+	~insn_sequence_cache()
 	{
-		clear();
+		release();
 	}
 
+	// Forgets every sequence; the allocator holding them is cleared by the
+	// caller.
 	void clear()
 	{
-		for(int i=0; i<HTSIZE; ++i)
+		release();
+		std::vector<slot>().swap(m_slots);
+		m_size = 0;
+	}
+
+	size_t size() const { return m_size; }
+	size_t capacity() const { return m_slots.size(); }
+	size_t table_bytes() const { return capacity() * sizeof(slot); }
+
+	const insn_sequence *find(const insn_sequence& key) const
+	{
+		if (!m_size)
+			return NULL;
+		const size_t mask = m_slots.size() - 1;
+		for (size_t index = key.hash & mask; m_slots[index].value; index = (index + 1) & mask)
 		{
-			hash_table[i].first = NULL;
-			hash_table[i].offset = 0;
+			if (m_slots[index].hash == key.hash && key == *m_slots[index].value)
+				return m_slots[index].value;
 		}
+		return NULL;
 	}
 
 	const insn_sequence *insert(const insn_sequence& key, linear_allocator& alloc)
 	{
-		hash_chain& hc = hash_table[key.hash & (HTSIZE - 1)];
-		hash_block *hb = hc.first;
-		int hbidx = hc.offset;
-		int hbidx2 = hbidx;
+		if ((m_size + 1) * 2 > m_slots.size())
+			grow(alloc.stats());
 
-		for(const hash_block *hb2 = hb; hb2; hb2 = hb2->next)
+		const size_t mask = m_slots.size() - 1;
+		size_t index = key.hash & mask;
+		for (; m_slots[index].value; index = (index + 1) & mask)
 		{
-			for(int i=hbidx2 - 1; i>=0; --i)
-			{
-				if (key == hb2->nodes[i])
-				{
-					return &hb2->nodes[i];
-				}
-			}
-
-			hbidx2 = hash_block::N;
+			if (m_slots[index].hash == key.hash && key == *m_slots[index].value)
+				return m_slots[index].value;
 		}
 
-		if (!hb || hbidx >= hash_block::N)
-		{
-			hash_block *hb2 = alloc.allocate<hash_block>(linear_allocator::INSN_CACHE_HASH_BLOCK);
-			memset(hb2, 0, sizeof *hb2);
-			hb2->next = hb;
-			hc.first = hb2;
-			hb = hb2;
-			hbidx = 0;
-		}
-
-		hc.offset = hbidx+1;
-
+		// The sequence and its instructions are one allocation.
+		const size_t bytes = sizeof(insn_sequence) + sizeof(SRasterInstruction) * key.insn_count;
+		insn_sequence *node = static_cast<insn_sequence *>(
+			alloc.allocate(bytes, linear_allocator::INSN_CACHE_DATA));
 		SRasterInstruction *ri = NULL;
-		
 		if (key.insn_count) {
-			ri = (SRasterInstruction *)alloc.allocate(
-				sizeof(SRasterInstruction) * key.insn_count, linear_allocator::INSN_CACHE_DATA);
+			ri = reinterpret_cast<SRasterInstruction *>(node + 1);
 			memcpy(ri, key.insns, sizeof(SRasterInstruction) * key.insn_count);
 		}
+		node->hash = key.hash;
+		node->insns = ri;
+		node->insn_count = key.insn_count;
+
+		m_slots[index].hash = key.hash;
+		m_slots[index].value = node;
+		++m_size;
+		return node;
+	}
 
-		insn_sequence& node = hb->nodes[hbidx];
-		node.hash = key.hash;
-		node.insns = ri;
-		node.insn_count = key.insn_count;
+private:
+	struct slot
+	{
+		uint64_t hash;
+		const insn_sequence *value;
+	};
 
-		return &node;
+	// Table storage counts as resident in the statistics of the allocator
+	// holding the sequences, attributed to INSN_CACHE_HASH_BLOCK.
+	void release()
+	{
+		if (m_stats)
+			m_stats->resident_bytes -= table_bytes();
+		m_stats = NULL;
 	}
 
-private:
-	hash_chain hash_table[HTSIZE];
+	void grow(linear_allocator::statistics *stats)
+	{
+		const size_t old_bytes = table_bytes();
+		std::vector<slot> old;
+		old.swap(m_slots);
+		m_slots.assign(old.empty() ? MIN_CAPACITY : old.size() * 2, slot());
+		const size_t mask = m_slots.size() - 1;
+		for (size_t i = 0; i < old.size(); ++i)
+		{
+			if (!old[i].value)
+				continue;
+			size_t index = old[i].hash & mask;
+			while (m_slots[index].value)
+				index = (index + 1) & mask;
+			m_slots[index] = old[i];
+		}
+
+		if (m_stats)
+			m_stats->resident_bytes -= old_bytes;
+		m_stats = stats;
+		m_stats->resident_bytes += table_bytes();
+		m_stats->allocated_by_type[linear_allocator::INSN_CACHE_HASH_BLOCK] +=
+			table_bytes() - old_bytes;
+	}
+
+	std::vector<slot> m_slots;
+	size_t m_size;
+	linear_allocator::statistics *m_stats;
 };
 
 #endif
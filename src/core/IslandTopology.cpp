@@ -0,0 +1,86 @@
+#include "IslandTopology.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+static const char* const k_topology_names[] = { "global", "ring", "torus", "random", "star" };
+
+const char* IslandTopologyName(IslandTopology topology)
+{
+	return k_topology_names[static_cast<int>(topology)];
+}
+
+bool ParseIslandTopology(const std::string& name, IslandTopology& topology)
+{
+	for (int i = 0; i < 5; ++i)
+	{
+		if (name == k_topology_names[i])
+		{
+			topology = static_cast<IslandTopology>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+static void AddSource(std::vector<int>& sources, int island, int source)
+{
+	if (source != island && std::find(sources.begin(), sources.end(), source) == sources.end())
+		sources.push_back(source);
+}
+
+std::vector<std::vector<int>> BuildIslandSources(IslandTopology topology,
+	int islands, int degree, unsigned long long seed)
+{
+	std::vector<std::vector<int>> sources(std::max(islands, 0));
+	if (islands < 2 || topology == IslandTopology::Global)
+		return sources;
+
+	switch (topology)
+	{
+	case IslandTopology::Ring:
+		for (int i = 0; i < islands; ++i)
+			AddSource(sources[i], i, (i + islands - 1) % islands);
+		break;
+	case IslandTopology::Torus:
+	{
+		// Rows are filled in order, so only the last one may be short; rows and
+		// columns wrap within the islands that exist.
+		const int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(islands))));
+		for (int i = 0; i < islands; ++i)
+		{
+			const int row = i / columns, column = i % columns;
+			const int rowLength = std::min(columns, islands - row * columns);
+			const int columnHeight = (islands - column + columns - 1) / columns;
+			AddSource(sources[i], i, row * columns + (column + rowLength - 1) % rowLength);
+			AddSource(sources[i], i, row * columns + (column + 1) % rowLength);
+			AddSource(sources[i], i, ((row + columnHeight - 1) % columnHeight) * columns + column);
+			AddSource(sources[i], i, ((row + 1) % columnHeight) * columns + column);
+		}
+		break;
+	}
+	case IslandTopology::Random:
+	{
+		std::mt19937_64 random(seed);
+		const int wanted = std::min(std::max(degree, 1), islands - 1);
+		for (int i = 0; i < islands; ++i)
+		{
+			AddSource(sources[i], i, (i + islands - 1) % islands);
+			while (static_cast<int>(sources[i].size()) < wanted)
+				AddSource(sources[i], i, static_cast<int>(random() % islands));
+		}
+		break;
+	}
+	case IslandTopology::Star:
+		for (int i = 1; i < islands; ++i)
+		{
+			sources[0].push_back(i);
+			sources[i].push_back(0);
+		}
+		break;
+	case IslandTopology::Global:
+		break;
+	}
+	return sources;
+}
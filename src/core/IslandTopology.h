@@ -0,0 +1,38 @@
+#ifndef ISLANDTOPOLOGY_H
+#define ISLANDTOPOLOGY_H
+
+#include <string>
+#include <vector>
+
+// Which single-frame workers exchange solutions (/islands). Each worker is an
+// island with its own current solution and acceptance history. Under Global,
+// every island takes the published best whenever it is better than its own, so
+// with many workers they all converge on one basin. The other topologies let an
+// island take migrants only from its neighbours, and only every /migrate_every
+// evaluations. Good solutions then spread a few hops per interval, and distant
+// islands keep searching elsewhere in the meantime.
+enum class IslandTopology
+{
+	Global,
+	// Each island takes from the one before it.
+	Ring,
+	// Islands on a wrapping grid of about sqrt(N) columns; each takes from its
+	// four neighbours.
+	Torus,
+	// Each island takes from the one before it plus degree-1 random others.
+	// The ring edge keeps every island reachable.
+	Random,
+	// Island 0 takes the best offer of all others; the others take from it.
+	Star,
+};
+
+const char* IslandTopologyName(IslandTopology topology);
+// False for an unknown name.
+bool ParseIslandTopology(const std::string& name, IslandTopology& topology);
+
+// The islands each island takes migrants from, without itself or repeats.
+// Empty lists for Global and for a single island. seed only affects Random.
+std::vector<std::vector<int>> BuildIslandSources(IslandTopology topology,
+	int islands, int degree, unsigned long long seed);
+
+#endif
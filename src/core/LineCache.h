@@ -2,6 +2,7 @@
 #define LINECACHE_H
 
 #include <stdint.h>
+#include <algorithm>
 #include <vector>
 #include <cassert>
 
@@ -9,6 +10,16 @@
 #include "RegisterState.h"
 #include "InsnSequenceCache.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LINE_CACHE_SSE2 1
+#else
+#define LINE_CACHE_SSE2 0
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 struct line_cache_key
 {
 	register_state entry_state;
@@ -77,7 +88,9 @@ struct line_cache_result
 	// Pixel targets are color-register IDs 0..7. Keep two targets per byte;
 	// the row is only decoded when a selected picture is published or saved.
 	unsigned char *packed_target_row;
-	unsigned char sprite_data[4][8];
+	uint32_t sprite_bits;
+	// Index of the line_cache_slots slot holding the result, when it has one.
+	uint32_t slot;
 
 	static size_t packed_target_bytes(size_t width)
 	{
@@ -102,6 +115,15 @@ struct line_cache_result
 	}
 };
 
+class line_cache_slots;
+
+// Open-addressing table of the cached values of one raster line. Slots are
+// probed a group at a time: every slot has a control byte holding seven bits
+// of its hash (or EMPTY/DELETED), so one vector compare finds the few slots
+// of a group worth looking at. Values stay where their allocator put them;
+// accepted results are referenced across renders and must not move when the
+// table grows. A table owns no storage until its first insert and gives it
+// back when cleared, so lines that are never rendered cost nothing.
 class line_cache
 {
 public:
@@ -113,105 +135,513 @@ public:
 		void *value;
 	};
 
-	struct hash_block
+	static constexpr int GROUP = 16;
+	// Slots allocated by the first insert. Table storage is counted in the
+	// statistics of the allocator whose values filled it.
+	static constexpr size_t MIN_CAPACITY = 4 * GROUP;
+
+	line_cache()
+		: m_group_mask(0)
+		, m_size(0)
+		, m_deleted(0)
+		, m_stats(NULL)
 	{
-		static const int N = 15;
+	}
 
-		hash_node nodes[N];
-		hash_block *next;
-	};
+	line_cache(const line_cache&) = delete;
+	line_cache& operator=(const line_cache&) = delete;
 
-	struct hash_chain
+	line_cache(line_cache&& other) noexcept
+		: m_ctrl(std::move(other.m_ctrl))
+		, m_nodes(std::move(other.m_nodes))
+		, m_group_mask(other.m_group_mask)
+		, m_size(other.m_size)
+		, m_deleted(other.m_deleted)
+		, m_stats(other.m_stats)
 	{
-		hash_block *first;
-		int offset;
-	};
-
-	typedef std::vector<hash_node> hash_list;
+		other.m_group_mask = 0;
+		other.m_size = 0;
+		other.m_deleted = 0;
+		other.m_stats = NULL;
+	}
 
-	static const int HTSIZE = 8192;
+	line_cache& operator=(line_cache&& other) noexcept
+	{
+		if (this != &other)
+		{
+			release();
+			m_ctrl = std::move(other.m_ctrl);
+			m_nodes = std::move(other.m_nodes);
+			m_group_mask = other.m_group_mask;
+			m_size = other.m_size;
+			m_deleted = other.m_deleted;
+			m_stats = other.m_stats;
+			other.m_group_mask = 0;
+			other.m_size = 0;
+			other.m_deleted = 0;
+			other.m_stats = NULL;
+		}
+		return *this;
+	}
 
-	line_cache()
+	~line_cache()
 	{
-		clear();
+		release();
 	}
 
 	void clear()
 	{
-		for(int i=0; i<HTSIZE; ++i)
-		{
-			hash_table[i].first = NULL;
-			hash_table[i].offset = 0;
-		}
+		release();
+		std::vector<uint8_t>().swap(m_ctrl);
+		std::vector<hash_node>().swap(m_nodes);
+		m_group_mask = 0;
+		m_size = 0;
+		m_deleted = 0;
 	}
 
-	template<typename Key>
-	const line_cache_result *find(const Key& key, uint32_t hash,
+	size_t size() const { return m_size; }
+	size_t capacity() const { return m_ctrl.size(); }
+
+	// Values default to line results; a cache holds one key and value type.
+	// `probes` counts the groups examined.
+	template<typename Key, typename Value = line_cache_result>
+	const Value *find(const Key& key, uint32_t hash,
 		unsigned* probes = NULL) const
 	{
-		unsigned local_probes = 0;
-		const hash_chain& hc = hash_table[hash & (HTSIZE - 1)];
-		const hash_block *hb = hc.first;
-		int hbidx = hc.offset;
-
-		for(; hb; hb = hb->next)
+		if (probes) *probes = 0;
+		if (!m_size)
+			return NULL;
+		const uint8_t tag = tag_of(hash);
+		unsigned groups = 0;
+		size_t group = hash & m_group_mask;
+		for (size_t step = 1; ; group = (group + step++) & m_group_mask)
 		{
-			for(int i=hbidx - 1; i>=0; --i)
+			++groups;
+			const uint8_t *ctrl = &m_ctrl[group * GROUP];
+			for (uint32_t match = match_byte(ctrl, tag); match; match &= match - 1)
 			{
-				++local_probes;
-				const std::pair<Key, line_cache_result>* value =
-					static_cast<const std::pair<Key, line_cache_result>*>(
-						hb->nodes[i].value);
-				if (hb->nodes[i].hash == hash
-					&& key == value->first)
+				const hash_node& node = m_nodes[group * GROUP + lowest_bit(match)];
+				if (node.hash != hash)
+					continue;
+				const std::pair<Key, Value>* value =
+					static_cast<const std::pair<Key, Value>*>(node.value);
+				if (key == value->first)
 				{
-					if (probes) *probes = local_probes;
+					if (probes) *probes = groups;
 					return &value->second;
 				}
 			}
-
-			hbidx = hash_block::N;
+			if (match_byte(ctrl, EMPTY))
+				break;
 		}
 
-		if (probes) *probes = local_probes;
+		if (probes) *probes = groups;
 		return NULL;
 	}
 
+	template<typename Key, typename Value = line_cache_result>
+	Value& insert(const Key& key, uint32_t hash,
+		linear_allocator& alloc, bool* grew = NULL)
+	{
+		hash_node& node = claim(hash, alloc.stats(), grew);
+
+		typedef std::pair<Key, Value> stored_value_type;
+		stored_value_type *value =
+			alloc.allocate<stored_value_type>(linear_allocator::LINE_CACHE_ENTRY);
+		value->first = key;
+		node.value = value;
+
+		return value->second;
+	}
+
+	// Line results stored in a recycled slot of `slots`, with their colour and
+	// target rows pointing into the same slot.
 	template<typename Key>
 	line_cache_result& insert(const Key& key, uint32_t hash,
-		linear_allocator& alloc, bool* allocated_block = NULL)
+		line_cache_slots& slots, bool* grew = NULL);
+
+	// Drops the node holding `value`. A group that still has an empty slot
+	// never let a probe pass, so the node can become empty again; otherwise
+	// it stays a tombstone until the table is rebuilt.
+	void erase(uint32_t hash, const void *value)
 	{
-		if (allocated_block) *allocated_block = false;
-		hash_chain& hc = hash_table[hash & (HTSIZE - 1)];
-		hash_block *hb = hc.first;
-		int hbidx = hc.offset;
+		const uint8_t tag = tag_of(hash);
+		size_t group = hash & m_group_mask;
+		for (size_t step = 1; ; group = (group + step++) & m_group_mask)
+		{
+			uint8_t *ctrl = &m_ctrl[group * GROUP];
+			for (uint32_t match = match_byte(ctrl, tag); match; match &= match - 1)
+			{
+				const int index = lowest_bit(match);
+				if (m_nodes[group * GROUP + index].value != value)
+					continue;
+				if (match_byte(ctrl, EMPTY))
+					ctrl[index] = EMPTY;
+				else
+				{
+					ctrl[index] = DELETED;
+					++m_deleted;
+				}
+				--m_size;
+				return;
+			}
+			if (match_byte(ctrl, EMPTY))
+				break;
+		}
+		assert(!"erased line cache value is not in its table");
+	}
+
+private:
+	static constexpr uint8_t EMPTY = 0x80;
+	static constexpr uint8_t DELETED = 0xFE;
+
+	static uint8_t tag_of(uint32_t hash) { return static_cast<uint8_t>(hash >> 25); }
+
+	// Bit i is set when control byte i of the group equals `byte`.
+	static uint32_t match_byte(const uint8_t *ctrl, uint8_t byte)
+	{
+#if LINE_CACHE_SSE2
+		const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+		return static_cast<uint32_t>(_mm_movemask_epi8(
+			_mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(byte)))));
+#else
+		uint32_t mask = 0;
+		for (int i = 0; i < GROUP; ++i)
+			mask |= static_cast<uint32_t>(ctrl[i] == byte) << i;
+		return mask;
+#endif
+	}
+
+	// Bit i is set when slot i of the group is EMPTY or DELETED.
+	static uint32_t match_free(const uint8_t *ctrl)
+	{
+#if LINE_CACHE_SSE2
+		return static_cast<uint32_t>(_mm_movemask_epi8(
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))));
+#else
+		uint32_t mask = 0;
+		for (int i = 0; i < GROUP; ++i)
+			mask |= static_cast<uint32_t>(ctrl[i] >> 7) << i;
+		return mask;
+#endif
+	}
+
+	static int lowest_bit(uint32_t mask)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return static_cast<int>(index);
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+
+	static size_t table_bytes(size_t capacity)
+	{
+		return capacity * (1 + sizeof(hash_node));
+	}
+
+	void allocate(size_t capacity)
+	{
+		m_ctrl.assign(capacity, EMPTY);
+		m_nodes.resize(capacity);
+		m_group_mask = capacity / GROUP - 1;
+		m_size = 0;
+		m_deleted = 0;
+	}
 
-		if (!hb || hbidx >= hash_block::N)
+	void release()
+	{
+		if (m_stats)
 		{
-			if (allocated_block) *allocated_block = true;
-			hash_block *hb2 = alloc.allocate<hash_block>(linear_allocator::LINE_CACHE_HASH_BLOCK);
-			memset(hb2, 0, sizeof *hb2);
-			hb2->next = hb;
-			hc.first = hb2;
-			hb = hb2;
-			hbidx = 0;
+			m_stats->resident_bytes -= table_bytes(capacity());
+			m_stats->table_bytes -= table_bytes(capacity());
 		}
+		m_stats = NULL;
+	}
 
-		hc.offset = hbidx+1;
+	size_t find_free(uint32_t hash) const
+	{
+		size_t group = hash & m_group_mask;
+		for (size_t step = 1; ; group = (group + step++) & m_group_mask)
+		{
+			const uint32_t free = match_free(&m_ctrl[group * GROUP]);
+			if (free)
+				return group * GROUP + lowest_bit(free);
+		}
+	}
 
-		typedef std::pair<Key, line_cache_result> stored_value_type;
-		stored_value_type *value =
-			alloc.allocate<stored_value_type>(linear_allocator::LINE_CACHE_ENTRY);
-		value->first = key;
+	// Takes a slot for a node of `hash`, rebuilding the table first when
+	// live nodes and tombstones would fill more than 7/8 of it.
+	hash_node& claim(uint32_t hash, linear_allocator::statistics *stats, bool* grew)
+	{
+		if (grew) *grew = false;
+		if ((m_size + m_deleted + 1) * 8 > capacity() * 7)
+		{
+			// Tombstones alone are cleared at the same size.
+			const bool grow = m_size * 16 >= capacity() * 7;
+			rehash(grow ? std::max(capacity() * 2, MIN_CAPACITY) : capacity(), stats);
+			if (grew) *grew = grow;
+		}
+		const size_t index = find_free(hash);
+		if (m_ctrl[index] == DELETED)
+			--m_deleted;
+		m_ctrl[index] = tag_of(hash);
+		++m_size;
+		m_nodes[index].hash = hash;
+		return m_nodes[index];
+	}
 
-		hash_node node = { hash, value };
-		hb->nodes[hbidx] = node;
+	void rehash(size_t capacity, linear_allocator::statistics *stats)
+	{
+		std::vector<uint8_t> ctrl;
+		std::vector<hash_node> nodes;
+		ctrl.swap(m_ctrl);
+		nodes.swap(m_nodes);
+		const size_t old_capacity = ctrl.size();
+		allocate(capacity);
+		for (size_t i = 0; i < old_capacity; ++i)
+		{
+			if (ctrl[i] & EMPTY)
+				continue;
+			const size_t index = find_free(nodes[i].hash);
+			m_ctrl[index] = ctrl[i];
+			m_nodes[index] = nodes[i];
+			++m_size;
+		}
 
-		return value->second;
+		if (capacity == old_capacity)
+			return;
+		if (m_stats)
+		{
+			m_stats->resident_bytes -= table_bytes(old_capacity);
+			m_stats->table_bytes -= table_bytes(old_capacity);
+		}
+		m_stats = stats;
+		m_stats->resident_bytes += table_bytes(capacity);
+		m_stats->table_bytes += table_bytes(capacity);
+		m_stats->allocated_by_type[linear_allocator::LINE_CACHE_TABLE] +=
+			table_bytes(capacity) - table_bytes(old_capacity);
+	}
+
+	std::vector<uint8_t> m_ctrl;
+	std::vector<hash_node> m_nodes;
+	size_t m_group_mask;
+	size_t m_size;
+	size_t m_deleted;
+	linear_allocator::statistics *m_stats;
+};
+
+// Bookkeeping for one fixed-size slot holding a line result: the stored
+// key/value pair followed by its colour row and packed target row. It is
+// kept apart from the slot so the entries themselves stay as small as the
+// linear arena made them.
+struct line_cache_slot
+{
+	line_cache *cache;
+	void *value;
+	uint32_t hash;
+	// CLOCK second chance: set by a hit, cleared when the hand passes.
+	bool referenced;
+	// Part of the accepted picture, whose results outlive the render.
+	bool pinned;
+	// Render that last returned this slot; its results are still in use.
+	unsigned long long stamp;
+};
+
+// Slots for the line results of every line of one evaluator. Slots are carved
+// from linear_allocator slabs until the pool reaches its byte limit; past it a
+// CLOCK hand recycles the slot of an entry that has not been hit since the
+// hand last passed, so the cache stays warm at its budget instead of being
+// thrown away a generation at a time. Pinned slots and slots returned by the
+// current render are never recycled.
+class line_cache_slots
+{
+public:
+	static constexpr uint32_t NONE = 0xffffffffu;
+
+	line_cache_slots()
+		: m_limit(0)
+		, m_entry_bytes(0)
+		, m_color_bytes(0)
+		, m_target_bytes(0)
+		, m_slot_bytes(0)
+		, m_hand(0)
+		, m_serial(1)
+		, m_evictions(0)
+		, m_eviction_skips(0)
+		, m_overflows(0)
+	{
+	}
+
+	line_cache_slots(const line_cache_slots&) = delete;
+	line_cache_slots& operator=(const line_cache_slots&) = delete;
+	line_cache_slots(line_cache_slots&&) = default;
+
+	// Drops every slot. `entry_bytes` must hold the largest key/value pair
+	// stored; rows are `width` colour bytes plus their packed targets. A
+	// `width` of 0 stores no rows, and results get null row pointers.
+	void configure(size_t entry_bytes, size_t width, size_t limit,
+		size_t slab_size, linear_allocator::statistics *stats)
+	{
+		clear();
+		m_entry_bytes = round(entry_bytes);
+		m_color_bytes = round(width);
+		m_target_bytes = round(line_cache_result::packed_target_bytes(width));
+		m_slot_bytes = m_entry_bytes + m_color_bytes + m_target_bytes;
+		m_limit = limit;
+		m_allocator = linear_allocator(slab_size, stats);
+	}
+
+	void clear()
+	{
+		m_allocator.clear();
+		m_slots.clear();
+		m_hand = 0;
+	}
+
+	// Starts a render: the slots it returns stay put until the next one.
+	void begin_render() { ++m_serial; }
+
+	size_t size() const { return m_allocator.size(); }
+	size_t slots() const { return m_slots.size(); }
+	unsigned long long evictions() const { return m_evictions; }
+	unsigned long long eviction_skips() const { return m_eviction_skips; }
+	unsigned long long overflows() const { return m_overflows; }
+
+	// A hit gives the entry its second chance.
+	void touch(const line_cache_result& result)
+	{
+		line_cache_slot& slot = m_slots[result.slot];
+		slot.referenced = true;
+		slot.stamp = m_serial;
+	}
+
+	void pin(uint32_t index) { m_slots[index].pinned = true; }
+	void unpin(uint32_t index) { m_slots[index].pinned = false; }
+
+	// A slot for a new entry of `cache`, linked under `hash` by the caller.
+	uint32_t acquire(line_cache& cache, uint32_t hash)
+	{
+		uint32_t index = NONE;
+		if (!can_grow(m_slot_bytes))
+		{
+			index = evict();
+			if (index == NONE)
+				++m_overflows;
+		}
+		if (index == NONE)
+		{
+			index = static_cast<uint32_t>(m_slots.size());
+			m_slots.emplace_back();
+			m_slots.back().value = m_allocator.allocate_unattributed(m_slot_bytes);
+		}
+		m_allocator.attribute(m_entry_bytes, linear_allocator::LINE_CACHE_ENTRY);
+		m_allocator.attribute(m_color_bytes, linear_allocator::LINE_CACHE_COLOR_ROW);
+		m_allocator.attribute(m_target_bytes, linear_allocator::LINE_CACHE_TARGET_ROW);
+		line_cache_slot& slot = m_slots[index];
+		slot.cache = &cache;
+		slot.hash = hash;
+		slot.referenced = false;
+		slot.pinned = false;
+		slot.stamp = m_serial;
+		return index;
+	}
+
+	void *value(uint32_t index) const { return m_slots[index].value; }
+
+	bool stores_rows() const { return m_color_bytes != 0; }
+
+	unsigned char *color_row(uint32_t index) const
+	{
+		if (!stores_rows())
+			return NULL;
+		return static_cast<unsigned char *>(m_slots[index].value) + m_entry_bytes;
+	}
+
+	unsigned char *target_row(uint32_t index) const
+	{
+		if (!stores_rows())
+			return NULL;
+		return color_row(index) + m_color_bytes;
 	}
 
+	size_t entry_bytes() const { return m_entry_bytes; }
+	linear_allocator::statistics *stats() const { return m_allocator.stats(); }
+
 private:
-	hash_chain hash_table[HTSIZE];
+	static size_t round(size_t n) { return (n + 7) & ~size_t(7); }
+
+	// The tables linking the slots share the limit.
+	bool can_grow(size_t n) const
+	{
+		return m_allocator.available() >= round(n)
+			|| m_allocator.size() + m_allocator.stats()->table_bytes
+				+ m_allocator.block_size() <= m_limit;
+	}
+
+	uint32_t evict()
+	{
+		// Two sweeps clear every second chance; a pool with nothing
+		// recyclable after that grows past its limit instead.
+		for (size_t steps = 2 * m_slots.size(); steps; --steps)
+		{
+			const uint32_t index = static_cast<uint32_t>(m_hand);
+			if (++m_hand == m_slots.size())
+				m_hand = 0;
+			line_cache_slot& slot = m_slots[index];
+			if (slot.pinned || slot.stamp == m_serial)
+			{
+				++m_eviction_skips;
+				continue;
+			}
+			if (slot.referenced)
+			{
+				slot.referenced = false;
+				continue;
+			}
+			slot.cache->erase(slot.hash, slot.value);
+			++m_evictions;
+			return index;
+		}
+		return NONE;
+	}
+
+	linear_allocator m_allocator;
+	size_t m_limit;
+	size_t m_entry_bytes;
+	size_t m_color_bytes;
+	size_t m_target_bytes;
+	size_t m_slot_bytes;
+	// Every slot carved so far, in the order the CLOCK hand visits them.
+	std::vector<line_cache_slot> m_slots;
+	size_t m_hand;
+	unsigned long long m_serial;
+	unsigned long long m_evictions;
+	unsigned long long m_eviction_skips;
+	unsigned long long m_overflows;
 };
 
+template<typename Key>
+line_cache_result& line_cache::insert(const Key& key, uint32_t hash,
+	line_cache_slots& slots, bool* grew)
+{
+	// Recycling a slot can erase from this very table, so the slot is found
+	// before the node is claimed.
+	const uint32_t slot = slots.acquire(*this, hash);
+	hash_node& node = claim(hash, slots.stats(), grew);
+
+	typedef std::pair<Key, line_cache_result> stored_value_type;
+	assert(sizeof(stored_value_type) <= slots.entry_bytes());
+	stored_value_type *value = new(slots.value(slot)) stored_value_type;
+	value->first = key;
+	value->second.color_row = slots.color_row(slot);
+	value->second.packed_target_row = slots.target_row(slot);
+	value->second.slot = slot;
+	node.value = value;
+
+	return value->second;
+}
+
 #endif
@@ -0,0 +1,84 @@
+#ifndef LINEWEIGHTTREE_H
+#define LINEWEIGHTTREE_H
+
+#include <cstddef>
+#include <vector>
+
+// Fenwick tree over per-line mutation weights. Setting one line's weight and
+// drawing a line in proportion to its weight within a range are both
+// O(log lines), so weights can follow every accepted candidate.
+template<typename T>
+class LineWeightTree
+{
+public:
+	void Assign(const std::vector<T>& weights)
+	{
+		m_weights = weights;
+		m_tree.assign(weights.size() + 1, T{});
+		for (size_t i = 0; i < weights.size(); ++i)
+		{
+			m_tree[i + 1] += weights[i];
+			const size_t parent = (i + 1) + ((i + 1) & (0 - (i + 1)));
+			if (parent <= weights.size())
+				m_tree[parent] += m_tree[i + 1];
+		}
+		m_top = 1;
+		while (m_top * 2 <= weights.size())
+			m_top *= 2;
+	}
+
+	void Clear()
+	{
+		m_weights.clear();
+		m_tree.clear();
+		m_top = 0;
+	}
+
+	size_t Size() const { return m_weights.size(); }
+	bool Empty() const { return m_weights.empty(); }
+	T Weight(size_t line) const { return m_weights[line]; }
+
+	void Set(size_t line, T weight)
+	{
+		if (weight == m_weights[line])
+			return;
+		// Unsigned weights wrap consistently, so the difference still adds up.
+		const T delta = weight - m_weights[line];
+		m_weights[line] = weight;
+		for (size_t i = line + 1; i < m_tree.size(); i += i & (0 - i))
+			m_tree[i] += delta;
+	}
+
+	// Sum of the weights of lines [0, end).
+	T Prefix(size_t end) const
+	{
+		T sum{};
+		for (size_t i = end; i > 0; i -= i & (0 - i))
+			sum += m_tree[i];
+		return sum;
+	}
+
+	// The line whose cumulative weight interval holds `target`, i.e. the
+	// first line with Prefix(line + 1) > target; Size() if target >= total.
+	size_t Find(T target) const
+	{
+		size_t position = 0;
+		for (size_t step = m_top; step > 0; step /= 2)
+		{
+			const size_t next = position + step;
+			if (next < m_tree.size() && !(target < m_tree[next]))
+			{
+				position = next;
+				target -= m_tree[next];
+			}
+		}
+		return position;
+	}
+
+private:
+	std::vector<T> m_weights;
+	std::vector<T> m_tree;
+	size_t m_top = 0;
+};
+
+#endif
@@ -5,18 +5,28 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <cassert>
+#include <atomic>
 
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// Bump allocator over chunks of `block_size` bytes. clear() keeps the chunks
+// for the next fill instead of handing them back to the heap; on Linux chunks
+// of a huge page or more are mapped directly and backed by huge pages.
 class linear_allocator
 {
 public:
 	static const uint32_t BLOCK_SIZE = 8388608;
+	static const size_t HUGE_PAGE_SIZE = 2097152;
 
 	enum allocation_type
 	{
 		LINE_CACHE_ENTRY,
-		LINE_CACHE_HASH_BLOCK,
+		LINE_CACHE_TABLE,
 		LINE_CACHE_COLOR_ROW,
 		LINE_CACHE_TARGET_ROW,
+		LINE_CACHE_TRACE,
 		INSN_CACHE_HASH_BLOCK,
 		INSN_CACHE_DATA,
 		ALLOCATION_TYPE_COUNT
@@ -25,11 +35,21 @@ public:
 	struct statistics
 	{
 		size_t resident_bytes = 0;
+		// Part of resident_bytes held by line cache tables rather than chunks.
+		size_t table_bytes = 0;
 		size_t allocated_by_type[ALLOCATION_TYPE_COUNT]{};
+		// Chunks kept by clear() for reuse; not part of resident_bytes.
+		size_t retained_bytes = 0;
+		// Chunks, in use or retained, mapped for huge pages.
+		size_t huge_page_bytes = 0;
+		unsigned long long chunk_allocations = 0;
+		unsigned long long chunk_reuses = 0;
 	};
 
 	explicit linear_allocator(size_t block_size = BLOCK_SIZE, statistics *stats = NULL)
 		: chunk_list(NULL)
+		, spare_list(NULL)
+		, alloc_ptr(NULL)
 		, alloc_left(0)
 		, alloc_total(0)
 		, m_block_size(block_size)
@@ -42,6 +62,7 @@ public:
 
 	linear_allocator(linear_allocator&& other) noexcept
 		: chunk_list(other.chunk_list)
+		, spare_list(other.spare_list)
 		, alloc_ptr(other.alloc_ptr)
 		, alloc_left(other.alloc_left)
 		, alloc_total(other.alloc_total)
@@ -50,6 +71,7 @@ public:
 		, m_stats(other.m_stats == &other.m_owned_stats ? &m_owned_stats : other.m_stats)
 	{
 		other.chunk_list = NULL;
+		other.spare_list = NULL;
 		other.alloc_ptr = NULL;
 		other.alloc_left = 0;
 		other.alloc_total = 0;
@@ -59,8 +81,9 @@ public:
 	{
 		if (this == &other)
 			return *this;
-		clear();
+		release();
 		chunk_list = other.chunk_list;
+		spare_list = other.spare_list;
 		alloc_ptr = other.alloc_ptr;
 		alloc_left = other.alloc_left;
 		alloc_total = other.alloc_total;
@@ -68,6 +91,7 @@ public:
 		m_owned_stats = other.m_owned_stats;
 		m_stats = other.m_stats == &other.m_owned_stats ? &m_owned_stats : other.m_stats;
 		other.chunk_list = NULL;
+		other.spare_list = NULL;
 		other.alloc_ptr = NULL;
 		other.alloc_left = 0;
 		other.alloc_total = 0;
@@ -76,16 +100,24 @@ public:
 
 	~linear_allocator()
 	{
-		clear();
+		release();
 	}
 
+	// Drops every allocation. Chunks of the standard size are kept for reuse.
 	void clear()
 	{
 		while(chunk_list)
 		{
 			chunk_node *next = chunk_list->next;
 
-			free(chunk_list);
+			if (chunk_bytes(chunk_list) == standard_chunk_bytes())
+			{
+				chunk_list->next = spare_list;
+				spare_list = chunk_list;
+				m_stats->retained_bytes += chunk_bytes(chunk_list);
+			}
+			else
+				free_chunk(chunk_list);
 
 			chunk_list = next;
 		}
@@ -95,12 +127,29 @@ public:
 		alloc_total = 0;
 	}
 
+	// clear(), and hands the retained chunks back as well.
+	void release()
+	{
+		clear();
+		while (spare_list)
+		{
+			chunk_node *next = spare_list->next;
+			m_stats->retained_bytes -= chunk_bytes(spare_list);
+			free_chunk(spare_list);
+			spare_list = next;
+		}
+	}
+
 	size_t size() const { return alloc_total; }
+	size_t block_size() const { return m_block_size; }
+	// Bytes the current chunk can still hand out without growing.
+	size_t available() const { return alloc_left; }
 	size_t allocated_bytes(allocation_type type) const { return m_stats->allocated_by_type[type]; }
+	statistics *stats() const { return m_stats; }
 
 	void set_statistics(statistics *stats)
 	{
-		assert(alloc_total == 0);
+		assert(alloc_total == 0 && spare_list == NULL);
 		m_stats = stats ? stats : &m_owned_stats;
 	}
 
@@ -111,23 +160,46 @@ public:
 	}
 
 	void *allocate(size_t n, allocation_type type)
+	{
+		attribute(n, type);
+		return allocate_unattributed(n);
+	}
+
+	// Counts `n` bytes as handed out for `type`. Storage recycled outside the
+	// allocator is attributed again each time it is reused.
+	void attribute(size_t n, allocation_type type)
+	{
+		m_stats->allocated_by_type[type] += (n + 7) & ~7;
+	}
+
+	void *allocate_unattributed(size_t n)
 	{
 		n = (n + 7) & ~7;
-		m_stats->allocated_by_type[type] += n;
 
 		if (alloc_left < n)
 		{
-			size_t to_alloc = m_block_size - 64 - sizeof(chunk_node);
-
-			if (to_alloc < n)
-				to_alloc = n;
+			chunk_node *new_node;
+			if (spare_list && chunk_bytes(spare_list) - sizeof(chunk_node) >= n)
+			{
+				new_node = spare_list;
+				spare_list = spare_list->next;
+				m_stats->retained_bytes -= chunk_bytes(new_node);
+				++m_stats->chunk_reuses;
+			}
+			else
+			{
+				size_t bytes = standard_chunk_bytes();
+				if (bytes - sizeof(chunk_node) < n)
+					bytes = sizeof(chunk_node) + n;
+				new_node = allocate_chunk(bytes);
+				++m_stats->chunk_allocations;
+			}
 
-			chunk_node *new_node = (chunk_node *)malloc(sizeof(chunk_node) + to_alloc);
 			new_node->next = chunk_list;
 			chunk_list = new_node;
 			alloc_ptr = (char *)(new_node + 1);
-			alloc_left = to_alloc;
-			const size_t chunk_size = to_alloc + sizeof(chunk_node);
+			const size_t chunk_size = chunk_bytes(new_node);
+			alloc_left = chunk_size - sizeof(chunk_node);
 			alloc_total += chunk_size;
 			m_stats->resident_bytes += chunk_size;
 		}
@@ -142,10 +214,88 @@ private:
 	struct chunk_node
 	{
 		chunk_node *next;
-		void *align_pad;
+		// Chunk size including this header; the low bit marks a mapped chunk.
+		size_t size;
 	};
 
+	static size_t chunk_bytes(const chunk_node *node) { return node->size & ~size_t(1); }
+
+	// Leaves room for the heap's own header so a default chunk stays within
+	// BLOCK_SIZE.
+	size_t standard_chunk_bytes() const { return m_block_size - 64; }
+
+	static size_t huge_page_length(size_t bytes)
+	{
+		return (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+	}
+
+	chunk_node *allocate_chunk(size_t bytes)
+	{
+		chunk_node *node = NULL;
+#ifdef __linux__
+		if (bytes >= HUGE_PAGE_SIZE)
+			node = static_cast<chunk_node *>(map_huge_pages(huge_page_length(bytes)));
+#endif
+		if (node)
+		{
+			node->size = bytes | 1;
+			m_stats->huge_page_bytes += bytes;
+		}
+		else
+		{
+			node = static_cast<chunk_node *>(malloc(bytes));
+			node->size = bytes;
+		}
+		return node;
+	}
+
+	void free_chunk(chunk_node *node)
+	{
+#ifdef __linux__
+		if (node->size & 1)
+		{
+			m_stats->huge_page_bytes -= chunk_bytes(node);
+			munmap(node, huge_page_length(chunk_bytes(node)));
+			return;
+		}
+#endif
+		free(node);
+	}
+
+#ifdef __linux__
+	// Reserved huge pages when the system has them, otherwise transparent
+	// huge pages over a 2 MiB aligned mapping. NULL if mapping fails.
+	static void *map_huge_pages(size_t length)
+	{
+		static std::atomic<bool> hugetlb_unavailable{false};
+#ifdef MAP_HUGETLB
+		if (!hugetlb_unavailable.load(std::memory_order_relaxed))
+		{
+			void *p = mmap(NULL, length, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (p != MAP_FAILED)
+				return p;
+			hugetlb_unavailable.store(true, std::memory_order_relaxed);
+		}
+#endif
+		char *raw = static_cast<char *>(mmap(NULL, length + HUGE_PAGE_SIZE,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+		if (raw == MAP_FAILED)
+			return NULL;
+		char *aligned = reinterpret_cast<char *>(
+			(reinterpret_cast<uintptr_t>(raw) + HUGE_PAGE_SIZE - 1) & ~uintptr_t(HUGE_PAGE_SIZE - 1));
+		if (aligned != raw)
+			munmap(raw, aligned - raw);
+		munmap(aligned + length, raw + HUGE_PAGE_SIZE - aligned);
+#ifdef MADV_HUGEPAGE
+		madvise(aligned, length, MADV_HUGEPAGE);
+#endif
+		return aligned;
+	}
+#endif
+
 	chunk_node *chunk_list;
+	chunk_node *spare_list;
 	char *alloc_ptr;
 	size_t alloc_left;
 	size_t alloc_total;
@@ -1,6 +1,7 @@
 #include "OptimizerState.h"
 
 #include <algorithm>
+#include <limits>
 
 void OptimizerState::Initialize(double initialCost, std::size_t historySize)
 {
@@ -77,3 +78,12 @@ bool OptimizerState::Apply(OptimizerKind kind, double candidateCost, double drif
 
 	return accepted;
 }
+
+double OptimizerState::AcceptanceLimit(OptimizerKind kind, double drift) const
+{
+	if (!initialized || history.empty())
+		return std::numeric_limits<double>::max();
+	if (kind == OptimizerKind::LAHC)
+		return std::max(currentCost, history[historyIndex % history.size()]) + drift;
+	return std::max(currentCost, costMax) + drift;
+}
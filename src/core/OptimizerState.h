@@ -44,6 +44,10 @@ struct OptimizerState
 
 	void Initialize(double initialCost, std::size_t historySize);
 	bool Apply(OptimizerKind kind, double candidateCost, double drift = 0.0);
+	// Largest cost the next Apply() with this drift could accept. A candidate
+	// known to cost more is rejected whatever its exact cost, and rejection
+	// updates the history identically for every such cost.
+	double AcceptanceLimit(OptimizerKind kind, double drift = 0.0) const;
 };
 
 // A dual-frame search state is one accepted A/B pair plus one acceptance
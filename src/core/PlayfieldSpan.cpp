@@ -0,0 +1,425 @@
+#include "PlayfieldSpan.h"
+
+#include <cstring>
+
+#if RASTA_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+inline bool AlternateColumn(uint64_t alternate_columns, int x)
+{
+	return ((alternate_columns >> (x >> 2)) & 1u) != 0;
+}
+
+// Sums the errors as stored; compact callers scale the result.
+template<class Registers>
+inline distance_accum_t ScorePlayfieldPixels(const Registers& registers,
+	int first, int end, unsigned char* color_row, unsigned char* target_row)
+{
+	distance_accum_t total = 0;
+	for (int x = first; x < end; ++x)
+	{
+		int slot = E_PLAYFIELD_SLOT_COLBAK;
+		distance_t best = registers.rows[E_PLAYFIELD_SLOT_COLBAK][x];
+		distance_t distance = registers.rows[E_PLAYFIELD_SLOT_COLOR0][x];
+		if (distance < best)
+		{
+			best = distance;
+			slot = E_PLAYFIELD_SLOT_COLOR0;
+		}
+		distance = registers.rows[E_PLAYFIELD_SLOT_COLOR1][x];
+		if (distance < best)
+		{
+			best = distance;
+			slot = E_PLAYFIELD_SLOT_COLOR1;
+		}
+		const int last = AlternateColumn(registers.alternate_columns, x)
+			? E_PLAYFIELD_SLOT_COLOR3 : E_PLAYFIELD_SLOT_COLOR2;
+		distance = registers.rows[last][x];
+		if (distance < best)
+		{
+			best = distance;
+			slot = last;
+		}
+		total += best;
+		color_row[x] = registers.colors[slot];
+		target_row[x] = registers.targets[slot];
+	}
+	return total;
+}
+
+#if RASTA_X86
+// Byte lookup tables indexed by playfield slot, for _mm_shuffle_epi8.
+RASTA_TARGET_SSE41 inline __m128i SlotTable(const unsigned char* values)
+{
+	unsigned char table[16] = {};
+	memcpy(table, values, E_PLAYFIELD_SLOT_MAX);
+	return _mm_loadu_si128(reinterpret_cast<const __m128i*>(table));
+}
+
+RASTA_TARGET_SSE41 inline __m128i AlternateLanes4(uint64_t alternate_columns, int x)
+{
+	return _mm_setr_epi32(
+		-static_cast<int>(AlternateColumn(alternate_columns, x + 0)),
+		-static_cast<int>(AlternateColumn(alternate_columns, x + 1)),
+		-static_cast<int>(AlternateColumn(alternate_columns, x + 2)),
+		-static_cast<int>(AlternateColumn(alternate_columns, x + 3)));
+}
+
+// Unsigned first-minimum: a later candidate wins only when the running
+// minimum actually moves.
+RASTA_TARGET_SSE41 inline void ConsiderSse41(__m128i& best, __m128i& slot,
+	__m128i distance, __m128i candidate)
+{
+	const __m128i lower = _mm_min_epu32(best, distance);
+	const __m128i moved = _mm_xor_si128(
+		_mm_cmpeq_epi32(lower, best), _mm_set1_epi32(-1));
+	slot = _mm_blendv_epi8(slot, candidate, moved);
+	best = lower;
+}
+
+RASTA_TARGET_SSE41 distance_accum_t ScorePlayfieldSpanSse41(const PlayfieldSpanRegisters& registers,
+	int first, int end, unsigned char* color_row, unsigned char* target_row)
+{
+	const __m128i colorTable = SlotTable(registers.colors);
+	const __m128i targetTable = SlotTable(registers.targets);
+	__m128i total = _mm_setzero_si128();
+
+	int x = first;
+	for (; x + 4 <= end; x += 4)
+	{
+		__m128i best = _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+			registers.rows[E_PLAYFIELD_SLOT_COLBAK] + x));
+		__m128i slot = _mm_set1_epi32(E_PLAYFIELD_SLOT_COLBAK);
+
+		__m128i last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+			registers.rows[E_PLAYFIELD_SLOT_COLOR2] + x));
+		__m128i lastSlot = _mm_set1_epi32(E_PLAYFIELD_SLOT_COLOR2);
+		if (registers.alternate_columns)
+		{
+			const __m128i alternate = AlternateLanes4(registers.alternate_columns, x);
+			last = _mm_blendv_epi8(last, _mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(
+					registers.rows[E_PLAYFIELD_SLOT_COLOR3] + x)), alternate);
+			lastSlot = _mm_blendv_epi8(lastSlot,
+				_mm_set1_epi32(E_PLAYFIELD_SLOT_COLOR3), alternate);
+		}
+
+		ConsiderSse41(best, slot, _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+			registers.rows[E_PLAYFIELD_SLOT_COLOR0] + x)),
+			_mm_set1_epi32(E_PLAYFIELD_SLOT_COLOR0));
+		ConsiderSse41(best, slot, _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+			registers.rows[E_PLAYFIELD_SLOT_COLOR1] + x)),
+			_mm_set1_epi32(E_PLAYFIELD_SLOT_COLOR1));
+		ConsiderSse41(best, slot, last, lastSlot);
+
+		total = _mm_add_epi64(total, _mm_cvtepu32_epi64(best));
+		total = _mm_add_epi64(total, _mm_cvtepu32_epi64(_mm_srli_si128(best, 8)));
+
+		const __m128i slot16 = _mm_packus_epi32(slot, slot);
+		const __m128i slot8 = _mm_packus_epi16(slot16, slot16);
+		const int colors = _mm_cvtsi128_si32(_mm_shuffle_epi8(colorTable, slot8));
+		const int targets = _mm_cvtsi128_si32(_mm_shuffle_epi8(targetTable, slot8));
+		memcpy(color_row + x, &colors, 4);
+		memcpy(target_row + x, &targets, 4);
+	}
+
+	alignas(16) long long lanes[2];
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes), total);
+	return lanes[0] + lanes[1]
+		+ ScorePlayfieldPixels(registers, x, end, color_row, target_row);
+}
+
+RASTA_TARGET_AVX2 inline __m256i AlternateLanes8(uint64_t alternate_columns, int x)
+{
+	return _mm256_setr_epi32(
+		-static_cast<int>(AlternateColumn(alternate_columns, x + 0)),
+		-static_cast<int>(AlternateColumn(alternate_columns, x + 1)),
+		-static_cast<int>(AlternateColumn(alternate_columns, x + 2)),
+		-static_cast<int>(AlternateColumn(alternate_columns, x + 3)),
+		-static_cast<int>(AlternateColumn(alternate_columns, x + 4)),
+		-static_cast<int>(AlternateColumn(alternate_columns, x + 5)),
+		-static_cast<int>(AlternateColumn(alternate_columns, x + 6)),
+		-static_cast<int>(AlternateColumn(alternate_columns, x + 7)));
+}
+
+RASTA_TARGET_AVX2 inline void ConsiderAvx2(__m256i& best, __m256i& slot,
+	__m256i distance, __m256i candidate)
+{
+	const __m256i lower = _mm256_min_epu32(best, distance);
+	const __m256i moved = _mm256_xor_si256(
+		_mm256_cmpeq_epi32(lower, best), _mm256_set1_epi32(-1));
+	slot = _mm256_blendv_epi8(slot, candidate, moved);
+	best = lower;
+}
+
+RASTA_TARGET_AVX2 distance_accum_t ScorePlayfieldSpanAvx2(const PlayfieldSpanRegisters& registers,
+	int first, int end, unsigned char* color_row, unsigned char* target_row)
+{
+	const __m128i colorTable = SlotTable(registers.colors);
+	const __m128i targetTable = SlotTable(registers.targets);
+	__m256i total = _mm256_setzero_si256();
+
+	int x = first;
+	for (; x + 8 <= end; x += 8)
+	{
+		__m256i best = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+			registers.rows[E_PLAYFIELD_SLOT_COLBAK] + x));
+		__m256i slot = _mm256_set1_epi32(E_PLAYFIELD_SLOT_COLBAK);
+
+		__m256i last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+			registers.rows[E_PLAYFIELD_SLOT_COLOR2] + x));
+		__m256i lastSlot = _mm256_set1_epi32(E_PLAYFIELD_SLOT_COLOR2);
+		if (registers.alternate_columns)
+		{
+			const __m256i alternate = AlternateLanes8(registers.alternate_columns, x);
+			last = _mm256_blendv_epi8(last, _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(
+					registers.rows[E_PLAYFIELD_SLOT_COLOR3] + x)), alternate);
+			lastSlot = _mm256_blendv_epi8(lastSlot,
+				_mm256_set1_epi32(E_PLAYFIELD_SLOT_COLOR3), alternate);
+		}
+
+		ConsiderAvx2(best, slot, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+			registers.rows[E_PLAYFIELD_SLOT_COLOR0] + x)),
+			_mm256_set1_epi32(E_PLAYFIELD_SLOT_COLOR0));
+		ConsiderAvx2(best, slot, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+			registers.rows[E_PLAYFIELD_SLOT_COLOR1] + x)),
+			_mm256_set1_epi32(E_PLAYFIELD_SLOT_COLOR1));
+		ConsiderAvx2(best, slot, last, lastSlot);
+
+		total = _mm256_add_epi64(total,
+			_mm256_cvtepu32_epi64(_mm256_castsi256_si128(best)));
+		total = _mm256_add_epi64(total,
+			_mm256_cvtepu32_epi64(_mm256_extracti128_si256(best, 1)));
+
+		const __m128i slot16 = _mm_packus_epi32(
+			_mm256_castsi256_si128(slot), _mm256_extracti128_si256(slot, 1));
+		const __m128i slot8 = _mm_packus_epi16(slot16, slot16);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(color_row + x),
+			_mm_shuffle_epi8(colorTable, slot8));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(target_row + x),
+			_mm_shuffle_epi8(targetTable, slot8));
+	}
+
+	alignas(32) long long lanes[4];
+	_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), total);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3]
+		+ ScorePlayfieldSpanSse41(registers, x, end, color_row, target_row);
+}
+
+RASTA_TARGET_SSE41 inline __m128i AlternateLanes8x16(uint64_t alternate_columns, int x)
+{
+	return _mm_setr_epi16(
+		static_cast<short>(-static_cast<int>(AlternateColumn(alternate_columns, x + 0))),
+		static_cast<short>(-static_cast<int>(AlternateColumn(alternate_columns, x + 1))),
+		static_cast<short>(-static_cast<int>(AlternateColumn(alternate_columns, x + 2))),
+		static_cast<short>(-static_cast<int>(AlternateColumn(alternate_columns, x + 3))),
+		static_cast<short>(-static_cast<int>(AlternateColumn(alternate_columns, x + 4))),
+		static_cast<short>(-static_cast<int>(AlternateColumn(alternate_columns, x + 5))),
+		static_cast<short>(-static_cast<int>(AlternateColumn(alternate_columns, x + 6))),
+		static_cast<short>(-static_cast<int>(AlternateColumn(alternate_columns, x + 7))));
+}
+
+RASTA_TARGET_SSE41 inline void ConsiderCompactSse41(__m128i& best, __m128i& slot,
+	__m128i distance, __m128i candidate)
+{
+	const __m128i lower = _mm_min_epu16(best, distance);
+	const __m128i moved = _mm_xor_si128(
+		_mm_cmpeq_epi16(lower, best), _mm_set1_epi32(-1));
+	slot = _mm_blendv_epi8(slot, candidate, moved);
+	best = lower;
+}
+
+RASTA_TARGET_SSE41 distance_accum_t ScoreCompactPlayfieldSpanSse41(
+	const CompactPlayfieldSpanRegisters& registers,
+	int first, int end, unsigned char* color_row, unsigned char* target_row)
+{
+	const __m128i colorTable = SlotTable(registers.colors);
+	const __m128i targetTable = SlotTable(registers.targets);
+	__m128i total = _mm_setzero_si128();
+
+	int x = first;
+	for (; x + 8 <= end; x += 8)
+	{
+		__m128i best = _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+			registers.rows[E_PLAYFIELD_SLOT_COLBAK] + x));
+		__m128i slot = _mm_set1_epi16(E_PLAYFIELD_SLOT_COLBAK);
+
+		__m128i last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+			registers.rows[E_PLAYFIELD_SLOT_COLOR2] + x));
+		__m128i lastSlot = _mm_set1_epi16(E_PLAYFIELD_SLOT_COLOR2);
+		if (registers.alternate_columns)
+		{
+			const __m128i alternate = AlternateLanes8x16(registers.alternate_columns, x);
+			last = _mm_blendv_epi8(last, _mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(
+					registers.rows[E_PLAYFIELD_SLOT_COLOR3] + x)), alternate);
+			lastSlot = _mm_blendv_epi8(lastSlot,
+				_mm_set1_epi16(E_PLAYFIELD_SLOT_COLOR3), alternate);
+		}
+
+		ConsiderCompactSse41(best, slot, _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+			registers.rows[E_PLAYFIELD_SLOT_COLOR0] + x)),
+			_mm_set1_epi16(E_PLAYFIELD_SLOT_COLOR0));
+		ConsiderCompactSse41(best, slot, _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+			registers.rows[E_PLAYFIELD_SLOT_COLOR1] + x)),
+			_mm_set1_epi16(E_PLAYFIELD_SLOT_COLOR1));
+		ConsiderCompactSse41(best, slot, last, lastSlot);
+
+		total = _mm_add_epi32(total, _mm_cvtepu16_epi32(best));
+		total = _mm_add_epi32(total, _mm_cvtepu16_epi32(_mm_srli_si128(best, 8)));
+
+		const __m128i slot8 = _mm_packus_epi16(slot, slot);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(color_row + x),
+			_mm_shuffle_epi8(colorTable, slot8));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(target_row + x),
+			_mm_shuffle_epi8(targetTable, slot8));
+	}
+
+	alignas(16) uint32_t lanes[4];
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes), total);
+	const distance_accum_t sum = distance_accum_t{lanes[0]} + lanes[1] + lanes[2] + lanes[3];
+	return (sum << registers.shift)
+		+ (ScorePlayfieldPixels(registers, x, end, color_row, target_row) << registers.shift);
+}
+
+RASTA_TARGET_AVX2 inline __m256i AlternateLanes16x16(uint64_t alternate_columns, int x)
+{
+	alignas(32) short lanes[16];
+	for (int lane = 0; lane < 16; ++lane)
+		lanes[lane] = static_cast<short>(-static_cast<int>(
+			AlternateColumn(alternate_columns, x + lane)));
+	return _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes));
+}
+
+RASTA_TARGET_AVX2 inline void ConsiderCompactAvx2(__m256i& best, __m256i& slot,
+	__m256i distance, __m256i candidate)
+{
+	const __m256i lower = _mm256_min_epu16(best, distance);
+	const __m256i moved = _mm256_xor_si256(
+		_mm256_cmpeq_epi16(lower, best), _mm256_set1_epi32(-1));
+	slot = _mm256_blendv_epi8(slot, candidate, moved);
+	best = lower;
+}
+
+RASTA_TARGET_AVX2 distance_accum_t ScoreCompactPlayfieldSpanAvx2(
+	const CompactPlayfieldSpanRegisters& registers,
+	int first, int end, unsigned char* color_row, unsigned char* target_row)
+{
+	const __m128i colorTable = SlotTable(registers.colors);
+	const __m128i targetTable = SlotTable(registers.targets);
+	__m256i total = _mm256_setzero_si256();
+
+	int x = first;
+	for (; x + 16 <= end; x += 16)
+	{
+		__m256i best = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+			registers.rows[E_PLAYFIELD_SLOT_COLBAK] + x));
+		__m256i slot = _mm256_set1_epi16(E_PLAYFIELD_SLOT_COLBAK);
+
+		__m256i last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+			registers.rows[E_PLAYFIELD_SLOT_COLOR2] + x));
+		__m256i lastSlot = _mm256_set1_epi16(E_PLAYFIELD_SLOT_COLOR2);
+		if (registers.alternate_columns)
+		{
+			const __m256i alternate = AlternateLanes16x16(registers.alternate_columns, x);
+			last = _mm256_blendv_epi8(last, _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(
+					registers.rows[E_PLAYFIELD_SLOT_COLOR3] + x)), alternate);
+			lastSlot = _mm256_blendv_epi8(lastSlot,
+				_mm256_set1_epi16(E_PLAYFIELD_SLOT_COLOR3), alternate);
+		}
+
+		ConsiderCompactAvx2(best, slot, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+			registers.rows[E_PLAYFIELD_SLOT_COLOR0] + x)),
+			_mm256_set1_epi16(E_PLAYFIELD_SLOT_COLOR0));
+		ConsiderCompactAvx2(best, slot, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+			registers.rows[E_PLAYFIELD_SLOT_COLOR1] + x)),
+			_mm256_set1_epi16(E_PLAYFIELD_SLOT_COLOR1));
+		ConsiderCompactAvx2(best, slot, last, lastSlot);
+
+		total = _mm256_add_epi32(total,
+			_mm256_cvtepu16_epi32(_mm256_castsi256_si128(best)));
+		total = _mm256_add_epi32(total,
+			_mm256_cvtepu16_epi32(_mm256_extracti128_si256(best, 1)));
+
+		const __m128i slot8 = _mm_packus_epi16(
+			_mm256_castsi256_si128(slot), _mm256_extracti128_si256(slot, 1));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(color_row + x),
+			_mm_shuffle_epi8(colorTable, slot8));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(target_row + x),
+			_mm_shuffle_epi8(targetTable, slot8));
+	}
+
+	alignas(32) uint32_t lanes[8];
+	_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), total);
+	distance_accum_t sum = 0;
+	for (uint32_t lane : lanes)
+		sum += lane;
+	return (sum << registers.shift)
+		+ ScoreCompactPlayfieldSpanSse41(registers, x, end, color_row, target_row);
+}
+#endif
+}
+
+playfield_span_kernel SelectPlayfieldSpanKernel(SimdLevel level)
+{
+#if RASTA_X86
+	switch (level)
+	{
+	case SimdLevel::Avx2: return ScorePlayfieldSpanAvx2;
+	case SimdLevel::Sse41: return ScorePlayfieldSpanSse41;
+	case SimdLevel::Scalar: break;
+	}
+#else
+	(void)level;
+#endif
+	return ScorePlayfieldPixels;
+}
+
+distance_accum_t ScorePlayfieldSpanScalar(const PlayfieldSpanRegisters& registers,
+	int first, int end, unsigned char* color_row, unsigned char* target_row)
+{
+	return ScorePlayfieldPixels(registers, first, end, color_row, target_row);
+}
+
+distance_accum_t ScorePlayfieldSpan(const PlayfieldSpanRegisters& registers,
+	int first, int end, unsigned char* color_row, unsigned char* target_row)
+{
+	static const playfield_span_kernel kernel =
+		SelectPlayfieldSpanKernel(ActiveSimdLevel());
+	return kernel(registers, first, end, color_row, target_row);
+}
+
+compact_playfield_span_kernel SelectCompactPlayfieldSpanKernel(SimdLevel level)
+{
+#if RASTA_X86
+	switch (level)
+	{
+	case SimdLevel::Avx2: return ScoreCompactPlayfieldSpanAvx2;
+	case SimdLevel::Sse41: return ScoreCompactPlayfieldSpanSse41;
+	case SimdLevel::Scalar: break;
+	}
+#else
+	(void)level;
+#endif
+	return ScoreCompactPlayfieldSpanScalar;
+}
+
+distance_accum_t ScoreCompactPlayfieldSpanScalar(const CompactPlayfieldSpanRegisters& registers,
+	int first, int end, unsigned char* color_row, unsigned char* target_row)
+{
+	return ScorePlayfieldPixels(registers, first, end, color_row, target_row)
+		<< registers.shift;
+}
+
+distance_accum_t ScoreCompactPlayfieldSpan(const CompactPlayfieldSpanRegisters& registers,
+	int first, int end, unsigned char* color_row, unsigned char* target_row)
+{
+	static const compact_playfield_span_kernel kernel =
+		SelectCompactPlayfieldSpanKernel(ActiveSimdLevel());
+	return kernel(registers, first, end, color_row, target_row);
+}
@@ -0,0 +1,71 @@
+#ifndef PLAYFIELDSPAN_H
+#define PLAYFIELDSPAN_H
+
+#include <cstdint>
+
+#include "CpuDispatch.h"
+#include "Distance.h"
+
+// Candidate order of a playfield-only pixel. FindClosestColorRegister keeps
+// the first strict minimum in this order, and the kernels must too.
+enum e_playfield_slot
+{
+	E_PLAYFIELD_SLOT_COLBAK,
+	E_PLAYFIELD_SLOT_COLOR0,
+	E_PLAYFIELD_SLOT_COLOR1,
+	E_PLAYFIELD_SLOT_COLOR2,
+	E_PLAYFIELD_SLOT_COLOR3,
+	E_PLAYFIELD_SLOT_MAX,
+};
+
+// The colour registers of one constant-register run. Rows are the error-map
+// planes of each register's colour, already offset to the picture line, so
+// rows[slot][x] is the cost of showing that register at pixel x.
+struct PlayfieldSpanRegisters
+{
+	const distance_t* rows[E_PLAYFIELD_SLOT_MAX];
+	unsigned char colors[E_PLAYFIELD_SLOT_MAX];
+	unsigned char targets[E_PLAYFIELD_SLOT_MAX];
+	// ANTIC 4 attribute bits of the character row, one per 4-pixel column.
+	// A set bit swaps COLOR2 for COLOR3; always zero in mode E.
+	uint64_t alternate_columns;
+};
+
+// Scores pixels [first, end) that no player covers: each one takes the
+// cheapest playfield register, writing its colour and target and returning
+// the summed error. The vector kernels are bit-identical to the scalar one.
+typedef distance_accum_t (*playfield_span_kernel)(const PlayfieldSpanRegisters& registers,
+	int first, int end, unsigned char* color_row, unsigned char* target_row);
+
+// The kernel for a given level, or the scalar one where that level is not
+// compiled in. ScorePlayfieldSpan uses the kernel for ActiveSimdLevel().
+playfield_span_kernel SelectPlayfieldSpanKernel(SimdLevel level);
+distance_accum_t ScorePlayfieldSpan(const PlayfieldSpanRegisters& registers,
+	int first, int end, unsigned char* color_row, unsigned char* target_row);
+distance_accum_t ScorePlayfieldSpanScalar(const PlayfieldSpanRegisters& registers,
+	int first, int end, unsigned char* color_row, unsigned char* target_row);
+
+// The same registers over /errmap=compact rows: quantized 16-bit errors that
+// are compared as they are and scaled back by 2^shift only in the sum, so the
+// result is in the units of the exact map. Spans are at most a picture line
+// wide, which keeps 16-bit lane sums inside 32 bits.
+struct CompactPlayfieldSpanRegisters
+{
+	const uint16_t* rows[E_PLAYFIELD_SLOT_MAX];
+	unsigned char colors[E_PLAYFIELD_SLOT_MAX];
+	unsigned char targets[E_PLAYFIELD_SLOT_MAX];
+	uint64_t alternate_columns;
+	unsigned shift;
+};
+
+typedef distance_accum_t (*compact_playfield_span_kernel)(
+	const CompactPlayfieldSpanRegisters& registers,
+	int first, int end, unsigned char* color_row, unsigned char* target_row);
+
+compact_playfield_span_kernel SelectCompactPlayfieldSpanKernel(SimdLevel level);
+distance_accum_t ScoreCompactPlayfieldSpan(const CompactPlayfieldSpanRegisters& registers,
+	int first, int end, unsigned char* color_row, unsigned char* target_row);
+distance_accum_t ScoreCompactPlayfieldSpanScalar(const CompactPlayfieldSpanRegisters& registers,
+	int first, int end, unsigned char* color_row, unsigned char* target_row);
+
+#endif
@@ -72,7 +72,7 @@ inline int PlayfieldLeftHiddenCharacters(PlayfieldWidth width)
 		? wide_playfield_left_hidden_characters : 0;
 }
 
-inline int SpriteScreenColorCycleStart(
+constexpr int SpriteScreenColorCycleStart(
 	GraphicsMode, PlayfieldWidth width = PlayfieldWidth::Normal)
 {
 	return width == PlayfieldWidth::Wide
@@ -83,6 +83,35 @@ inline int SpriteScreenColorCycleStart(
 typedef unsigned char sprites_row_memory_t[4][8];
 typedef sprites_row_memory_t sprites_memory_t[240]; // we convert it to 240 bytes of PMG memory at the end of processing.
 
+// The renderer keeps a line's player data in one word: bit 8 * player + b is
+// sprites_row_memory_t[player][b], and each data bit covers four colour clocks.
+inline uint32_t SpriteRowBit(int player, int bit)
+{
+	return 1u << (8 * player + bit);
+}
+
+inline unsigned SpriteRowPlayerBits(uint32_t bits, int player)
+{
+	return (bits >> (8 * player)) & 0xFF;
+}
+
+inline uint32_t PackSpriteRow(const sprites_row_memory_t& row)
+{
+	uint32_t bits = 0;
+	for (int player = 0; player < 4; ++player)
+		for (int bit = 0; bit < 8; ++bit)
+			if (row[player][bit])
+				bits |= SpriteRowBit(player, bit);
+	return bits;
+}
+
+inline void UnpackSpriteRow(sprites_row_memory_t& row, uint32_t bits)
+{
+	for (int player = 0; player < 4; ++player)
+		for (int bit = 0; bit < 8; ++bit)
+			row[player][bit] = (bits & SpriteRowBit(player, bit)) ? 1 : 0;
+}
+
 struct ScreenCycle {
 	int offset; // position on the screen (can be <0 - previous line)
 	int length; // length in pixels for 2 CPU cycles
@@ -385,18 +414,33 @@ struct raster_line {
 		instructions.reserve(16); // Typical instruction count
 	}
 
-	void rehash()
+	// Hash term of one instruction at its position. The line hash is the sum
+	// of these terms, so editing an instruction in place updates it in O(1).
+	static uint64_t instruction_hash(size_t index, const SRasterInstruction& insn)
 	{
-		unsigned h = 0;
+		uint64_t h = (((uint64_t)index << 32) | insn.packed) + 0x9e3779b97f4a7c15ull;
+		h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+		h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+		return h ^ (h >> 31);
+	}
 
-		for(std::vector<SRasterInstruction>::const_iterator it = instructions.begin(), itEnd = instructions.end(); it != itEnd; ++it)
-		{
-			h += (unsigned) it->hash();
+	uint64_t content_hash() const
+	{
+		uint64_t h = 0;
+		for (size_t i = 0; i < instructions.size(); ++i)
+			h += instruction_hash(i, instructions[i]);
+		return h;
+	}
 
-			h = (h >> 27) + (h << 5);
-		}
+	void rehash()
+	{
+		this->hash = content_hash();
+	}
 
-		this->hash = h;
+	// Call after instructions[index] was overwritten; before is its old value.
+	void instruction_changed(size_t index, const SRasterInstruction& before)
+	{
+		hash += instruction_hash(index, instructions[index]) - instruction_hash(index, before);
 	}
 
 	void recache_insns(insn_sequence_cache& cache, linear_allocator& alloc)
@@ -418,7 +462,7 @@ struct raster_line {
 	}
 
 	int cycles; // cache, to chech if we can add/remove new instructions
-	unsigned hash;
+	uint64_t hash;
 	const insn_sequence *cache_key;
 };
 
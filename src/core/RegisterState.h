@@ -1,6 +1,8 @@
 #ifndef REGISTER_STATE_H
 #define REGISTER_STATE_H
 
+#include <cstring>
+
 struct register_state
 {
 	unsigned char reg_a;
@@ -9,4 +11,88 @@ struct register_state
 	unsigned char mem_regs[E_TARGET_MAX];
 };
 
+// Zero every byte of `state` that `mask` leaves clear.
+inline void MaskRegisterState(register_state& state, const register_state& mask)
+{
+	unsigned char* bytes = reinterpret_cast<unsigned char*>(&state);
+	const unsigned char* maskBytes = reinterpret_cast<const unsigned char*>(&mask);
+	for (size_t i = 0; i < sizeof(register_state); ++i)
+		bytes[i] &= maskBytes[i];
+}
+
+inline bool MaskedRegisterStatesEqual(const register_state& state1,
+	const register_state& state2, const register_state& mask)
+{
+	const unsigned char* bytes1 = reinterpret_cast<const unsigned char*>(&state1);
+	const unsigned char* bytes2 = reinterpret_cast<const unsigned char*>(&state2);
+	const unsigned char* maskBytes = reinterpret_cast<const unsigned char*>(&mask);
+	for (size_t i = 0; i < sizeof(register_state); ++i)
+	{
+		if ((bytes1[i] ^ bytes2[i]) & maskBytes[i])
+			return false;
+	}
+	return true;
+}
+
+// Entry registers a raster line can observe: 0xFF for a register whose entry
+// value reaches a pixel or the outgoing state, 0 for one the line defines
+// before either can see it. A CPU register is dead when it is loaded before
+// it is stored (or, for A, when the ANTIC 4 CHBASE suffix clobbers it); a
+// colour register is dead when a store lands before the first pixel. HPOS
+// stores compare against the old position, so players are always observed.
+// The renderer stops at colour clock `lineEnd`; instructions completing from
+// lineEnd - 1 on never execute and leave their registers passing through.
+inline register_state LineEntryLiveRegisters(const SRasterInstruction* insns,
+	unsigned count, const RasterLineSchedule& schedule, bool antic4, int lineEnd)
+{
+	register_state live;
+	memset(&live, 0xFF, sizeof live);
+	bool loaded[3] = {};
+	bool stored[3] = {};
+	const ScreenCycle* cycles = schedule.timing->cycles.data();
+	int cycle = 0;
+	for (unsigned i = 0; i < count; ++i)
+	{
+		const SRasterInstruction& insn = insns[i];
+		const int offset = RasterInstructionCompletionOffset(cycles, cycle, insn, antic4);
+		if (offset >= lineEnd - 1)
+			break;
+		switch (insn.loose.instruction)
+		{
+		case E_RASTER_LDA:
+		case E_RASTER_LDX:
+		case E_RASTER_LDY:
+		{
+			const int reg = insn.loose.instruction - E_RASTER_LDA;
+			if (!stored[reg])
+				loaded[reg] = true;
+			break;
+		}
+		case E_RASTER_STA:
+		case E_RASTER_STX:
+		case E_RASTER_STY:
+		{
+			const int reg = insn.loose.instruction - E_RASTER_STA;
+			if (!loaded[reg])
+				stored[reg] = true;
+			const unsigned target = insn.loose.target;
+			if (target < E_HPOSP0 || (target > E_HPOSP3 && target < E_TARGET_MAX))
+			{
+				if (offset < 0)
+					live.mem_regs[target] = 0;
+			}
+			break;
+		}
+		}
+		cycle += GetInstructionCycles(insn);
+	}
+	if (loaded[0] || (antic4 && schedule.chbase_transition && !stored[0]))
+		live.reg_a = 0;
+	if (loaded[1])
+		live.reg_x = 0;
+	if (loaded[2])
+		live.reg_y = 0;
+	return live;
+}
+
 #endif
@@ -0,0 +1,235 @@
+#ifndef SHAREDLINECACHE_H
+#define SHAREDLINECACHE_H
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "LineCache.h"
+
+// A line result as published to the shared tier: the key it was rendered
+// under, by instruction content rather than by the interning pointer of the
+// worker that rendered it, and the result itself.
+struct shared_line_record
+{
+	uint32_t hash;
+	uint32_t insn_count;
+	uint64_t attribute_row;
+	register_state entry_state;
+	register_state new_state;
+	distance_accum_t line_error;
+	uint32_t sprite_bits;
+
+	// Followed by the instructions, the colour row and the packed target row.
+	const SRasterInstruction *insns() const
+	{
+		return reinterpret_cast<const SRasterInstruction *>(this + 1);
+	}
+
+	const unsigned char *color_row() const
+	{
+		return reinterpret_cast<const unsigned char *>(insns() + insn_count);
+	}
+};
+
+// Line results shared by the workers of one single-frame search. A worker
+// that misses its private cache looks here before rendering, and publishes
+// the lines of every picture it accepts. Each line has its own bucket array
+// of record pointers; a record is found within PROBES buckets of its hash or
+// not at all. Records are immutable once published and only freed by clear(),
+// which callers make while no worker is evaluating, so readers take no locks.
+// Every worker allocates from its own shard and stops publishing when that
+// shard's share of the budget is used up.
+class shared_line_cache
+{
+public:
+	static constexpr unsigned PROBES = 8;
+
+	shared_line_cache()
+		: m_width(0)
+		, m_height(0)
+		, m_capacity(0)
+		, m_shard_budget(0)
+	{
+	}
+
+	shared_line_cache(const shared_line_cache&) = delete;
+	shared_line_cache& operator=(const shared_line_cache&) = delete;
+
+	// A zero budget disables the tier. A zero `width` publishes results
+	// without their rows, for workers whose caches keep none.
+	void configure(unsigned width, unsigned height, size_t budget, unsigned shards)
+	{
+		m_width = width;
+		m_height = height;
+		m_shards.clear();
+		m_buckets.reset();
+		m_capacity = 0;
+		if (budget == 0 || height == 0 || shards == 0)
+			return;
+
+		// Twice as many buckets as records a typical line result leaves room
+		// for, so probe windows rarely fill before the budget does.
+		const size_t typical = record_bytes(40);
+		size_t capacity = 64;
+		while (capacity * height < 2 * (budget / typical))
+			capacity *= 2;
+		m_capacity = capacity;
+		m_buckets.reset(new std::atomic<const shared_line_record *>[capacity * height]);
+		m_shard_budget = budget / shards;
+		m_shards.resize(shards);
+		for (shard& s : m_shards)
+			s.arena = linear_allocator(std::min<size_t>(linear_allocator::BLOCK_SIZE,
+				std::max<size_t>(m_shard_budget / 4, 65536)));
+		clear();
+	}
+
+	// Only while no worker can be reading or publishing.
+	void clear()
+	{
+		for (size_t i = 0; i < m_capacity * m_height; ++i)
+			m_buckets[i].store(NULL, std::memory_order_relaxed);
+		for (shard& s : m_shards)
+			s.arena.clear();
+	}
+
+	bool enabled() const { return m_capacity != 0; }
+	unsigned shards() const { return static_cast<unsigned>(m_shards.size()); }
+
+	// Hashes the entry state and the content of the instruction sequence, so
+	// workers that interned the same line separately agree.
+	static uint32_t hash(const line_cache_key& key, uint64_t attribute_row)
+	{
+		line_cache_key state = key;
+		state.insn_seq = NULL;
+		uint32_t value = state.hash();
+		const uint64_t sequence_hash = key.insn_seq->hash;
+		value += static_cast<uint32_t>(sequence_hash ^ (sequence_hash >> 32)) * 0x9e3779b9u;
+		value += static_cast<uint32_t>(attribute_row);
+		value += static_cast<uint32_t>(attribute_row >> 32) * 0x85ebca6bu;
+		value += (value * 0x1a572cf3) >> 20;
+		return value;
+	}
+
+	const shared_line_record *find(unsigned y, const line_cache_key& key,
+		uint64_t attribute_row, uint32_t hash) const
+	{
+		const std::atomic<const shared_line_record *> *buckets = &m_buckets[y * m_capacity];
+		for (unsigned probe = 0; probe < PROBES; ++probe)
+		{
+			const shared_line_record *record =
+				buckets[(hash + probe) & (m_capacity - 1)].load(std::memory_order_acquire);
+			if (!record)
+				return NULL;
+			if (matches(*record, key, attribute_row, hash))
+				return record;
+		}
+		return NULL;
+	}
+
+	// Copies `result` into the tier from worker `shard`. Returns false when
+	// the shard's budget is spent or the line's probe window is full; a
+	// result another worker already published counts as published.
+	bool publish(unsigned shard, unsigned y, const line_cache_key& key,
+		uint64_t attribute_row, uint32_t hash, const line_cache_result& result)
+	{
+		std::atomic<const shared_line_record *> *buckets = &m_buckets[y * m_capacity];
+		unsigned probe = 0;
+		for (; probe < PROBES; ++probe)
+		{
+			const shared_line_record *record =
+				buckets[(hash + probe) & (m_capacity - 1)].load(std::memory_order_acquire);
+			if (!record)
+				break;
+			if (matches(*record, key, attribute_row, hash))
+				return true;
+		}
+		if (probe == PROBES)
+			return false;
+
+		linear_allocator& arena = m_shards[shard].arena;
+		const unsigned insn_count = key.insn_seq->insn_count;
+		const size_t bytes = record_bytes(insn_count);
+		if (arena.size() + (arena.available() >= bytes ? 0 : arena.block_size()) > m_shard_budget)
+			return false;
+		shared_line_record *record = static_cast<shared_line_record *>(
+			arena.allocate(bytes, linear_allocator::LINE_CACHE_ENTRY));
+		record->hash = hash;
+		record->insn_count = insn_count;
+		record->attribute_row = attribute_row;
+		record->entry_state = key.entry_state;
+		record->new_state = result.new_state;
+		record->line_error = result.line_error;
+		record->sprite_bits = result.sprite_bits;
+		unsigned char *insns = reinterpret_cast<unsigned char *>(record + 1);
+		if (insn_count)
+			memcpy(insns, key.insn_seq->insns, insn_count * sizeof(SRasterInstruction));
+		if (m_width)
+		{
+			unsigned char *color_row = insns + insn_count * sizeof(SRasterInstruction);
+			memcpy(color_row, result.color_row, m_width);
+			memcpy(color_row + m_width, result.packed_target_row,
+				line_cache_result::packed_target_bytes(m_width));
+		}
+
+		// Another worker may take the bucket first; its record is as good.
+		for (; probe < PROBES; ++probe)
+		{
+			const shared_line_record *expected = NULL;
+			if (buckets[(hash + probe) & (m_capacity - 1)].compare_exchange_strong(
+					expected, record, std::memory_order_release, std::memory_order_acquire))
+				return true;
+			if (matches(*expected, key, attribute_row, hash))
+				return true;
+		}
+		return false;
+	}
+
+	// Fills a private result, whose rows are already allocated, from `record`.
+	void copy(const shared_line_record& record, line_cache_result& result) const
+	{
+		result.line_error = record.line_error;
+		result.new_state = record.new_state;
+		result.sprite_bits = record.sprite_bits;
+		if (!m_width)
+			return;
+		memcpy(result.color_row, record.color_row(), m_width);
+		memcpy(result.packed_target_row, record.color_row() + m_width,
+			line_cache_result::packed_target_bytes(m_width));
+	}
+
+private:
+	struct alignas(64) shard
+	{
+		linear_allocator arena;
+	};
+
+	size_t record_bytes(unsigned insn_count) const
+	{
+		return sizeof(shared_line_record) + insn_count * sizeof(SRasterInstruction)
+			+ m_width + line_cache_result::packed_target_bytes(m_width);
+	}
+
+	static bool matches(const shared_line_record& record, const line_cache_key& key,
+		uint64_t attribute_row, uint32_t hash)
+	{
+		return record.hash == hash
+			&& record.insn_count == key.insn_seq->insn_count
+			&& record.attribute_row == attribute_row
+			&& !memcmp(&record.entry_state, &key.entry_state, sizeof record.entry_state)
+			&& (!record.insn_count || !memcmp(record.insns(), key.insn_seq->insns,
+				record.insn_count * sizeof(SRasterInstruction)));
+	}
+
+	unsigned m_width;
+	unsigned m_height;
+	size_t m_capacity;
+	size_t m_shard_budget;
+	std::unique_ptr<std::atomic<const shared_line_record *>[]> m_buckets;
+	std::vector<shard> m_shards;
+};
+
+#endif
@@ -0,0 +1,259 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+
+static thread_local const ThreadPool* t_pool = nullptr;
+static thread_local int t_worker = -1;
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned i = 0; i < threads; ++i)
+		m_workers.push_back(std::make_unique<Worker>());
+	for (unsigned i = 0; i < threads; ++i)
+		m_workers[i]->thread = std::thread(&ThreadPool::WorkerMain, this, static_cast<int>(i));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleep_mutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+	for (const std::unique_ptr<Worker>& worker : m_workers)
+		worker->thread.join();
+}
+
+ThreadPool& ThreadPool::Instance()
+{
+	// Never destroyed: joining at static destruction would race whatever other
+	// statics the last tasks still use.
+	static ThreadPool* pool = new ThreadPool();
+	return *pool;
+}
+
+bool ThreadPool::OnPoolThread() const
+{
+	return t_pool == this;
+}
+
+void ThreadPool::Submit(Task task)
+{
+	// Counted before it is visible, so a thread that takes it never sees the
+	// count underflow.
+	m_queued.fetch_add(1, std::memory_order_acq_rel);
+	if (OnPoolThread())
+	{
+		Worker& own = *m_workers[t_worker];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		own.tasks.push_back(std::move(task));
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(m_injected_mutex);
+		m_injected.push_back(std::move(task));
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_sleep_mutex);
+	}
+	m_wake.notify_one();
+}
+
+bool ThreadPool::TakeTask(int self, Task& task)
+{
+	const int count = static_cast<int>(m_workers.size());
+	bool taken = false;
+	if (self >= 0)
+	{
+		Worker& own = *m_workers[self];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty())
+		{
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			taken = true;
+		}
+	}
+	if (!taken)
+	{
+		std::lock_guard<std::mutex> lock(m_injected_mutex);
+		if (!m_injected.empty())
+		{
+			task = std::move(m_injected.front());
+			m_injected.pop_front();
+			taken = true;
+		}
+	}
+	for (int k = 1; !taken && k <= count; ++k)
+	{
+		Worker& victim = *m_workers[(std::max(self, 0) + k) % count];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			taken = true;
+		}
+	}
+	if (taken)
+		m_queued.fetch_sub(1, std::memory_order_acq_rel);
+	return taken;
+}
+
+bool ThreadPool::RunPendingTask()
+{
+	Task task;
+	if (!TakeTask(OnPoolThread() ? t_worker : -1, task))
+		return false;
+	task();
+	return true;
+}
+
+void ThreadPool::WorkerMain(int self)
+{
+	t_pool = this;
+	t_worker = self;
+	for (;;)
+	{
+		Task task;
+		if (TakeTask(self, task))
+		{
+			task();
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(m_sleep_mutex);
+		m_wake.wait(lock, [this] {
+			return m_stopping || m_queued.load(std::memory_order_acquire) > 0;
+		});
+		if (m_stopping && m_queued.load(std::memory_order_acquire) == 0)
+			return;
+	}
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool, CancellationToken token)
+	: m_pool(pool), m_token(std::move(token)), m_state(std::make_shared<State>())
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+	try
+	{
+		Wait();
+	}
+	catch (...)
+	{
+	}
+}
+
+void TaskGroup::Run(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_state->mutex);
+		++m_state->pending;
+	}
+	m_pool.Submit([state = m_state, token = m_token, task = std::move(task)] {
+		if (!token.Cancelled())
+		{
+			try
+			{
+				task();
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				if (!state->error)
+					state->error = std::current_exception();
+			}
+		}
+		std::lock_guard<std::mutex> lock(state->mutex);
+		if (--state->pending == 0)
+			state->finished.notify_all();
+	});
+}
+
+bool TaskGroup::Done() const
+{
+	std::lock_guard<std::mutex> lock(m_state->mutex);
+	return m_state->pending == 0;
+}
+
+void TaskGroup::Wait()
+{
+	if (m_pool.OnPoolThread())
+	{
+		while (!Done())
+		{
+			if (m_pool.RunPendingTask())
+				continue;
+			// Our remaining tasks are running elsewhere.
+			std::unique_lock<std::mutex> lock(m_state->mutex);
+			m_state->finished.wait_for(lock, std::chrono::milliseconds(1),
+				[this] { return m_state->pending == 0; });
+		}
+	}
+	std::exception_ptr error;
+	{
+		std::unique_lock<std::mutex> lock(m_state->mutex);
+		m_state->finished.wait(lock, [this] { return m_state->pending == 0; });
+		std::swap(error, m_state->error);
+	}
+	if (error)
+		std::rethrow_exception(error);
+}
+
+void TaskGroup::RunChunked(int begin, int end, int grain, int concurrency,
+	std::function<void(int, int)> body)
+{
+	if (end <= begin)
+		return;
+	grain = std::max(grain, 1);
+	const long long chunks = ((long long)end - begin + grain - 1) / grain;
+	long long tasks = concurrency > 0 ? concurrency : m_pool.ThreadCount();
+	tasks = std::min(tasks, chunks);
+
+	struct Shared
+	{
+		std::atomic<long long> next{0};
+		std::function<void(int, int)> body;
+	};
+	auto shared = std::make_shared<Shared>();
+	shared->body = std::move(body);
+	for (long long t = 0; t < tasks; ++t)
+	{
+		Run([shared, token = m_token, begin, end, grain, chunks] {
+			for (long long chunk; !token.Cancelled()
+				&& (chunk = shared->next.fetch_add(1)) < chunks; )
+			{
+				const long long from = begin + chunk * grain;
+				shared->body(static_cast<int>(from),
+					static_cast<int>(std::min<long long>(end, from + grain)));
+			}
+		});
+	}
+}
+
+void ParallelFor(int begin, int end, int grain, int concurrency,
+	const std::function<void(int, int)>& body,
+	const CancellationToken& token, ThreadPool& pool)
+{
+	if (end <= begin)
+		return;
+	grain = std::max(grain, 1);
+	if (end - begin <= grain || concurrency == 1)
+	{
+		for (int from = begin; from < end && !token.Cancelled(); )
+		{
+			const int to = end - from > grain ? from + grain : end;
+			body(from, to);
+			from = to;
+		}
+		return;
+	}
+	TaskGroup group(pool, token);
+	group.RunChunked(begin, end, grain, concurrency, body);
+	group.Wait();
+}
@@ -0,0 +1,155 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// One set of threads for the preprocessing and auxiliary stages: dithering,
+// the error planes, the setup preview and the gallery's executable builds.
+// The optimizer's search threads are long-lived and stay outside it.
+//
+// Tasks submitted from outside the pool go to a shared FIFO queue, so they
+// start in the order they were queued. Tasks a pool thread submits go to its
+// own deque. The thread takes its newest task first, and idle threads steal
+// the oldest tasks from other deques.
+//
+// The pool has a thread per hardware thread. Loops say how many of them they
+// may use (RunChunked, ParallelFor), so /threads still bounds the work.
+
+// Shared stop flag. Copies refer to the same flag.
+class CancellationToken
+{
+public:
+	CancellationToken() : m_flag(std::make_shared<std::atomic<bool>>(false)) {}
+
+	void Cancel() const { m_flag->store(true, std::memory_order_release); }
+	bool Cancelled() const { return m_flag->load(std::memory_order_acquire); }
+
+private:
+	std::shared_ptr<std::atomic<bool>> m_flag;
+};
+
+class ThreadPool
+{
+public:
+	using Task = std::function<void()>;
+
+	// Zero threads means hardware_concurrency().
+	explicit ThreadPool(unsigned threads = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// The process-wide pool, started on first use.
+	static ThreadPool& Instance();
+
+	unsigned ThreadCount() const { return static_cast<unsigned>(m_workers.size()); }
+
+	void Submit(Task task);
+
+	// Runs one queued task on the calling thread. False when there was none.
+	bool RunPendingTask();
+
+	// True on a thread of this pool.
+	bool OnPoolThread() const;
+
+private:
+	struct Worker
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+		std::thread thread;
+	};
+
+	bool TakeTask(int self, Task& task);
+	void WorkerMain(int self);
+
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	std::mutex m_injected_mutex;
+	std::deque<Task> m_injected;
+	// Tasks queued but not yet taken. Idle threads sleep while it is zero.
+	std::atomic<std::size_t> m_queued{0};
+	std::mutex m_sleep_mutex;
+	std::condition_variable m_wake;
+	bool m_stopping = false;
+};
+
+// Tasks that are waited for together. A task that has not started when the
+// token is cancelled is skipped. Running tasks poll Token() themselves.
+// The destructor waits, so tasks may refer to the caller's locals.
+class TaskGroup
+{
+public:
+	explicit TaskGroup(ThreadPool& pool = ThreadPool::Instance(),
+		CancellationToken token = CancellationToken());
+	~TaskGroup();
+
+	TaskGroup(const TaskGroup&) = delete;
+	TaskGroup& operator=(const TaskGroup&) = delete;
+
+	void Run(std::function<void()> task);
+
+	// Runs body(from, to) over [begin, end) in chunks of at most grain items,
+	// on at most concurrency threads at once (0: the whole pool). Each task
+	// takes the next chunk when it finishes one, so uneven chunks still
+	// balance. Does not wait; chunks left once the token is cancelled are
+	// skipped.
+	void RunChunked(int begin, int end, int grain, int concurrency,
+		std::function<void(int, int)> body);
+
+	// Like Run, with a future for the result. A task skipped by cancellation
+	// leaves the future holding std::future_error (broken promise).
+	template <class F>
+	std::future<typename std::invoke_result<F>::type> Async(F fn)
+	{
+		using Result = typename std::invoke_result<F>::type;
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::move(fn));
+		std::future<Result> result = task->get_future();
+		Run([task] { (*task)(); });
+		return result;
+	}
+
+	// Blocks until every task has finished, then rethrows the first exception
+	// a task threw. On a pool thread it runs other queued tasks meanwhile, so
+	// nested groups cannot starve the pool.
+	void Wait();
+	// True when no task is queued or running. For callers that must keep
+	// pumping a UI instead of blocking.
+	bool Done() const;
+
+	void Cancel() { m_token.Cancel(); }
+	const CancellationToken& Token() const { return m_token; }
+
+private:
+	struct State
+	{
+		mutable std::mutex mutex;
+		std::condition_variable finished;
+		std::size_t pending = 0;
+		std::exception_ptr error;
+	};
+
+	ThreadPool& m_pool;
+	CancellationToken m_token;
+	std::shared_ptr<State> m_state;
+};
+
+// RunChunked and wait. With a single chunk or a concurrency of one, the
+// chunks run on the calling thread instead.
+void ParallelFor(int begin, int end, int grain, int concurrency,
+	const std::function<void(int, int)>& body,
+	const CancellationToken& token = CancellationToken(),
+	ThreadPool& pool = ThreadPool::Instance());
+
+#endif
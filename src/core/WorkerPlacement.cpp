@@ -0,0 +1,243 @@
+#include "WorkerPlacement.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+int CpuTopology::NodeCount() const
+{
+	std::vector<int> nodes;
+	for (const Cpu& cpu : cpus)
+		if (std::find(nodes.begin(), nodes.end(), cpu.node) == nodes.end())
+			nodes.push_back(cpu.node);
+	return static_cast<int>(nodes.size());
+}
+
+std::vector<int> WorkerPlacement::Nodes() const
+{
+	std::vector<int> nodes;
+	for (int n : node)
+		if (n >= 0 && std::find(nodes.begin(), nodes.end(), n) == nodes.end())
+			nodes.push_back(n);
+	std::sort(nodes.begin(), nodes.end());
+	return nodes;
+}
+
+std::vector<int> ParseCpuList(const std::string& text)
+{
+	std::vector<int> cpus;
+	std::stringstream ranges(text);
+	std::string range;
+	while (std::getline(ranges, range, ','))
+	{
+		int first = 0, last = 0;
+		const int fields = std::sscanf(range.c_str(), "%d-%d", &first, &last);
+		if (fields < 1 || first < 0)
+			continue;
+		if (fields == 1)
+			last = first;
+		for (int cpu = first; cpu <= last; ++cpu)
+			cpus.push_back(cpu);
+	}
+	return cpus;
+}
+
+#ifdef __linux__
+static int ReadSysfsInt(const std::string& path, int fallback)
+{
+	std::ifstream file(path);
+	int value;
+	return (file >> value) ? value : fallback;
+}
+#endif
+
+CpuTopology CpuTopology::Detect()
+{
+	CpuTopology topology;
+#ifdef __linux__
+	cpu_set_t mask;
+	CPU_ZERO(&mask);
+	if (sched_getaffinity(0, sizeof mask, &mask) == 0)
+	{
+		std::map<int, int> nodeOf;
+		if (DIR* dir = opendir("/sys/devices/system/node"))
+		{
+			while (dirent* entry = readdir(dir))
+			{
+				int node;
+				if (std::sscanf(entry->d_name, "node%d", &node) != 1)
+					continue;
+				std::ifstream file(std::string("/sys/devices/system/node/")
+					+ entry->d_name + "/cpulist");
+				std::string list;
+				std::getline(file, list);
+				for (int cpu : ParseCpuList(list))
+					nodeOf[cpu] = node;
+			}
+			closedir(dir);
+		}
+		for (int id = 0; id < CPU_SETSIZE; ++id)
+		{
+			if (!CPU_ISSET(id, &mask))
+				continue;
+			const std::string base = "/sys/devices/system/cpu/cpu"
+				+ std::to_string(id) + "/topology/";
+			Cpu cpu;
+			cpu.id = id;
+			cpu.core = ReadSysfsInt(base + "core_id", id);
+			cpu.package = ReadSysfsInt(base + "physical_package_id", 0);
+			const auto node = nodeOf.find(id);
+			cpu.node = node != nodeOf.end() ? node->second : 0;
+			topology.cpus.push_back(cpu);
+		}
+	}
+#endif
+	if (topology.cpus.empty())
+	{
+		const unsigned count = std::max(1u, std::thread::hardware_concurrency());
+		for (unsigned id = 0; id < count; ++id)
+		{
+			Cpu cpu;
+			cpu.id = cpu.core = static_cast<int>(id);
+			topology.cpus.push_back(cpu);
+		}
+	}
+	return topology;
+}
+
+WorkerPlacement PlanWorkerPlacement(const CpuTopology& topology, PinPolicy policy,
+	size_t workers)
+{
+	WorkerPlacement placement;
+	placement.cpu.assign(workers, -1);
+	placement.node.assign(workers, -1);
+	if (policy == PinPolicy::None || topology.cpus.empty() || workers == 0)
+		return placement;
+
+	// Each node's CPUs grouped by physical core, cores in CPU order.
+	std::map<int, std::vector<std::vector<const CpuTopology::Cpu*>>> nodes;
+	for (const CpuTopology::Cpu& cpu : topology.cpus)
+	{
+		std::vector<std::vector<const CpuTopology::Cpu*>>& cores = nodes[cpu.node];
+		auto core = std::find_if(cores.begin(), cores.end(),
+			[&](const std::vector<const CpuTopology::Cpu*>& siblings) {
+				return siblings.front()->package == cpu.package
+					&& siblings.front()->core == cpu.core;
+			});
+		if (core == cores.end())
+			cores.push_back({&cpu});
+		else
+			core->push_back(&cpu);
+	}
+
+	std::vector<std::vector<const CpuTopology::Cpu*>> order;
+	for (auto& node : nodes)
+	{
+		std::vector<const CpuTopology::Cpu*> cpus;
+		if (policy == PinPolicy::Smt)
+		{
+			for (const auto& siblings : node.second)
+				cpus.insert(cpus.end(), siblings.begin(), siblings.end());
+		}
+		else
+		{
+			for (size_t thread = 0;; ++thread)
+			{
+				bool any = false;
+				for (const auto& siblings : node.second)
+					if (thread < siblings.size())
+					{
+						cpus.push_back(siblings[thread]);
+						any = true;
+					}
+				if (!any)
+					break;
+			}
+		}
+		order.push_back(cpus);
+	}
+
+	// Round-robin over the nodes; a node that runs out of CPUs is skipped
+	// until every node has, then the whole order repeats.
+	std::vector<const CpuTopology::Cpu*> sequence;
+	for (size_t i = 0; sequence.size() < topology.cpus.size(); ++i)
+		for (const auto& cpus : order)
+			if (i < cpus.size())
+				sequence.push_back(cpus[i]);
+	for (size_t worker = 0; worker < workers; ++worker)
+	{
+		const CpuTopology::Cpu* cpu = sequence[worker % sequence.size()];
+		placement.cpu[worker] = cpu->id;
+		placement.node[worker] = cpu->node;
+	}
+	return placement;
+}
+
+std::string DescribeWorkerPlacement(const CpuTopology& topology,
+	const WorkerPlacement& placement, PinPolicy policy)
+{
+	std::ostringstream text;
+	text << placement.cpu.size() << " worker(s) on " << topology.cpus.size()
+		<< " CPU(s), " << topology.NodeCount() << " node(s)";
+	if (!placement.Pinned())
+	{
+		text << ", not pinned";
+		return text.str();
+	}
+	text << ", pinned " << (policy == PinPolicy::Smt ? "smt" : "cores") << " first";
+	const char* nodeSeparator = ": ";
+	for (int node : placement.Nodes())
+	{
+		text << nodeSeparator << "node " << node << " cpu";
+		const char* separator = " ";
+		for (size_t worker = 0; worker < placement.cpu.size(); ++worker)
+			if (placement.node[worker] == node)
+			{
+				text << separator << placement.cpu[worker];
+				separator = ",";
+			}
+		nodeSeparator = "; ";
+	}
+	return text.str();
+}
+
+bool PinCurrentThread(int cpu)
+{
+#ifdef __linux__
+	if (cpu < 0 || cpu >= CPU_SETSIZE)
+		return false;
+	cpu_set_t mask;
+	CPU_ZERO(&mask);
+	CPU_SET(cpu, &mask);
+	return pthread_setaffinity_np(pthread_self(), sizeof mask, &mask) == 0;
+#else
+	(void)cpu;
+	return false;
+#endif
+}
+
+void RunOnNode(const CpuTopology& topology, int node, const std::function<void()>& work)
+{
+	const auto cpu = std::find_if(topology.cpus.begin(), topology.cpus.end(),
+		[node](const CpuTopology::Cpu& c) { return c.node == node; });
+	if (cpu == topology.cpus.end())
+	{
+		work();
+		return;
+	}
+	const int id = cpu->id;
+	std::thread thread([id, &work] {
+		PinCurrentThread(id);
+		work();
+	});
+	thread.join();
+}
@@ -0,0 +1,81 @@
+#ifndef WORKERPLACEMENT_H
+#define WORKERPLACEMENT_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Where worker threads run (/pin). Each worker reads the colour error planes
+// on every evaluation and grows its line cache arenas as it goes. On a
+// multi-socket host a worker on the far node pays the interconnect for both.
+// Pinned workers keep their caches warm and first-touch their arenas on
+// their own node. The scoring tables are replicated once per node they run on.
+
+// Logical CPUs this process may run on.
+struct CpuTopology
+{
+	struct Cpu
+	{
+		int id = 0;
+		// Physical core and package, as the kernel numbers them. SMT siblings
+		// share both.
+		int core = 0;
+		int package = 0;
+		int node = 0;
+	};
+	std::vector<Cpu> cpus;
+
+	int NodeCount() const;
+
+	// The CPUs in this process's affinity mask, read from sysfs on Linux.
+	// Elsewhere one node of hardware_concurrency() single-thread cores.
+	static CpuTopology Detect();
+};
+
+enum class PinPolicy
+{
+	// Threads float wherever the OS schedules them.
+	None,
+	// One worker per physical core; SMT siblings only once every core in
+	// the mask has one.
+	Cores,
+	// Both hardware threads of a core before the next core, so a run leaves
+	// whole cores free for other work.
+	Smt,
+};
+
+struct WorkerPlacement
+{
+	// Per worker: the CPU it is pinned to and that CPU's node, both -1 when
+	// it is not pinned.
+	std::vector<int> cpu;
+	std::vector<int> node;
+
+	bool Pinned() const { return !cpu.empty() && cpu.front() >= 0; }
+	// Nodes with at least one worker, ascending.
+	std::vector<int> Nodes() const;
+};
+
+// Spreads workers round-robin over the nodes, so each node scores its share
+// from its own tables, and orders each node's CPUs as the policy asks. More
+// workers than CPUs wrap around.
+WorkerPlacement PlanWorkerPlacement(const CpuTopology& topology, PinPolicy policy,
+	size_t workers);
+
+// One line for the startup report and the .rp footer, e.g.
+// "4 worker(s) on 8 CPU(s), 2 node(s), pinned cores first: node 0 cpu 0,1; node 1 cpu 4,5".
+std::string DescribeWorkerPlacement(const CpuTopology& topology,
+	const WorkerPlacement& placement, PinPolicy policy);
+
+// "0-3,8,10-11" as used by sysfs cpulist files.
+std::vector<int> ParseCpuList(const std::string& text);
+
+// False where thread affinity is not supported or the CPU was refused.
+bool PinCurrentThread(int cpu);
+
+// Runs work on a thread pinned to the first CPU of node and waits for it, so
+// memory the work first touches is placed on that node. Runs on the calling
+// thread when none of the node's CPUs is in the topology.
+void RunOnNode(const CpuTopology& topology, int node, const std::function<void()>& work);
+
+#endif
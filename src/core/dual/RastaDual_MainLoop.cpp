@@ -266,6 +266,7 @@ void RastaConverter::MainLoopDual()
 			Evaluator& ev = m_evaluators[tid];
 			std::vector<const line_cache_result*> line_results(m_height, nullptr);
 			raster_picture localBest = bestA;
+			unsigned long long localAllocatorEpoch = ev.AllocatorEpoch();
 			// Keep a local view of accepted cost to detect external improvements
 			double localAcceptedCost; {
 				std::unique_lock<std::mutex> lock{ m_eval_gstate.m_mutex };
@@ -285,6 +286,11 @@ void RastaConverter::MainLoopDual()
 				raster_picture cand = localBest;
 				ev.MutateRasterProgram(&cand);
 				distance_accum_t cost = ev.ExecuteRasterProgram(&cand, line_results.data());
+				// A memory-guard clear frees the sequences localBest's keys point to.
+				if (ev.AllocatorEpoch() != localAllocatorEpoch) {
+					localBest.uncache_insns();
+					localAllocatorEpoch = ev.AllocatorEpoch();
+				}
 				{
 					std::unique_lock<std::mutex> lock{ m_eval_gstate.m_mutex };
 					if (m_eval_gstate.m_finished || m_eval_gstate.m_evaluations >= targetE_A) break;
@@ -432,6 +438,7 @@ void RastaConverter::MainLoopDual()
 				Evaluator& ev = m_evaluators[tid];
 				std::vector<const line_cache_result*> line_results(m_height, nullptr);
 				raster_picture localB = m_best_pic_B;
+				unsigned long long localAllocatorEpoch = ev.AllocatorEpoch();
 				// Keep a local view of accepted cost to detect external improvements (global best)
 				double localAcceptedCost; {
 					std::unique_lock<std::mutex> lock{ m_eval_gstate.m_mutex };
@@ -459,6 +466,10 @@ void RastaConverter::MainLoopDual()
 					raster_picture cand = localB;
 					ev.MutateRasterProgram(&cand);
 					distance_accum_t cost = ev.ExecuteRasterProgram(&cand, line_results.data());
+					if (ev.AllocatorEpoch() != localAllocatorEpoch) {
+						localB.uncache_insns();
+						localAllocatorEpoch = ev.AllocatorEpoch();
+					}
 					{
 						std::unique_lock<std::mutex> lock{ m_eval_gstate.m_mutex };
 						if (m_eval_gstate.m_finished || m_eval_gstate.m_evaluations >= targetE_B) break;
@@ -748,6 +759,8 @@ void RastaConverter::MainLoopDual()
 		workers.emplace_back([this, tid]() {
 			// Use long-lived evaluator to preserve legacy acceptance state
 			Evaluator& ev = m_evaluators[tid];
+			if (ev.PlacementCpu() >= 0)
+				PinCurrentThread(ev.PlacementCpu());
 			// Configure dual input-based targets for alternating phase
 			ev.SetDualTables(m_palette_y, m_palette_u, m_palette_v,
 				 m_pair_Ysum.data(), m_pair_Usum.data(), m_pair_Vsum.data(),
@@ -810,6 +823,18 @@ void RastaConverter::MainLoopDual()
 			};
 			rebuildRowPointers(currentRowsA, rowPointersA);
 			rebuildRowPointers(currentRowsB, rowPointersB);
+			// Retained programs keep cache keys into this evaluator's instruction
+			// allocator; a memory-guard clear inside an evaluation frees them.
+			unsigned long long localAllocatorEpoch = ev.AllocatorEpoch();
+			auto dropStaleCacheKeys = [&]() {
+				if (ev.AllocatorEpoch() == localAllocatorEpoch)
+					return;
+				currentA.uncache_insns();
+				currentB.uncache_insns();
+				islandState.currentA.uncache_insns();
+				islandState.currentB.uncache_insns();
+				localAllocatorEpoch = ev.AllocatorEpoch();
+			};
 
 			// Track current phase to detect switches for simple fixed frame snapshots
 			bool local_mutateB = m_eval_gstate.m_dual_stage_focus_B.load(std::memory_order_relaxed);
@@ -858,6 +883,7 @@ void RastaConverter::MainLoopDual()
 						raster_picture& completedProgram = islandState.Current(local_mutateB);
 						(void)ev.ExecuteRasterProgramDual(&completedProgram, line_results.data(),
 							fixedRows, local_mutateB);
+						dropStaleCacheKeys();
 						if (local_mutateB) {
 							UpdateCreatedFromResults(line_results, currentRowsB);
 							UpdateTargetsFromResults(line_results, currentTargetsB);
@@ -968,6 +994,7 @@ void RastaConverter::MainLoopDual()
 					localUndoLineSnapshots += mutationTransaction.SavedLineCount();
 				const distance_accum_t cost = ev.ExecuteRasterProgramDual(
 					evaluatedCandidate, line_results.data(), *otherRows, mutateB);
+				dropStaleCacheKeys();
 
 				Evaluator::AcceptanceOutcome out{false, false, localAcceptedCost};
 				if (islandMode) {
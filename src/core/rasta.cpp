@@ -55,6 +55,7 @@ const char* program_version = RASTA_CONVERTER_VERSION;
 #include "Interrupt.h"
 #include "ColorCorrection.h"
 #include "prng_xoroshiro.h"
+#include "CpuDispatch.h"
 #include "LinearAllocator.h"
 #include "LineCache.h"
 #include "Program.h"
@@ -62,6 +63,7 @@ const char* program_version = RASTA_CONVERTER_VERSION;
 #include "StructuredSolver.h"
 #include "TargetPicture.h"
 #include "TargetBuilder.h"
+#include "ThreadPool.h"
 #include "debug_log.h"
 #include "FreeImageIO.h"
 #include "Utf8Path.h"
@@ -399,7 +401,8 @@ void RastaConverter::SaveStatistics(const char *fn)
     }
 }
 
-void RastaConverter::SaveOptimizerState(const char* fn, const raster_picture* picture) {
+void RastaConverter::SaveOptimizerState(const char* fn, const raster_picture* picture,
+	const OptimizerState* published) {
     std::ofstream out(Utf8Path(fn), std::ios::out | std::ios::trunc);
     if (!out)
     {
@@ -419,22 +422,29 @@ void RastaConverter::SaveOptimizerState(const char* fn, const raster_picture* pi
     }
     out << opt << '\n';
 
-    out << static_cast<unsigned long long>(m_eval_gstate.m_evaluations) << '\n';
+    out << m_eval_gstate.CompletedEvaluations() << '\n';
     out << static_cast<unsigned long long>(m_eval_gstate.m_last_best_evaluation) << '\n';
 
-	out << static_cast<unsigned long>(m_eval_gstate.m_previous_results.size()) << '\n';
+	// Island workers hand their history over with the snapshot they publish
+	// instead of writing the shared fields.
+	const std::vector<double>& previous_results =
+		published ? published->history : m_eval_gstate.m_previous_results;
+	out << static_cast<unsigned long>(previous_results.size()) << '\n';
 	{
-		unsigned long history_size = (unsigned long)m_eval_gstate.m_previous_results.size();
-		unsigned long original_index = (unsigned long)m_eval_gstate.m_previous_results_index;
+		unsigned long history_size = (unsigned long)previous_results.size();
+		unsigned long original_index = (unsigned long)(published
+			? published->historyIndex : m_eval_gstate.m_previous_results_index);
 		unsigned long history_index = (history_size > 0) ? (original_index % history_size) : 0UL;
 		out << history_index << '\n';
 	}
-    out << std::setprecision(21) << static_cast<long double>(m_eval_gstate.m_cost_max) << '\n';
-    out << m_eval_gstate.m_N << '\n';
-    out << std::setprecision(21) << static_cast<long double>(m_eval_gstate.m_current_cost) << '\n';
+    out << std::setprecision(21) << static_cast<long double>(
+		published ? published->costMax : m_eval_gstate.m_cost_max) << '\n';
+    out << (published ? published->maxCount : m_eval_gstate.m_N) << '\n';
+    out << std::setprecision(21) << static_cast<long double>(
+		published ? published->currentCost : m_eval_gstate.m_current_cost) << '\n';
 
     out << std::setprecision(21);
-    for (double value : m_eval_gstate.m_previous_results)
+    for (double value : previous_results)
     {
         out << static_cast<long double>(value) << '\n';
     }
@@ -792,37 +802,105 @@ void RastaConverter::GeneratePictureErrorMap()
 		(cfg.visual_objective == E_OBJECTIVE_LEGACY_TARGET)
 			? m_picture : m_picture_original;
 
-	for(int i=0; i<128; ++i)
-	{
-		m_picture_all_errors[i].resize(w * h);
-
-		const rgb ref = atari_palette[i];
-
-		distance_t *dst = &m_picture_all_errors[i][0];
-		for (int y=0; y<h; ++y)
+	// One plane per palette entry, each independent. With CIEDE2000 this is
+	// 128 full-frame passes of the slowest metric, so it runs on the pool.
+	ParallelFor(0, 128, 1, cfg.threads, [&](int first, int last) {
+		for (int i = first; i < last; ++i)
 		{
-			const screen_line& srcrow = scoring_picture[y];
+			m_picture_all_errors[i].resize(w * h);
+
+			const rgb ref = atari_palette[i];
 
-			if (!details_mask.Empty() && cfg.details_score)
+			distance_t *dst = &m_picture_all_errors[i][0];
+			for (int y=0; y<h; ++y)
 			{
-				for (int x=0; x<w; ++x)
+				const screen_line& srcrow = scoring_picture[y];
+
+				if (!details_mask.Empty() && cfg.details_score)
 				{
-					const distance_t base = distance_function(srcrow[x], ref);
-					*dst++ = details_mask.IsNormalized()
-						? ApplyEffectiveDetailsWeight(base, details_mask.WeightAt(x, y))
-						: ApplyLegacyDetailsWeight(base, details_mask.At(x, y),
-							cfg.details_strength);
+					for (int x=0; x<w; ++x)
+					{
+						const distance_t base = distance_function(srcrow[x], ref);
+						*dst++ = details_mask.IsNormalized()
+							? ApplyEffectiveDetailsWeight(base, details_mask.WeightAt(x, y))
+							: ApplyLegacyDetailsWeight(base, details_mask.At(x, y),
+								cfg.details_strength);
+					}
 				}
-			}
-			else
-			{
-				for (int x=0; x<w; ++x)
+				else
 				{
-					*dst++ = distance_function(srcrow[x], ref);
+					for (int x=0; x<w; ++x)
+					{
+						*dst++ = distance_function(srcrow[x], ref);
+					}
 				}
 			}
 		}
+	});
+}
+
+// Requantizes the exact planes for /errmap=compact and reports what that cost.
+void RastaConverter::BuildCompactErrorMap()
+{
+	if (!cfg.compact_error_map)
+		return;
+	m_compact_errors.Build(m_picture_all_errors_array, m_width, m_height);
+	const CompactErrorMap::Quantization& q = m_compact_errors.LastQuantization();
+	std::ostringstream text;
+	text << "Compact error map: " << m_compact_errors.Bytes() / (1024 * 1024)
+		<< " MB, shift " << q.shift << std::fixed << std::setprecision(3)
+		<< ", mean error " << q.mean_relative_error * 100.0 << "%, saturated "
+		<< q.saturated_fraction * 100.0 << "%";
+	Message(text.str());
+}
+
+void RastaConverter::ReplicateScoringTables()
+{
+	if (!m_placement.Pinned() || m_placement.Nodes().size() < 2)
+	{
+		m_node_tables.clear();
+		return;
+	}
+	if (m_node_tables.empty())
+	{
+		for (int node : m_placement.Nodes())
+		{
+			m_node_tables.push_back(std::make_unique<NodeScoringTables>());
+			m_node_tables.back()->node = node;
+		}
 	}
+	for (const std::unique_ptr<NodeScoringTables>& tables : m_node_tables)
+	{
+		// The copy runs on the node, so its pages are placed there.
+		NodeScoringTables& t = *tables;
+		RunOnNode(m_topology, t.node, [&] {
+			for (int i = 0; i < 128; ++i)
+			{
+				t.planes[i] = m_picture_all_errors[i];
+				t.rows[i] = t.planes[i].data();
+			}
+			if (cfg.compact_error_map)
+				t.compact = m_compact_errors;
+		});
+	}
+}
+
+const distance_t *const *RastaConverter::WorkerErrorPlanes(size_t worker) const
+{
+	for (const std::unique_ptr<NodeScoringTables>& tables : m_node_tables)
+		if (worker < m_placement.node.size() && tables->node == m_placement.node[worker])
+			return tables->rows;
+	return m_picture_all_errors_array;
+}
+
+const CompactErrorMap *RastaConverter::WorkerCompactErrorMap(size_t worker) const
+{
+	if (!cfg.compact_error_map)
+		return nullptr;
+	for (const std::unique_ptr<NodeScoringTables>& tables : m_node_tables)
+		if (worker < m_placement.node.size() && tables->node == m_placement.node[worker])
+			return &tables->compact;
+	return &m_compact_errors;
 }
 
 bool RastaConverter::SnapshotBeforeMaskEdit()
@@ -1014,10 +1092,14 @@ void RastaConverter::RetargetLocked(bool /*full_rebuild*/)
 			std::memory_order_acquire);
 	if (prior)
 		m_eval_gstate.m_best_pic = prior->picture;
+	BuildCompactErrorMap();
+	ReplicateScoringTables();
 	for (Evaluator& evaluator : m_evaluators)
 		evaluator.ClearAllCaches();
 	if (m_reporting_evaluator)
 		m_reporting_evaluator->ClearAllCaches();
+	m_eval_gstate.m_shared_line_cache.clear();
+	m_eval_gstate.ClearEmigrants();
 	m_eval_gstate.m_best_pic.uncache_insns();
 
 	cfg.resume_objective_changed = true;
@@ -1748,9 +1830,19 @@ bool RastaConverter::ProcessInit()
 
 	for(int i=0; i<128; ++i)
 		m_picture_all_errors_array[i] = m_picture_all_errors[i].data();
+	BuildCompactErrorMap();
+	const CompactErrorMap* compactErrors =
+		cfg.compact_error_map ? &m_compact_errors : nullptr;
+
+	m_topology = CpuTopology::Detect();
+	m_placement = PlanWorkerPlacement(m_topology, cfg.pin_policy, cfg.threads);
+	ReplicateScoringTables();
+	Message("Placement: " + DescribeWorkerPlacement(m_topology, m_placement, cfg.pin_policy)
+		+ (m_node_tables.empty() ? "" : ", scoring tables per node"));
 
 	DBG_PRINT("[RASTA] Create %d evaluator(s)", cfg.threads);
 	m_evaluators.resize(cfg.threads);
+	m_eval_gstate.ResetWorkerCounters(m_evaluators.size());
 
 	unsigned long long randseed = cfg.initial_seed;
 
@@ -1760,7 +1852,7 @@ bool RastaConverter::ProcessInit()
 		if (!randseed)
 			++randseed;
 
-		m_evaluators[i].Init(m_width, m_height, m_picture_all_errors_array,
+		m_evaluators[i].Init(m_width, m_height, WorkerErrorPlanes(i),
 			m_picture.data(), cfg.on_off_file.empty() ? NULL : &on_off,
 			&m_eval_gstate, solutions, randseed, cfg.cache_size, 0,
 			m_picture_original.data(),
@@ -1784,6 +1876,15 @@ bool RastaConverter::ProcessInit()
 	// Configure aggressive search trigger
 	m_eval_gstate.m_unstuck_after = cfg.unstuck_after;
 	m_eval_gstate.m_unstuck_drift_norm = cfg.unstuck_drift_norm;
+	m_eval_gstate.m_line_candidates = cfg.line_candidates;
+	m_eval_gstate.m_island_topology = cfg.island_topology;
+	m_eval_gstate.m_island_sources = BuildIslandSources(cfg.island_topology,
+		static_cast<int>(m_evaluators.size()), cfg.island_degree, cfg.initial_seed);
+	m_eval_gstate.m_migrate_every = cfg.migrate_every;
+	m_eval_gstate.m_migrate_rate = cfg.migrate_rate;
+	m_eval_gstate.m_migrate_elite = cfg.migrate_elite;
+	m_eval_gstate.m_shared_line_cache.configure(cfg.lean_line_cache ? 0 : m_width, m_height,
+		cfg.dual_mode ? 0 : cfg.shared_cache_size, static_cast<unsigned>(m_evaluators.size()));
 
 	// When initializing evaluators, pass thread ID:
 	for (size_t i = 0; i < m_evaluators.size(); ++i)
@@ -1792,12 +1893,15 @@ bool RastaConverter::ProcessInit()
 		if (!randseed)
 			++randseed;
 
-		m_evaluators[i].Init(m_width, m_height, m_picture_all_errors_array,
+		m_evaluators[i].Init(m_width, m_height, WorkerErrorPlanes(i),
 			m_picture.data(), cfg.on_off_file.empty() ? NULL : &on_off,
 			&m_eval_gstate, solutions, randseed, cfg.cache_size, i,
 			m_picture_original.data(),
 			cfg.details_allocate ? &details_line_priorities : nullptr,
 			cfg.details_global_period);
+		m_evaluators[i].SetCompactErrorMap(WorkerCompactErrorMap(i));
+		m_evaluators[i].SetLeanLineCache(cfg.lean_line_cache);
+		m_evaluators[i].SetPlacementCpu(m_placement.cpu[i]);
 
 		randseed += 187927 * i;
 	}
@@ -1812,6 +1916,8 @@ bool RastaConverter::ProcessInit()
 		&m_reporting_eval_gstate, 1, 1, cfg.cache_size,
 		static_cast<int>(m_evaluators.size()), m_picture_original.data(),
 		nullptr, cfg.details_global_period);
+	// Saved pictures must be rendered from the map the search scored against.
+	m_reporting_evaluator->SetCompactErrorMap(compactErrors);
 
 	if (cfg.continue_processing && m_needs_history_reconfigure && !cfg.dual_mode) {
 		reconfigureAcceptanceHistory();
@@ -1989,43 +2095,6 @@ MixingPlan RastaConverter::DeviseBestMixingPlan(rgb color)
 	return result;
 }
 
-void RastaConverter::ParallelFor(int from, int to, void *(*start_routine)(void*))
-{
-	void *status;
-	vector<std::thread> threads;
-	vector<parallel_for_arg_t> threads_arg;
-	/* Initialize and set thread detached attribute */
-
-	threads.reserve(cfg.threads);
-	threads_arg.resize(cfg.threads);
-
-	int step=abs(to-from)/cfg.threads;
-	for (int t=0;t<cfg.threads;++t)
-	{
-		threads_arg[t].this_ptr=this;
-		threads_arg[t].from=from;
-		if (t==cfg.threads-1) // last one
-			threads_arg[t].to=to;
-		else
-			threads_arg[t].to=from+step;
-		threads.emplace_back( std::bind( start_routine, ( void* )&threads_arg[t] ) );
-		from+=step;
-	}
-	for (int t=0;t<cfg.threads;++t)
-	{
-		threads[t].join();
-	}
-	return;
-}
-
-// This is still quite ugly, KnollDitheringParallel should be passed in *arg so this helper could be generic
-void *RastaConverter::KnollDitheringParallelHelper(void *arg)
-{
-	parallel_for_arg_t *param=(parallel_for_arg_t *)arg;
-	((RastaConverter *)param->this_ptr)->KnollDitheringParallel(param->from,param->to);
-	return NULL;
-}
-
 void RastaConverter::KnollDitheringParallel(int from, int to)
 {
 	std::vector<unsigned char> local_line;
@@ -2073,25 +2142,12 @@ bool RastaConverter::KnollDithering()
 	// Show initial empty destination area so window isn't blank
 	ShowDestinationBitmap();
 	gui.Present();
-	// Launch workers (non-blocking) with robust partitioning
-	std::vector<std::thread> threads;
-	std::vector<parallel_for_arg_t> threads_arg;
-	int total_threads = std::max(1, cfg.threads);
-	threads.reserve(total_threads);
-	threads_arg.resize(total_threads);
-	int from=0;
-	int to=m_height;
-	int step = (to - from + total_threads - 1) / total_threads; // ceil division
-	for (int t=0;t<total_threads;++t)
-	{
-		threads_arg[t].this_ptr=this;
-		threads_arg[t].from=from;
-		int tto = from + step;
-		if (t==total_threads-1 || tto>to) tto = to;
-		threads_arg[t].to=tto;
-		threads.emplace_back( std::bind( KnollDitheringParallelHelper, ( void* )&threads_arg[t] ) );
-		from = tto;
-	}
+	// Rows are handed out one at a time, top to bottom, which is also the draw
+	// order: rows near colour edges need far more mixing plans than flat ones,
+	// so fixed ranges would leave one thread finishing alone.
+	TaskGroup workers;
+	workers.RunChunked(0, m_height, 1, std::max(1, cfg.threads),
+		[this](int from, int to) { KnollDitheringParallel(from, to); });
 	// Progressive commit loop: draw lines as they become ready
 	int next_to_draw = 0;
 	int presented_until = -1;
@@ -2147,7 +2203,8 @@ bool RastaConverter::KnollDithering()
 			break;
 		case GUI_command::STOP:
 			should_stop = true; // Exit dithering when user requests to quit
-			m_knoll_should_stop.store(true, std::memory_order_release); // Signal worker threads to stop
+			m_knoll_should_stop.store(true, std::memory_order_release); // Stop rows in progress
+			workers.Cancel(); // and hand out no more
 			break;
 		}
 		if (presented_until != next_to_draw)
@@ -2157,11 +2214,7 @@ bool RastaConverter::KnollDithering()
 		}
 		std::this_thread::sleep_for(std::chrono::milliseconds(1));
 	}
-	// Join workers before leaving
-	for (int t=0;t<total_threads;++t)
-	{
-		threads[t].join();
-	}
+	workers.Wait();
 	return should_stop; // Return true if cancelled, false if completed
 }
 
@@ -2712,6 +2765,9 @@ void RastaConverter::Init()
 		else // LESS or SMART
 			CreateSmartRasterPicture(&m);
 
+		// Mutation updates line hashes incrementally from here on.
+		for (raster_line& line : m.raster_lines)
+			line.rehash();
 		m_eval_gstate.m_best_pic = m;
 	}
 
@@ -2787,7 +2843,7 @@ void RastaConverter::ApplyInternalStructuredPass(
 	if (publishResult)
 	{
 		std::vector<const line_cache_result*> results(m_height, nullptr);
-		const distance_accum_t finalScore = evaluator.EvaluateSingle(
+		const distance_accum_t finalScore = evaluator.EvaluateWithRows(
 			&m_eval_gstate.m_best_pic, results.data());
 		m_eval_gstate.m_best_result.store(finalScore, std::memory_order_relaxed);
 		m_eval_gstate.m_created_picture.resize(m_height);
@@ -2886,13 +2942,24 @@ std::string RastaConverter::BuildConfigRecap() const
 	return out.str();
 }
 
+void RastaConverter::RefreshEvaluationCounters()
+{
+	m_completed_evaluations = std::max(m_completed_evaluations,
+		m_eval_gstate.CompletedEvaluations());
+	// Legacy acceptance still publishes its own drift under the state lock.
+	if (m_eval_gstate.m_optimizer != EvalGlobalState::OPT_LEGACY)
+		m_eval_gstate.m_current_norm_drift =
+			m_eval_gstate.NormalizedDrift(m_completed_evaluations);
+}
+
 void RastaConverter::PublishLiveStats(bool preprocessing, bool finished)
 {
 	if (!gui.LiveUiActive())
 		return;
+	RefreshEvaluationCounters();
 
 	LiveStats stats;
-	stats.evaluations = m_eval_gstate.m_evaluations.load(std::memory_order_relaxed);
+	stats.evaluations = m_completed_evaluations;
 	stats.last_best_evaluation =
 		m_eval_gstate.m_last_best_evaluation.load(std::memory_order_relaxed);
 	// The parser's "no limit" default is a huge sentinel; report it as no limit
@@ -2903,7 +2970,7 @@ void RastaConverter::PublishLiveStats(bool preprocessing, bool finished)
 	// produces a meaningless number, so leave it at zero and let the dashboard
 	// say it has nothing yet.
 	stats.normalized_distance =
-		m_eval_gstate.m_evaluations.load(std::memory_order_relaxed) > 0
+		m_completed_evaluations > 0
 			? NormalizeScore(m_eval_gstate.m_best_result) : 0.0;
 	stats.normalized_drift = m_eval_gstate.m_current_norm_drift;
 	stats.unstuck_after = cfg.unstuck_after;
@@ -2928,6 +2995,23 @@ void RastaConverter::PublishLiveStats(bool preprocessing, bool finished)
 	stats.migrations = m_eval_gstate.m_single_migrations.load(std::memory_order_relaxed);
 	stats.cache_hits = m_eval_gstate.m_cache_hits.load(std::memory_order_relaxed);
 	stats.cache_lookups = m_eval_gstate.m_cache_lookups.load(std::memory_order_relaxed);
+	if (!cfg.dual_mode && cfg.optimizer != Configuration::E_OPT_LEGACY)
+	{
+		for (size_t i = 0; i < m_eval_gstate.m_island_count; ++i)
+		{
+			const EvalGlobalState::IslandSlot& slot = m_eval_gstate.m_islands[i];
+			LiveStats::IslandStat island;
+			island.evaluations = slot.evaluations.load(std::memory_order_relaxed);
+			island.accepted = slot.accepted.load(std::memory_order_relaxed);
+			island.immigrants = slot.immigrants.load(std::memory_order_relaxed);
+			const double current = slot.current_cost.load(std::memory_order_relaxed);
+			const double best = slot.best_cost.load(std::memory_order_relaxed);
+			island.normalized_distance = current != DBL_MAX ? NormalizeScore(current) : 0.0;
+			island.normalized_best = best != DBL_MAX ? NormalizeScore(best) : 0.0;
+			stats.islands.push_back(island);
+		}
+		stats.island_topology = IslandTopologyName(cfg.island_topology);
+	}
 
 	stats.dual_mode = cfg.dual_mode;
 	if (cfg.dual_mode) {
@@ -2997,6 +3081,7 @@ void RastaConverter::PublishLiveStats(bool preprocessing, bool finished)
 
 void RastaConverter::ShowMutationStats()
 {
+	RefreshEvaluationCounters();
 	// Image captions may be as low as y=250 for a 240-line source. Keep the
 	// status block below that caption row while leaving the final mutation line
 	// clear of the persistent message row at y=450.
@@ -3012,13 +3097,12 @@ void RastaConverter::ShowMutationStats()
 			&& i == E_MUTATION_TOGGLE_ANTIC4_ATTRIBUTE) continue;
 		gui.DisplayText(0, status_top + mutation_line_height * row,
 			string(mutation_names[i]) + string("  ")
-			+ format_with_commas(m_eval_gstate.m_mutation_stats[i]));
+			+ format_with_commas(m_eval_gstate.m_mutation_stats[i].load(std::memory_order_relaxed)));
 		++row;
 	}
 
 	gui.DisplayText(320, status_top + status_line_height,
-		string("Evaluations: ") + format_with_commas(
-			m_eval_gstate.m_evaluations.load(std::memory_order_relaxed)));
+		string("Evaluations: ") + format_with_commas(m_completed_evaluations));
 	gui.DisplayText(320, status_top + 2 * status_line_height,
 		string("LastBest: ") + format_with_commas(
 			m_eval_gstate.m_last_best_evaluation.load(std::memory_order_relaxed))
@@ -3030,8 +3114,8 @@ void RastaConverter::ShowMutationStats()
 		double norm = NormalizeScore(m_eval_gstate.m_best_result);
 		std::string line = std::string("Norm. Dist: ") + format_with_commas(norm);
 		// Show current normalized drift if active
-		if (m_eval_gstate.m_current_norm_drift > 0.0 && m_eval_gstate.m_unstuck_after > 0 && m_eval_gstate.m_evaluations > m_eval_gstate.m_last_best_evaluation) {
-			unsigned long long plateau = m_eval_gstate.m_evaluations - m_eval_gstate.m_last_best_evaluation;
+		if (m_eval_gstate.m_current_norm_drift > 0.0 && m_eval_gstate.m_unstuck_after > 0 && m_completed_evaluations > m_eval_gstate.m_last_best_evaluation) {
+			unsigned long long plateau = m_completed_evaluations - m_eval_gstate.m_last_best_evaluation;
 			if (plateau >= m_eval_gstate.m_unstuck_after) {
 				line += std::string(" (+") + format_with_commas(m_eval_gstate.m_current_norm_drift) + std::string(")");
 			}
@@ -3092,7 +3176,8 @@ void RastaConverter::SaveBestSolution()
 			SaveScreenData(string(cfg.output_file+".mic").c_str());
 		SavePicture     (cfg.output_file,output_bitmap);
 		SaveStatistics((cfg.output_file+".csv").c_str());
-		SaveOptimizerState((cfg.output_file+".optstate").c_str(), &pic);
+		SaveOptimizerState((cfg.output_file+".optstate").c_str(), &pic,
+			snapshot && snapshot->optimizer.initialized ? &snapshot->optimizer : nullptr);
 		m_mask_edited_since_save = false;
 		m_ever_saved = true;
 		m_last_save_time = std::chrono::steady_clock::now();
@@ -3170,7 +3255,8 @@ RastaConverter::RastaConverter()
 
 void RastaConverter::MainLoop()
 {
-	Message("Optimization started.");
+	Message(std::string("Optimization started (") + SimdLevelName(ActiveSimdLevel())
+		+ " evaluator kernels).");
 
 	output_bitmap = FreeImage_Allocate(cfg.width, cfg.height, 24);
 	if (cfg.dual_mode) {
@@ -3202,6 +3288,9 @@ void RastaConverter::MainLoop()
 	auto last_ui_frame_tp = last_rate_check_tp;
 
 	bool pending_update = false;
+	// Island workers publish by swapping m_best_snapshot without waking this
+	// loop; a new version is noticed on the next tick and rendered here.
+	unsigned long long shown_version = 0;
 
 	// spin up only one evaluator -- we need its result before the rest can go, unless in dual mode
 	// Do not hold the lock across UI work; acquire on demand
@@ -3315,14 +3404,26 @@ void RastaConverter::MainLoop()
 			const bool statsDue = secs > 0.25;
 			if (statsDue)
 			{
-				m_rate = (double)(m_eval_gstate.m_evaluations - last_eval) / secs;
+				RefreshEvaluationCounters();
+				m_rate = (double)(m_completed_evaluations - last_eval) / secs;
 
 				last_rate_check_tp = next_rate_check_tp;
-				last_eval = m_eval_gstate.m_evaluations;
+				last_eval = m_completed_evaluations;
 
+				const unsigned long long published_version =
+					m_eval_gstate.m_best_state_version.load(std::memory_order_acquire);
+				if (published_version != shown_version)
+				{
+					shown_version = published_version;
+					pending_update = true;
+				}
 				if (pending_update)
 				{
 					pending_update = false;
+					// Legacy workers publish rows but no snapshot, and config
+					// turns /lean_cache off for them.
+					if (cfg.optimizer != Configuration::E_OPT_LEGACY)
+						RenderPublishedPicture();
 					ShowLastCreatedPicture();
 				}
 
@@ -3416,6 +3517,14 @@ void RastaConverter::RenderCreatedPicture(raster_picture& picture)
 		m_eval_gstate.m_created_picture_targets, m_eval_gstate.m_sprites_memory);
 }
 
+void RastaConverter::RenderPublishedPicture()
+{
+	const std::shared_ptr<const EvalGlobalState::PublishedBestSnapshot> snapshot =
+		std::atomic_load_explicit(&m_eval_gstate.m_best_snapshot, std::memory_order_acquire);
+	raster_picture pic = snapshot ? snapshot->picture : m_eval_gstate.m_best_pic;
+	RenderCreatedPicture(pic);
+}
+
 void RastaConverter::RenderCreatedPictureInto(raster_picture& picture,
 	std::vector<color_index_line>& created,
 	std::vector<line_target>& targets, sprites_memory_t& sprites)
@@ -3447,6 +3556,9 @@ void RastaConverter::RenderCreatedPictureInto(raster_picture& picture,
 void RastaConverter::ShowLastCreatedPicture()
 {
 	int x,y;
+	// Nothing rendered yet.
+	if (m_eval_gstate.m_created_picture.size() != static_cast<size_t>(m_height))
+		return;
 	// Draw new picture on the screen
 	for (y=0;y<m_height;++y)
 	{
@@ -4334,8 +4446,18 @@ void RastaConverter::SaveRasterProgram(string name, raster_picture *pic)
 		<< (m_destination_edited ? "yes" : "no") << '\n';
 	asmOut << "; Target Hash: " << m_target_hash << '\n';
 	asmOut << "; Snapshots: " << m_snapshot_count << '\n';
-    asmOut << "; Evaluations: " << static_cast<unsigned long long>(m_eval_gstate.m_evaluations) << '\n';
+    asmOut << "; Evaluations: " << m_eval_gstate.CompletedEvaluations() << '\n';
     asmOut << "; Score: " << NormalizeScore(m_eval_gstate.m_best_result) << '\n';
+	asmOut << "; Placement: " << DescribeWorkerPlacement(m_topology, m_placement, cfg.pin_policy) << '\n';
+	if (cfg.compact_error_map && !m_compact_errors.Empty())
+	{
+		// Scores above are in quantized units; this is what that costs.
+		const CompactErrorMap::Quantization& q = m_compact_errors.LastQuantization();
+		asmOut << "; Error Map: compact" << '\n';
+		asmOut << "; Error Map Shift: " << q.shift << '\n';
+		asmOut << "; Error Map Mean Relative Error: " << q.mean_relative_error << '\n';
+		asmOut << "; Error Map Saturated Fraction: " << q.saturated_fraction << '\n';
+	}
 	if (!cfg.dual_mode && !m_evaluators.empty())
 	{
 		const std::streamsize scorePrecision = asmOut.precision();
@@ -4349,6 +4471,11 @@ void RastaConverter::SaveRasterProgram(string name, raster_picture *pic)
 	asmOut << "; Optimizer Accepted: " << m_eval_gstate.m_single_accepted.load(std::memory_order_relaxed) << '\n';
 	asmOut << "; Optimizer Global Improvements: " << m_eval_gstate.m_single_global_improvements.load(std::memory_order_relaxed) << '\n';
 	asmOut << "; Optimizer Migrations: " << m_eval_gstate.m_single_migrations.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Islands: " << IslandTopologyName(cfg.island_topology);
+	if (cfg.island_topology != IslandTopology::Global)
+		asmOut << ", every " << cfg.migrate_every << ", rate " << cfg.migrate_rate
+			<< ", " << (cfg.migrate_elite ? "elite" : "best");
+	asmOut << '\n';
     asmOut << "; State Lock Samples: " << lockSamples << '\n';
     asmOut << "; State Lock Mean Wait Ns: " << (lockSamples ? m_eval_gstate.m_single_state_lock_wait_ns.load(std::memory_order_relaxed) / lockSamples : 0ULL) << '\n';
     asmOut << "; State Lock Mean Hold Ns: " << (lockSamples ? m_eval_gstate.m_single_state_lock_hold_ns.load(std::memory_order_relaxed) / lockSamples : 0ULL) << '\n';
@@ -4376,8 +4503,6 @@ void RastaConverter::SaveRasterProgram(string name, raster_picture *pic)
 		improvementTotal / static_cast<double>(improvementEvents) : 0.0) << '\n';
 	asmOut << "; Improvement Max: " << m_eval_gstate.m_improvement_max.load(std::memory_order_relaxed) << '\n';
 	asmOut << std::setprecision(metadataPrecision);
-    asmOut << "; Cache Partial Clears: " << m_eval_gstate.m_single_cache_partial_clears.load(std::memory_order_relaxed) << '\n';
-    asmOut << "; Cache Full Clears: " << m_eval_gstate.m_single_cache_full_clears.load(std::memory_order_relaxed) << '\n';
 	asmOut << "; Candidate Full Copies: " << m_eval_gstate.m_single_candidate_full_copies.load(std::memory_order_relaxed) << '\n';
 	asmOut << "; Undo Candidates: " << m_eval_gstate.m_single_undo_candidates.load(std::memory_order_relaxed) << '\n';
 	asmOut << "; Undo Line Snapshots: " << m_eval_gstate.m_single_undo_line_snapshots.load(std::memory_order_relaxed) << '\n';
@@ -4392,12 +4517,31 @@ void RastaConverter::SaveRasterProgram(string name, raster_picture *pic)
 	asmOut << "; Cache Mean Lookup Probes: " << (cacheLookups ?
 		static_cast<double>(m_eval_gstate.m_cache_lookup_probes.load(std::memory_order_relaxed)) / cacheLookups : 0.0) << '\n';
 	asmOut << "; Cache Max Lookup Probes: " << m_eval_gstate.m_cache_max_lookup_probes.load(std::memory_order_relaxed) << '\n';
-	asmOut << "; Cache Inserts: " << m_eval_gstate.m_cache_inserts.load(std::memory_order_relaxed) << '\n';
-	asmOut << "; Cache Hash Blocks: " << m_eval_gstate.m_cache_hash_blocks.load(std::memory_order_relaxed) << '\n';
+	const unsigned long long cacheInserts = m_eval_gstate.m_cache_inserts.load(std::memory_order_relaxed);
+	const unsigned long long cacheEvictions = m_eval_gstate.m_cache_evictions.load(std::memory_order_relaxed);
+	asmOut << "; Cache Inserts: " << cacheInserts << '\n';
+	asmOut << "; Cache Evictions: " << cacheEvictions << '\n';
+	asmOut << "; Cache Eviction Rate: " << (cacheInserts ?
+		static_cast<double>(cacheEvictions) / cacheInserts : 0.0) << '\n';
+	asmOut << "; Cache Eviction Skips: " << m_eval_gstate.m_cache_eviction_skips.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Cache Slot Overflows: " << m_eval_gstate.m_cache_slot_overflows.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Cache Trace Clears: " << m_eval_gstate.m_cache_trace_clears.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Cache Budget Resets: " << m_eval_gstate.m_cache_budget_resets.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Shared Cache Lookups: " << m_eval_gstate.m_shared_cache_lookups.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Shared Cache Hits: " << m_eval_gstate.m_shared_cache_hits.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Shared Cache Publishes: " << m_eval_gstate.m_shared_cache_publishes.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Shared Cache Rejected Publishes: " << m_eval_gstate.m_shared_cache_rejected_publishes.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Cache Table Growths: " << m_eval_gstate.m_cache_table_growths.load(std::memory_order_relaxed) << '\n';
 	asmOut << "; Cache Entry Bytes: " << m_eval_gstate.m_cache_entry_bytes.load(std::memory_order_relaxed) << '\n';
-	asmOut << "; Cache Hash Block Bytes: " << m_eval_gstate.m_cache_hash_block_bytes.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Cache Table Bytes: " << m_eval_gstate.m_cache_table_bytes.load(std::memory_order_relaxed) << '\n';
 	asmOut << "; Cache Color Row Bytes: " << m_eval_gstate.m_cache_color_row_bytes.load(std::memory_order_relaxed) << '\n';
 	asmOut << "; Cache Target Row Bytes: " << m_eval_gstate.m_cache_target_row_bytes.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Cache Retained Chunk Bytes: " << m_eval_gstate.m_cache_retained_bytes.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Cache Huge Page Bytes: " << m_eval_gstate.m_cache_huge_page_bytes.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Cache Chunk Allocations: " << m_eval_gstate.m_cache_chunk_allocations.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Cache Chunk Reuses: " << m_eval_gstate.m_cache_chunk_reuses.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Worker Minor Page Faults: " << m_eval_gstate.m_minor_page_faults.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Worker Major Page Faults: " << m_eval_gstate.m_major_page_faults.load(std::memory_order_relaxed) << '\n';
 	asmOut << "; Insn Cache Hash Block Bytes: " << m_eval_gstate.m_insn_cache_hash_block_bytes.load(std::memory_order_relaxed) << '\n';
 	asmOut << "; Insn Cache Data Bytes: " << m_eval_gstate.m_insn_cache_data_bytes.load(std::memory_order_relaxed) << '\n';
 	asmOut << "; Cache Evaluations: " << cacheEvaluations << '\n';
@@ -4420,6 +4564,12 @@ void RastaConverter::SaveRasterProgram(string name, raster_picture *pic)
 			<< (attributeEvaluations
 				? static_cast<double>(attributeLines) / attributeEvaluations
 				: 0.0) << '\n';
+		asmOut << "; ANTIC4 Trace Replays: "
+			<< m_eval_gstate.m_cache_trace_hits.load(std::memory_order_relaxed) << '\n';
+		asmOut << "; ANTIC4 Trace Inserts: "
+			<< m_eval_gstate.m_cache_trace_inserts.load(std::memory_order_relaxed) << '\n';
+		asmOut << "; ANTIC4 Trace Bytes: "
+			<< m_eval_gstate.m_cache_trace_bytes.load(std::memory_order_relaxed) << '\n';
 	}
 	asmOut << "; Cache Max Recomputed Lines: " << m_eval_gstate.m_cache_max_recomputed_lines.load(std::memory_order_relaxed) << '\n';
 	asmOut << "; Cache Propagation Span: " << m_eval_gstate.m_cache_propagation_span.load(std::memory_order_relaxed) << '\n';
@@ -4427,6 +4577,15 @@ void RastaConverter::SaveRasterProgram(string name, raster_picture *pic)
 		static_cast<double>(m_eval_gstate.m_cache_propagation_span.load(std::memory_order_relaxed)) / cacheEvaluations : 0.0) << '\n';
 	asmOut << "; Cache Max Propagation Span: " << m_eval_gstate.m_cache_max_propagation_span.load(std::memory_order_relaxed) << '\n';
 	asmOut << "; Cache PMG Restarts: " << m_eval_gstate.m_cache_pmg_restarts.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Cache Player-Free Lines: " << m_eval_gstate.m_cache_player_free_lines.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Cache Dirty-Range Evaluations: " << m_eval_gstate.m_cache_dirty_range_evaluations.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Cache Reused Prefix Lines: " << m_eval_gstate.m_cache_prefix_lines.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Cache Spliced Suffix Lines: " << m_eval_gstate.m_cache_spliced_lines.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Cache Bound Rejections: " << m_eval_gstate.m_cache_bound_rejections.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Cache Bound Skipped Lines: " << m_eval_gstate.m_cache_bound_skipped_lines.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Cache Bound Retries: " << m_eval_gstate.m_cache_bound_retries.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Line Candidates Evaluated: " << m_eval_gstate.m_line_candidate_evaluations.load(std::memory_order_relaxed) << '\n';
+	asmOut << "; Line Candidates Preferred Over First: " << m_eval_gstate.m_line_candidate_switches.load(std::memory_order_relaxed) << '\n';
 	asmOut << "; LRU Updates: " << lruUpdates << '\n';
 	asmOut << "; LRU Search Steps: " << m_eval_gstate.m_lru_search_steps.load(std::memory_order_relaxed) << '\n';
 	asmOut << "; LRU Mean Search Steps: " << (lruUpdates ?
@@ -85,8 +85,25 @@ private:
 	vector < screen_line > m_picture_original; // original input before palette quantization
 	vector<distance_t> m_picture_all_errors[128]; 
 	const distance_t *m_picture_all_errors_array[128];
+	// /errmap=compact copy of the planes above, rebuilt whenever they change.
+	CompactErrorMap m_compact_errors;
+	// /pin: where the workers run, and per-node copies of the scoring tables
+	// above when the workers span more than one node. Empty otherwise, and
+	// every worker reads the tables above.
+	CpuTopology m_topology;
+	WorkerPlacement m_placement;
+	struct NodeScoringTables
+	{
+		int node = 0;
+		vector<distance_t> planes[128];
+		const distance_t *rows[128];
+		CompactErrorMap compact;
+	};
+	vector<std::unique_ptr<NodeScoringTables>> m_node_tables;
 	int m_width = 0, m_height = 0; // picture size
 	double m_rate = 0;
+	// Completed evaluations as of the last coordinator tick; never decreases.
+	unsigned long long m_completed_evaluations = 0;
 	// Wall-clock start of the search, for the dashboard's elapsed readout.
 	std::chrono::steady_clock::time_point m_run_started = std::chrono::steady_clock::now();
 	std::chrono::steady_clock::time_point m_last_save_time{};
@@ -135,6 +152,12 @@ private:
 	// private functions
 	void InitLocalStructure();
 	void GeneratePictureErrorMap();
+	void BuildCompactErrorMap();
+	// Copies the error planes and compact map onto each node in m_node_tables.
+	// Workers must be stopped; storage is reused, so their pointers stay valid.
+	void ReplicateScoringTables();
+	const distance_t *const *WorkerErrorPlanes(size_t worker) const;
+	const CompactErrorMap *WorkerCompactErrorMap(size_t worker) const;
 	// One editor session: BeginEditorSession stops the workers at a safe point,
 	// ApplyEditorSession commits pixels and parameters together and restarts
 	// them, DiscardEditorSession just restarts them.
@@ -151,6 +174,9 @@ private:
 	void BranchCurrentRun();
 	void SaveEditedTargetArtifact();
 	void RenderCreatedPicture(raster_picture& picture);
+	// Workers with /lean_cache publish programs without rendered rows; this
+	// renders the published best into the display and export buffers.
+	void RenderPublishedPicture();
 	void RenderCreatedPictureInto(raster_picture& picture,
 		std::vector<color_index_line>& created,
 		std::vector<line_target>& targets, sprites_memory_t& sprites);
@@ -184,6 +210,9 @@ private:
 	void TestRasterProgram(raster_picture *pic);
 
 	void ShowMutationStats();
+	// Sums the workers' evaluation counter slots and refreshes the drift
+	// shown for island optimizers. Called on the coordinator tick.
+	void RefreshEvaluationCounters();
 	// Fills the live dashboard's snapshot from the current run state and hands
 	// it to the frontend. Everything it reads already exists; nothing is added
 	// to the hot path.
@@ -198,7 +227,8 @@ private:
 		const std::string& fontFilename, const raster_picture& picture);
 	bool SavePicture(const std::string& filename, FIBITMAP* to_save);
 	void SaveStatistics(const char *filename);
-	void SaveOptimizerState(const char *filename, const raster_picture* picture = nullptr);
+	void SaveOptimizerState(const char *filename, const raster_picture* picture = nullptr,
+		const OptimizerState* published = nullptr);
 
 	void LoadRegInits(string name);
 	void LoadRasterProgram(string name);
@@ -210,14 +240,7 @@ private:
 	double NormalizeScore(double raw_score);
 	double UnweightedSourceOklabMean(raster_picture* pic);
 
-	struct parallel_for_arg_t {
-		int from;
-		int to;
-		void *this_ptr;
-	};
 	void KnollDitheringParallel(int from, int to);
-	static void *KnollDitheringParallelHelper(void *arg);
-	void ParallelFor(int from, int to, void *(*start_routine)(void*));
 	bool GetInstructionFromString(const string& line, SRasterInstruction& instr);
 
     // (removed) legacy dual acceptance helper – logic centralized in Evaluator::ApplyAcceptanceCore
@@ -34,6 +34,17 @@ struct LiveStats {
 	unsigned long long migrations = 0;
 	unsigned long long cache_hits = 0;
 	unsigned long long cache_lookups = 0;
+	// One per single-frame worker, refreshed every few thousand of its
+	// evaluations; empty in dual and legacy runs.
+	struct IslandStat {
+		unsigned long long evaluations = 0;
+		unsigned long long accepted = 0;
+		unsigned long long immigrants = 0;
+		double normalized_distance = 0.0;  // its current solution
+		double normalized_best = 0.0;
+	};
+	std::vector<IslandStat> islands;
+	std::string island_topology;
 
 	// --- dual frame (design §9.5) ---
 	bool dual_mode = false;
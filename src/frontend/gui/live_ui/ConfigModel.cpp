@@ -341,6 +341,58 @@ std::vector<OptionDesc> BuildTable()
 		Category::Algorithm, Tier::Live, false,
 		[](const Configuration& c) { return !NearlyEqual(c.unstuck_drift_norm, Defaults().unstuck_drift_norm); },
 		[](const Configuration& c) { return Num(c.unstuck_drift_norm); });
+	add("line_candidates", "line_candidates", "Line candidates",
+		"Alternatives tried for each mutated line. Each is scored over the "
+		"lines it touches and only the best goes on to a full evaluation.",
+		Category::Algorithm, Tier::Restart, false,
+		[](const Configuration& c) { return c.line_candidates != Defaults().line_candidates; },
+		[](const Configuration& c) { return Num(c.line_candidates); },
+		[](const Configuration& c) { return !c.dual_mode && c.optimizer != Configuration::E_OPT_LEGACY; },
+		"Needs the LAHC or DLAS single-frame search.");
+	add("islands", "islands", "Island topology",
+		"Which workers each worker takes migrant solutions from. Global "
+		"follows the best so far; the others keep islands apart for longer.",
+		Category::Algorithm, Tier::Restart, false,
+		[](const Configuration& c) { return c.island_topology != Defaults().island_topology; },
+		[](const Configuration& c) { return std::string(IslandTopologyName(c.island_topology)); },
+		[](const Configuration& c) { return !c.dual_mode && c.optimizer != Configuration::E_OPT_LEGACY; },
+		"Needs the LAHC or DLAS single-frame search.");
+	add("island_degree", "island_degree", "Island degree",
+		"Sources per island with the random topology.",
+		Category::Algorithm, Tier::Restart, false,
+		[](const Configuration& c) { return c.island_degree != Defaults().island_degree; },
+		[](const Configuration& c) { return Num(c.island_degree); },
+		[](const Configuration& c) { return c.island_topology == IslandTopology::Random; },
+		"Used by /islands=random only.");
+	add("migrate_every", "migrate_every", "Migration interval",
+		"Evaluations of one island between migrations.",
+		Category::Algorithm, Tier::Restart, false,
+		[](const Configuration& c) { return c.migrate_every != Defaults().migrate_every; },
+		[](const Configuration& c) { return Num(c.migrate_every); },
+		[](const Configuration& c) { return c.island_topology != IslandTopology::Global; },
+		"Global islands take the best as soon as it is published.");
+	add("migrate_rate", "migrate_rate", "Migration rate",
+		"Chance that an island takes a neighbour's solution at an interval.",
+		Category::Algorithm, Tier::Restart, false,
+		[](const Configuration& c) { return !NearlyEqual(c.migrate_rate, Defaults().migrate_rate); },
+		[](const Configuration& c) { return Num(c.migrate_rate); },
+		[](const Configuration& c) { return c.island_topology != IslandTopology::Global; },
+		"Global islands take the best as soon as it is published.");
+	add("migrate", "migrate", "Migrants",
+		"What an island offers: its best solution or a random one of its elite.",
+		Category::Algorithm, Tier::Restart, false,
+		[](const Configuration& c) { return c.migrate_elite != Defaults().migrate_elite; },
+		[](const Configuration& c) { return std::string(c.migrate_elite ? "elite" : "best"); },
+		[](const Configuration& c) { return c.island_topology != IslandTopology::Global; },
+		"Global islands take the best as soon as it is published.");
+	add("errmap", "errmap", "Compact error map",
+		"Scores from 16-bit per-line error tiles: half the memory traffic per "
+		"evaluation for a small, reported quantization of the score.",
+		Category::Algorithm, Tier::Restart, false,
+		[](const Configuration& c) { return c.compact_error_map != Defaults().compact_error_map; },
+		[](const Configuration& c) { return std::string(c.compact_error_map ? "compact" : "exact"); },
+		[](const Configuration& c) { return !c.dual_mode; },
+		"Dual mode scores blended pairs, not the error map.");
 	add("seed", "seed", "RNG seed",
 		"Fixed seed makes a run reproducible; otherwise it is taken from the "
 		"clock.",
@@ -442,12 +494,38 @@ std::vector<OptionDesc> BuildTable()
 		Category::RunOutput, Tier::Restart, false,
 		[](const Configuration& c) { return c.threads != Defaults().threads; },
 		[](const Configuration& c) { return Num(c.threads); });
+	add("pin", "pin", "Pin threads",
+		"Keeps each worker on one CPU: a physical core each, or both SMT "
+		"siblings of a core first. Multi-socket hosts also get a copy of the "
+		"error table per node.",
+		Category::RunOutput, Tier::Restart, false,
+		[](const Configuration& c) { return c.pin_policy != Defaults().pin_policy; },
+		[](const Configuration& c) {
+			return std::string(c.pin_policy == PinPolicy::Cores ? "cores"
+				: c.pin_policy == PinPolicy::Smt ? "smt" : "none");
+		});
 	add("cache", "cache", "Line cache",
 		"Rendered-line cache per thread, in MB. More cache means fewer "
 		"re-simulations.",
 		Category::RunOutput, Tier::Restart, false,
 		[](const Configuration& c) { return c.cache_size != Defaults().cache_size; },
 		[](const Configuration& c) { return Num(c.cache_size / (1024 * 1024)); });
+	add("shared_cache", "shared_cache", "Shared line cache",
+		"Rendered lines shared by all threads, in MB. A thread that misses its "
+		"own cache reuses a line another thread already rendered. 0 is off.",
+		Category::RunOutput, Tier::Restart, false,
+		[](const Configuration& c) { return c.shared_cache_size != Defaults().shared_cache_size; },
+		[](const Configuration& c) { return Num(c.shared_cache_size / (1024 * 1024)); },
+		[](const Configuration& c) { return !c.dual_mode; },
+		"Dual mode renders each frame against the other.");
+	add("lean_cache", "lean_cache", "Lean line cache",
+		"Caches each line's score without its pixels, so the same cache holds "
+		"several times more lines. The best picture is re-rendered for display.",
+		Category::RunOutput, Tier::Restart, true,
+		[](const Configuration& c) { return c.lean_line_cache != Defaults().lean_line_cache; },
+		[](const Configuration&) { return std::string(); },
+		[](const Configuration& c) { return !c.dual_mode && c.optimizer != Configuration::E_OPT_LEGACY; },
+		"Dual mode and the legacy optimizer show the best picture from cached rows.");
 	add("max_evals", "max_evals", "Evaluation limit",
 		"Stops the run after this many candidate evaluations. Unlimited means "
 		"it runs until you stop it.",
@@ -574,6 +652,7 @@ Configuration DefaultConfiguration()
 	c.optimizer = Configuration::E_OPT_LAHC;
 	c.unstuck_after = 0ULL;
 	c.unstuck_drift_norm = 0.0;
+	c.line_candidates = 1;
 	return c;
 }
 
@@ -579,6 +579,42 @@ void Dashboard::DrawDiagnosticsPanel()
 				/ static_cast<double>(stats_.cache_lookups));
 		StatLine("Line cache hit rate", ratio, theme::kText);
 	}
+	if (stats_.islands.size() < 2)
+		return;
+
+	// One row per island: with separate islands the spread of their
+	// distances shows whether they still search different areas.
+	StatLine("Islands", stats_.island_topology, theme::kText);
+	const ImGuiTableFlags flags = ImGuiTableFlags_SizingStretchProp
+		| ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY;
+	const float rows = static_cast<float>(std::min<size_t>(stats_.islands.size(), 8) + 1);
+	if (!ImGui::BeginTable("islands", 5, flags,
+			ImVec2(0.0f, rows * ImGui::GetTextLineHeightWithSpacing())))
+		return;
+	ImGui::TableSetupScrollFreeze(0, 1);
+	ImGui::TableSetupColumn("#");
+	ImGui::TableSetupColumn("Current");
+	ImGui::TableSetupColumn("Best");
+	ImGui::TableSetupColumn("Accepted");
+	ImGui::TableSetupColumn("Migrants");
+	ImGui::TableHeadersRow();
+	for (size_t i = 0; i < stats_.islands.size(); ++i) {
+		const LiveStats::IslandStat& island = stats_.islands[i];
+		ImGui::TableNextRow();
+		ImGui::TableSetColumnIndex(0);
+		ImGui::Text("%d", static_cast<int>(i));
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("%s evaluations", WithCommas(island.evaluations).c_str());
+		ImGui::TableSetColumnIndex(1);
+		ImGui::Text("%.6f", island.normalized_distance);
+		ImGui::TableSetColumnIndex(2);
+		ImGui::Text("%.6f", island.normalized_best);
+		ImGui::TableSetColumnIndex(3);
+		ImGui::TextUnformatted(WithCommas(island.accepted).c_str());
+		ImGui::TableSetColumnIndex(4);
+		ImGui::TextUnformatted(WithCommas(island.immigrants).c_str());
+	}
+	ImGui::EndTable();
 }
 
 void Dashboard::DrawConfigPanel()
@@ -127,8 +127,7 @@ void RecentGallery::StartXexBuild(size_t index)
 	xex_failed_ = false;
 	xex_message_.clear();
 	const std::string base = runs_[index].output_base;
-	xex_future_ = std::async(std::launch::async,
-		[base]() { return BuildRunXex(base); });
+	xex_future_ = xex_build_.Async([base]() { return BuildRunXex(base); });
 }
 
 void RecentGallery::PollXexBuild()
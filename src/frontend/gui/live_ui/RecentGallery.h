@@ -20,6 +20,7 @@
 #include <vector>
 
 #include "RecentRuns.h"
+#include "ThreadPool.h"
 #include "XexBuild.h"
 
 struct SDL_Renderer;
@@ -80,8 +81,9 @@ private:
 	std::string remove_folder_path_;
 	std::string remove_label_;
 
-	// Assembling runs off the UI thread - MADS takes long enough to drop frames.
-	// One at a time: it is a deliberate act on one run, not a batch.
+	// Assembling runs on the thread pool - MADS takes long enough to drop
+	// frames. One at a time: it is a deliberate act on one run, not a batch.
+	TaskGroup xex_build_;
 	std::future<XexBuildResult> xex_future_;
 	size_t xex_index_ = 0;
 	std::string xex_folder_;
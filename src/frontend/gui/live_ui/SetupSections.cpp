@@ -475,6 +475,12 @@ void DrawSearchGroup(SetupState& state, FileDialogs& dialogs, SDL_Window* window
 	}
 	ImGui::EndDisabled();
 
+	if (Row("line_candidates", cfg))
+		ValueSliderInt("line_candidates", &cfg.line_candidates, 1, 16);
+
+	if (Row("errmap", cfg))
+		ImGui::Checkbox("##errmap", &cfg.compact_error_map);
+
 	if (Row("seed", cfg)) {
 		ImGui::PushID("seed");
 		const float check_width = ImGui::CalcTextSize("Random").x
@@ -3,7 +3,6 @@
 #include <SDL3/SDL.h>
 
 #include <algorithm>
-#include <chrono>
 #include <cmath>
 #include <memory>
 #include <set>
@@ -183,10 +182,7 @@ TargetPreview::Inputs TargetPreview::Extract(const Configuration& cfg)
 	return inputs;
 }
 
-TargetPreview::TargetPreview()
-{
-	worker_ = std::thread(&TargetPreview::WorkerMain, this);
-}
+TargetPreview::TargetPreview() = default;
 
 TargetPreview::~TargetPreview()
 {
@@ -200,11 +196,9 @@ void TargetPreview::Shutdown()
 		if (stopping_)
 			return;
 		stopping_ = true;
+		job_cancel_.Cancel();
 	}
-	cancel_token_.fetch_add(1);
-	wake_.notify_all();
-	if (worker_.joinable())
-		worker_.join();
+	jobs_.Wait();
 }
 
 void TargetPreview::Request(const Configuration& cfg)
@@ -215,8 +209,10 @@ void TargetPreview::Request(const Configuration& cfg)
 		has_pending_ = false;
 		return;
 	}
-	if (has_pending_ && pending_ == inputs)
-		return; // Already queued, keep waiting out the debounce.
+	if (has_pending_ && pending_ == inputs) {
+		DispatchLocked(); // Already queued; starts once the debounce runs out.
+		return;
+	}
 	if (!has_pending_ && inputs == in_flight_ && (has_ready_ || busy_.load()))
 		return; // Already displayed, or already being computed.
 
@@ -226,9 +222,8 @@ void TargetPreview::Request(const Configuration& cfg)
 	pending_ = std::move(inputs);
 	has_pending_ = true;
 	pending_since_ = NowMs();
-	// Abandon whatever the worker is doing; its output is already stale.
-	cancel_token_.fetch_add(1);
-	wake_.notify_all();
+	// Abandon the running job; its output is already stale.
+	job_cancel_.Cancel();
 }
 
 void TargetPreview::ForceRefresh()
@@ -242,8 +237,8 @@ void TargetPreview::ForceRefresh()
 	pending_.exact = true;
 	has_pending_ = true;
 	pending_since_ = 0.0; // dispatch immediately
-	cancel_token_.fetch_add(1);
-	wake_.notify_all();
+	job_cancel_.Cancel();
+	DispatchLocked();
 }
 
 bool TargetPreview::Fetch(PreviewResult* out)
@@ -279,45 +274,35 @@ void TargetPreview::Publish(const PreviewResult& result)
 	has_ready_ = true;
 }
 
-void TargetPreview::WorkerMain()
+void TargetPreview::DispatchLocked()
 {
-	for (;;) {
-		Inputs job;
-		std::uint64_t generation = 0;
-		{
-			std::unique_lock<std::mutex> lock(mutex_);
-			wake_.wait(lock, [this] { return stopping_ || has_pending_; });
-			if (stopping_)
-				return;
-			// Honour the debounce without holding the lock in a spin.
-			const double waited = NowMs() - pending_since_;
-			if (waited < kDebounceMs) {
-				const auto remaining = std::chrono::milliseconds(
-					static_cast<int>(kDebounceMs - waited) + 1);
-				wake_.wait_for(lock, remaining);
-				if (stopping_)
-					return;
-				continue; // Re-check: the request may have been replaced.
-			}
-			job = pending_;
-			job.exact = exact_pinned_;
-			has_pending_ = false;
-			in_flight_ = job;
-			generation = generation_.fetch_add(1) + 1;
-			busy_.store(true);
-		}
-
-		Compute(job, generation);
+	if (stopping_ || !has_pending_ || busy_.load())
+		return;
+	if (NowMs() - pending_since_ < kDebounceMs)
+		return;
+	Inputs job = pending_;
+	job.exact = exact_pinned_;
+	has_pending_ = false;
+	in_flight_ = job;
+	const std::uint64_t generation = generation_.fetch_add(1) + 1;
+	job_cancel_ = CancellationToken();
+	busy_.store(true);
+	jobs_.Run([this, job, generation, cancel = job_cancel_] {
+		Compute(job, generation, cancel);
+		std::lock_guard<std::mutex> lock(mutex_);
 		busy_.store(false);
-	}
+		// A request that arrived meanwhile and is already past its debounce
+		// would otherwise wait for the next Request() call.
+		DispatchLocked();
+	});
 }
 
-void TargetPreview::Compute(const Inputs& inputs, std::uint64_t generation)
+void TargetPreview::Compute(const Inputs& inputs, std::uint64_t generation,
+	const CancellationToken& cancel)
 {
 	PreviewResult result;
 	result.generation = generation;
-	const std::uint64_t token = cancel_token_.load();
-	auto cancelled = [this, token] { return cancel_token_.load() != token; };
+	auto cancelled = [&cancel] { return cancel.Cancelled(); };
 	const double started = NowMs();
 
 	auto fail = [&](const std::string& message) {
@@ -480,8 +465,8 @@ void TargetPreview::Compute(const Inputs& inputs, std::uint64_t generation)
 
 	// --- Quantization ------------------------------------------------------
 	// The palette and distance function are process globals. Nothing else runs
-	// while Setup is open, and the worker is joined before the conversion
-	// starts, so writing them here is safe.
+	// while Setup is open, and Shutdown() waits for this job before the
+	// conversion starts, so writing them here is safe.
 	// Same fallback the run uses: try the working directory, then the folder
 	// the executable lives in.
 	std::string palette_path = inputs.palette_file;
@@ -4,21 +4,21 @@
 //
 // Produces four views of the same pixels - source, colour-corrected, quantized
 // and dithered - so the user can see what the palette and the dither actually
-// do before committing to a multi-hour run. Everything runs on one worker
-// thread; the UI thread only ever swaps a finished result in.
+// do before committing to a multi-hour run. Each job is one task on the shared
+// thread pool, and at most one is in flight; the UI thread only ever swaps a
+// finished result in.
 //
 // The quantization and dithering go through rasta::BuildQuantizedTarget, the
 // same code the real conversion uses, so preview and result cannot disagree.
 
 #include <atomic>
-#include <condition_variable>
 #include <cstdint>
 #include <mutex>
 #include <string>
-#include <thread>
 #include <vector>
 
 #include "config.h"
+#include "ThreadPool.h"
 
 namespace rc_live_ui {
 
@@ -116,8 +116,9 @@ public:
 
 	bool Busy() const;
 
-	// Stops the worker. Called before the Setup window closes so the global
-	// palette and distance function are left alone once the real run starts.
+	// Cancels and waits for the job in flight. Called before the Setup window
+	// closes so the global palette and distance function are left alone once
+	// the real run starts.
 	void Shutdown();
 
 private:
@@ -161,24 +162,25 @@ private:
 
 	static Inputs Extract(const Configuration& cfg);
 
-	void WorkerMain();
+	// Starts the pending request once it has been stable for the debounce
+	// interval and no job is running. Called with mutex_ held.
+	void DispatchLocked();
 	// Runs one job, calling Publish() with partial results as stages finish so
-	// the viewer fills in progressively. Abandons early when superseded.
-	void Compute(const Inputs& inputs, std::uint64_t generation);
+	// the viewer fills in progressively. Abandons early when cancelled.
+	void Compute(const Inputs& inputs, std::uint64_t generation,
+		const CancellationToken& cancel);
 	void Publish(const PreviewResult& result);
 
-	std::thread worker_;
 	mutable std::mutex mutex_;
-	std::condition_variable wake_;
 
 	Inputs pending_;         // what the UI last asked for
-	Inputs in_flight_;       // what the worker is computing
+	Inputs in_flight_;       // what the running job is computing
 	bool has_pending_ = false;
 	bool stopping_ = false;
 	std::atomic<bool> busy_{false};
 	std::atomic<std::uint64_t> generation_{0};
-	// Bumped when a newer request arrives, so the worker can abandon its job.
-	std::atomic<std::uint64_t> cancel_token_{0};
+	// The running job's token, cancelled when a newer request arrives.
+	CancellationToken job_cancel_;
 	// Sticky until one of the preview inputs actually changes.
 	bool exact_pinned_ = false;
 
@@ -187,10 +189,14 @@ private:
 	std::uint64_t revision_ = 0;
 	std::uint64_t fetched_revision_ = 0;
 
-	// Debounce: a request is only handed to the worker once the inputs have
+	// Debounce: a request is only handed to the pool once the inputs have
 	// been stable for a moment, so dragging a slider does not queue a job per
 	// frame.
 	double pending_since_ = 0.0;
+
+	// Last, so it is destroyed - and waits for the job - before the state the
+	// job writes to.
+	TaskGroup jobs_;
 };
 
 } // namespace rc_live_ui
@@ -0,0 +1,122 @@
+#include "CompactErrorMap.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+void Require(bool condition, const char *message)
+{
+	if (!condition)
+	{
+		std::cerr << "FAILED: " << message << '\n';
+		std::exit(1);
+	}
+}
+
+struct Planes
+{
+	std::vector<distance_t> values[CompactErrorMap::colors];
+	const distance_t* pointers[CompactErrorMap::colors];
+
+	Planes(unsigned width, unsigned height, distance_t range, unsigned seed)
+	{
+		std::mt19937 random(seed);
+		for (int color = 0; color < CompactErrorMap::colors; ++color)
+		{
+			values[color].resize(static_cast<size_t>(width) * height);
+			for (distance_t& value : values[color])
+				value = static_cast<distance_t>(random() % range);
+			pointers[color] = values[color].data();
+		}
+	}
+};
+
+void TestShiftSelection()
+{
+	unsigned long long histogram[33] = {};
+	histogram[16] = 1000;
+	Require(SelectCompactErrorShift(histogram, 0) == 0,
+		"16-bit errors must be stored unscaled");
+	histogram[20] = 5;
+	Require(SelectCompactErrorShift(histogram, 0) == 4,
+		"a 20-bit error needs a shift of 4 to stay unsaturated");
+	Require(SelectCompactErrorShift(histogram, 5) == 0,
+		"errors within the allowance may saturate instead of costing resolution");
+	histogram[32] = 1;
+	Require(SelectCompactErrorShift(histogram, 0) == 16,
+		"the shift is capped where any 32-bit error fits");
+}
+
+void TestSmallErrorsAreExact()
+{
+	const unsigned width = 37, height = 5;
+	Planes planes(width, height, 0x10000, 7);
+	CompactErrorMap map;
+	map.Build(planes.pointers, width, height);
+	Require(map.Shift() == 0, "16-bit errors must not be scaled");
+	Require(map.LastQuantization().mean_abs_error == 0.0
+		&& map.LastQuantization().saturated_fraction == 0.0,
+		"16-bit errors must be stored without loss");
+	for (int color = 0; color < CompactErrorMap::colors; ++color)
+		for (unsigned y = 0; y < height; ++y)
+			for (unsigned x = 0; x < width; ++x)
+				Require(map.At(color, y, x) == planes.values[color][y * width + x],
+					"At() must return the exact error when nothing is lost");
+}
+
+void TestLargeErrorsRoundAndSaturate()
+{
+	const unsigned width = 160, height = 3;
+	Planes planes(width, height, 1u << 22, 11);
+	CompactErrorMap map;
+	map.Build(planes.pointers, width, height);
+	Require(map.LastQuantization().mean_relative_error < 0.001,
+		"rounding must keep the mean error small");
+	planes.values[5][7] = DISTANCE_MAX;
+	map.Build(planes.pointers, width, height);
+	const unsigned shift = map.Shift();
+	Require(shift == 6, "22-bit errors need a shift of 6");
+	Require(map.LastQuantization().saturated_fraction > 0.0,
+		"an error beyond the shifted range must be reported as saturated");
+	Require(map.At(5, 0, 7) == distance_t{CompactErrorMap::max_value} << shift,
+		"saturated errors clamp to the largest stored value");
+	for (unsigned x = 0; x < width; ++x)
+	{
+		const distance_t exact = planes.values[5][x];
+		if (exact >= distance_t{CompactErrorMap::max_value} << shift)
+			continue;
+		const distance_t stored = map.At(5, 0, x);
+		const distance_t difference = stored > exact ? stored - exact : exact - stored;
+		Require(difference <= (1u << (shift - 1)),
+			"unsaturated errors must round to the nearest step");
+	}
+}
+
+void TestLineTilesAreContiguous()
+{
+	const unsigned width = 40, height = 4;
+	Planes planes(width, height, 100, 3);
+	CompactErrorMap map;
+	map.Build(planes.pointers, width, height);
+	const size_t stride = map.Row(1, 2) - map.Row(0, 2);
+	Require(stride >= width && stride % 16 == 0,
+		"colour rows of a line must be padded to whole vectors");
+	Require(map.Row(0, 3) == map.Row(CompactErrorMap::colors - 1, 2) + stride,
+		"a line's tile must be followed directly by the next line's");
+	Require(map.Bytes() == stride * CompactErrorMap::colors * height * sizeof(uint16_t),
+		"the map holds exactly one tile per line");
+}
+}
+
+int main()
+{
+	TestShiftSelection();
+	TestSmallErrorsAreExact();
+	TestLargeErrorsRoundAndSaturate();
+	TestLineTilesAreContiguous();
+	std::cout << "CompactErrorMap tests passed\n";
+	return 0;
+}
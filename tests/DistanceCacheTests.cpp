@@ -0,0 +1,78 @@
+#include "Distance.h"
+#include "rgb.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+void Require(bool condition, const char *message)
+{
+	if (!condition)
+	{
+		std::cerr << "FAILED: " << message << '\n';
+		std::exit(1);
+	}
+}
+
+std::vector<rgb> Colors()
+{
+	std::vector<rgb> colors;
+	for (int r = 0; r < 256; r += 17)
+		for (int g = 0; g < 256; g += 17)
+			for (int b = 0; b < 256; b += 17)
+			{
+				rgb color;
+				color.r = static_cast<unsigned char>(r);
+				color.g = static_cast<unsigned char>(g);
+				color.b = static_cast<unsigned char>(b);
+				color.a = 0;
+				colors.push_back(color);
+			}
+	return colors;
+}
+
+// Several threads convert the same unseen colours in the same order, the way
+// the error-plane tasks do. Each must see the finished conversion, never a
+// placeholder another thread has not filled yet.
+void TestConcurrentFirstUse(f_rgb_distance distance, const char *message)
+{
+	const std::vector<rgb> colors = Colors();
+	rgb reference;
+	reference.r = 200;
+	reference.g = 40;
+	reference.b = 90;
+	reference.a = 0;
+
+	const int threads = 8;
+	std::vector<std::vector<distance_t>> seen(threads);
+	std::vector<std::thread> workers;
+	std::atomic<int> ready{0};
+	for (int t = 0; t < threads; ++t)
+		workers.emplace_back([&, t] {
+			// Start together so the threads race on every colour.
+			ready.fetch_add(1);
+			while (ready.load() < threads)
+				std::this_thread::yield();
+			for (const rgb& color : colors)
+				seen[t].push_back(distance(color, reference));
+		});
+	for (std::thread& worker : workers)
+		worker.join();
+
+	for (int t = 0; t < threads; ++t)
+		for (size_t i = 0; i < colors.size(); ++i)
+			Require(seen[t][i] == distance(colors[i], reference), message);
+}
+}
+
+int main()
+{
+	TestConcurrentFirstUse(RGBCIEDE2000Distance, "CIEDE2000 must not read an unconverted Lab");
+	TestConcurrentFirstUse(RGBOklabDistance, "Oklab must not read an unconverted Lab");
+	std::cout << "DistanceCache tests passed\n";
+	return 0;
+}
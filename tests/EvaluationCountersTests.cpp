@@ -0,0 +1,164 @@
+#include "EvaluationCounters.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+void Require(bool condition, const char *message)
+{
+	if (!condition)
+	{
+		std::cerr << "FAILED: " << message << '\n';
+		std::exit(1);
+	}
+}
+
+void TestSingleWorker()
+{
+	std::atomic<unsigned long long> handedOut{0};
+	EvalWorkerCounters slot;
+	Require(ReserveEvaluations(handedOut, slot, 256) == 1, "numbering starts at one");
+	Require(CountCompletedEvaluations(handedOut, &slot, 1) == 0,
+		"a fresh reservation has completed nothing");
+	slot.unused_evaluations.store(200);
+	Require(CountCompletedEvaluations(handedOut, &slot, 1) == 56,
+		"used numbers of a batch are completed");
+}
+
+// Workers reserve and use numbers the way Evaluator::NextEvaluationNumber
+// does while the coordinator reads. A readout must never run ahead of the
+// numbers actually taken; before the ordering fix a reservation between the
+// two reads counted its whole batch as done.
+void TestReadoutNeverRunsAhead()
+{
+	const int workers = 4;
+	const unsigned long long batch = 32;
+	const unsigned long long perWorker = batch * 20000;
+	std::atomic<unsigned long long> handedOut{0};
+	std::vector<EvalWorkerCounters> slots(workers);
+	std::atomic<unsigned long long> taken{0};
+	std::atomic<int> running{workers};
+
+	std::vector<std::thread> threads;
+	for (int w = 0; w < workers; ++w)
+		threads.emplace_back([&, w] {
+			unsigned long long next = 0, end = 0;
+			for (unsigned long long i = 0; i < perWorker; ++i)
+			{
+				if (next == end)
+				{
+					next = ReserveEvaluations(handedOut, slots[w], batch);
+					end = next + batch;
+				}
+				taken.fetch_add(1);
+				++next;
+				slots[w].unused_evaluations.store(end - next, std::memory_order_relaxed);
+			}
+			running.fetch_sub(1);
+		});
+
+	// One slot of slack per worker for a number taken between the reads.
+	while (running.load() > 0)
+	{
+		const unsigned long long completed =
+			CountCompletedEvaluations(handedOut, slots.data(), slots.size());
+		Require(completed <= taken.load() + workers,
+			"the readout must not count reserved numbers as completed");
+	}
+	for (std::thread& thread : threads)
+		thread.join();
+	Require(CountCompletedEvaluations(handedOut, slots.data(), slots.size())
+		== workers * perWorker, "the readout is exact once the workers stopped");
+}
+
+// A worker that stops partway through a batch gives the rest back, as
+// Evaluator::ReturnUnusedEvaluations does. A readout whose first read of the
+// total precedes the return and whose slot read follows it would count the
+// returned numbers as done, so that readout must be refused and retried.
+void TestReturnBetweenReads()
+{
+	std::atomic<unsigned long long> handedOut{0};
+	EvalWorkerCounters slots[2];
+	ReserveEvaluations(handedOut, slots[0], 256);
+	ReserveEvaluations(handedOut, slots[1], 256);
+	slots[0].unused_evaluations.store(250);
+	slots[1].unused_evaluations.store(200);
+
+	const unsigned long long before = handedOut.load();
+	ReturnEvaluations(handedOut, slots[0], 250);
+	const unsigned long long unused = SumUnusedEvaluations(slots, 2);
+	const unsigned long long after = handedOut.load();
+	unsigned long long completed = 0;
+	Require(before - unused == 312, "a single read of the total would count the return as done");
+	Require(!CompletedFromReadout(before, unused, after, completed),
+		"a readout across a return must be retried");
+	Require(CountCompletedEvaluations(handedOut, slots, 2) == 62,
+		"the retried readout counts only used numbers");
+
+	// The same for a reservation between the reads.
+	const unsigned long long beforeReserve = handedOut.load();
+	ReserveEvaluations(handedOut, slots[0], 256);
+	Require(!CompletedFromReadout(beforeReserve, SumUnusedEvaluations(slots, 2),
+		handedOut.load(), completed), "a readout across a reservation must be retried");
+	Require(CountCompletedEvaluations(handedOut, slots, 2) == 62,
+		"a fresh batch adds nothing completed");
+}
+
+// Workers returning partial batches while the coordinator reads.
+void TestReadoutAcrossReturns()
+{
+	const int workers = 4;
+	const unsigned long long batch = 32;
+	const int segments = 20000;
+	std::atomic<unsigned long long> handedOut{0};
+	std::vector<EvalWorkerCounters> slots(workers);
+	std::atomic<unsigned long long> taken{0};
+	std::atomic<int> running{workers};
+
+	std::vector<std::thread> threads;
+	for (int w = 0; w < workers; ++w)
+		threads.emplace_back([&, w] {
+			for (int segment = 0; segment < segments; ++segment)
+			{
+				unsigned long long next = ReserveEvaluations(handedOut, slots[w], batch);
+				const unsigned long long end = next + batch;
+				const unsigned long long use = (segment + w) % 4;
+				for (unsigned long long i = 0; i < use; ++i)
+				{
+					taken.fetch_add(1);
+					++next;
+					slots[w].unused_evaluations.store(end - next, std::memory_order_relaxed);
+				}
+				ReturnEvaluations(handedOut, slots[w], end - next);
+			}
+			running.fetch_sub(1);
+		});
+
+	while (running.load() > 0)
+	{
+		const unsigned long long completed =
+			CountCompletedEvaluations(handedOut, slots.data(), slots.size());
+		Require(completed <= taken.load() + workers,
+			"the readout must not count returned numbers as completed");
+	}
+	for (std::thread& thread : threads)
+		thread.join();
+	Require(handedOut.load() == taken.load(), "returned numbers leave the total");
+	Require(CountCompletedEvaluations(handedOut, slots.data(), slots.size())
+		== taken.load(), "the readout is exact once the workers stopped");
+}
+}
+
+int main()
+{
+	TestSingleWorker();
+	TestReadoutNeverRunsAhead();
+	TestReturnBetweenReads();
+	TestReadoutAcrossReturns();
+	std::cout << "EvaluationCounters tests passed\n";
+	return 0;
+}
@@ -0,0 +1,145 @@
+#include "IslandTopology.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+void Require(bool condition, const char *message)
+{
+	if (!condition)
+	{
+		std::cerr << "FAILED: " << message << '\n';
+		std::exit(1);
+	}
+}
+
+bool Contains(const std::vector<int>& sources, int island)
+{
+	return std::find(sources.begin(), sources.end(), island) != sources.end();
+}
+
+// Every island must be reachable from every other by following sources.
+bool Connected(const std::vector<std::vector<int>>& sources)
+{
+	for (size_t start = 0; start < sources.size(); ++start)
+	{
+		std::vector<bool> reached(sources.size(), false);
+		std::vector<int> pending(1, static_cast<int>(start));
+		reached[start] = true;
+		while (!pending.empty())
+		{
+			const int island = pending.back();
+			pending.pop_back();
+			for (int source : sources[island])
+				if (!reached[source])
+				{
+					reached[source] = true;
+					pending.push_back(source);
+				}
+		}
+		if (std::find(reached.begin(), reached.end(), false) != reached.end())
+			return false;
+	}
+	return true;
+}
+
+void RequireWellFormed(const std::vector<std::vector<int>>& sources, int islands)
+{
+	Require(static_cast<int>(sources.size()) == islands, "one source list per island");
+	for (int i = 0; i < islands; ++i)
+	{
+		std::vector<int> sorted = sources[i];
+		std::sort(sorted.begin(), sorted.end());
+		Require(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end(),
+			"an island must not list a source twice");
+		Require(!Contains(sources[i], i), "an island must not take from itself");
+		for (int source : sources[i])
+			Require(source >= 0 && source < islands, "sources must be islands");
+	}
+}
+
+void TestNames()
+{
+	IslandTopology topology = IslandTopology::Global;
+	Require(ParseIslandTopology("torus", topology) && topology == IslandTopology::Torus,
+		"torus must parse");
+	Require(!ParseIslandTopology("mesh", topology), "unknown names must be refused");
+	Require(std::string(IslandTopologyName(IslandTopology::Star)) == "star",
+		"names must round-trip");
+}
+
+void TestGlobalAndSingleIslandHaveNoSources()
+{
+	for (const std::vector<int>& sources : BuildIslandSources(IslandTopology::Global, 8, 2, 1))
+		Require(sources.empty(), "global islands follow the published best only");
+	const std::vector<std::vector<int>> single = BuildIslandSources(IslandTopology::Ring, 1, 2, 1);
+	Require(single.size() == 1 && single[0].empty(), "a lone island has no neighbours");
+}
+
+void TestRing()
+{
+	const std::vector<std::vector<int>> sources = BuildIslandSources(IslandTopology::Ring, 5, 2, 1);
+	RequireWellFormed(sources, 5);
+	for (int i = 0; i < 5; ++i)
+		Require(sources[i] == std::vector<int>(1, (i + 4) % 5), "a ring island takes from its predecessor");
+	Require(Connected(sources), "the ring must be connected");
+}
+
+void TestTorus()
+{
+	const std::vector<std::vector<int>> square = BuildIslandSources(IslandTopology::Torus, 16, 2, 1);
+	RequireWellFormed(square, 16);
+	for (const std::vector<int>& sources : square)
+		Require(sources.size() == 4, "a 4x4 torus island has four neighbours");
+	Require(Contains(square[0], 3) && Contains(square[0], 12),
+		"the torus must wrap both rows and columns");
+
+	// Seven islands on three columns leave a short last row.
+	const std::vector<std::vector<int>> ragged = BuildIslandSources(IslandTopology::Torus, 7, 2, 1);
+	RequireWellFormed(ragged, 7);
+	Require(Connected(ragged), "a ragged torus must stay connected");
+	Require(Contains(ragged[6], 3), "the short row must still reach the row above");
+}
+
+void TestRandom()
+{
+	const std::vector<std::vector<int>> sources = BuildIslandSources(IslandTopology::Random, 12, 3, 42);
+	RequireWellFormed(sources, 12);
+	for (int i = 0; i < 12; ++i)
+	{
+		Require(sources[i].size() == 3, "random islands take from degree sources");
+		Require(Contains(sources[i], (i + 11) % 12), "the ring edge must always be present");
+	}
+	Require(Connected(sources), "random topologies must be connected");
+	Require(sources == BuildIslandSources(IslandTopology::Random, 12, 3, 42),
+		"the same seed must give the same topology");
+	const std::vector<std::vector<int>> capped = BuildIslandSources(IslandTopology::Random, 3, 8, 42);
+	for (const std::vector<int>& list : capped)
+		Require(list.size() == 2, "the degree is capped at the other islands");
+}
+
+void TestStar()
+{
+	const std::vector<std::vector<int>> sources = BuildIslandSources(IslandTopology::Star, 6, 2, 1);
+	RequireWellFormed(sources, 6);
+	Require(sources[0].size() == 5, "the hub takes from every other island");
+	for (int i = 1; i < 6; ++i)
+		Require(sources[i] == std::vector<int>(1, 0), "spokes take from the hub only");
+}
+}
+
+int main()
+{
+	TestNames();
+	TestGlobalAndSingleIslandHaveNoSources();
+	TestRing();
+	TestTorus();
+	TestRandom();
+	TestStar();
+	std::cout << "IslandTopology tests passed\n";
+	return 0;
+}
@@ -1,7 +1,10 @@
 #include "Program.h"
 #include "LineCache.h"
+#include "SharedLineCache.h"
 
+#include <cstddef>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <vector>
 
@@ -48,7 +51,9 @@ void TestReclaimableLineArena()
 
 	Require(cache.find(key, hash) == &inserted, "inserted line result must be found");
 	Require(arena.size() > 0, "line arena must own resident storage after insert");
-	Require(stats.resident_bytes == arena.size(), "shared resident accounting must include line arena");
+	Require(stats.table_bytes > 0, "a table must allocate storage on its first insert");
+	Require(stats.resident_bytes == arena.size() + stats.table_bytes,
+		"shared resident accounting must include line arena and table");
 	const size_t allocated_entries = stats.allocated_by_type[linear_allocator::LINE_CACHE_ENTRY];
 
 	cache.clear();
@@ -60,6 +65,38 @@ void TestReclaimableLineArena()
 		"allocation attribution must remain cumulative after reclaim");
 }
 
+void TestArenaRetainsChunksAcrossClears(size_t block_size)
+{
+	linear_allocator::statistics stats;
+	{
+		linear_allocator arena(block_size, &stats);
+		void *first = arena.allocate(1024, linear_allocator::INSN_CACHE_DATA);
+		arena.allocate(block_size, linear_allocator::INSN_CACHE_DATA);
+		const size_t resident = arena.size();
+		Require(stats.chunk_allocations == 2, "an oversized request must take a chunk of its own");
+
+		arena.clear();
+		Require(stats.resident_bytes == 0, "cleared chunks must leave the resident budget");
+		Require(stats.retained_bytes > 0 && stats.retained_bytes < resident,
+			"standard chunks must be retained and oversized ones freed");
+
+		void *again = arena.allocate(1024, linear_allocator::INSN_CACHE_DATA);
+		Require(again == first, "the next fill must reuse the retained chunk");
+		Require(stats.chunk_reuses == 1 && stats.chunk_allocations == 2,
+			"reusing a chunk must not allocate a new one");
+		Require(stats.retained_bytes == 0, "a reused chunk is resident again");
+		memset(again, 0xab, 1024);
+
+		arena.clear();
+		arena.release();
+		Require(stats.retained_bytes == 0 && stats.huge_page_bytes == 0,
+			"release must hand back every chunk");
+		arena.allocate(16, linear_allocator::INSN_CACHE_DATA);
+	}
+	Require(stats.resident_bytes == 0 && stats.retained_bytes == 0 && stats.huge_page_bytes == 0,
+		"destroying an arena must release all of its chunks");
+}
+
 void TestAntic4AttributeRowIsPartOfKey()
 {
 	antic4_line_cache_key normal{};
@@ -73,6 +110,359 @@ void TestAntic4AttributeRowIsPartOfKey()
 			< sizeof(std::pair<antic4_line_cache_key, line_cache_result>),
 		"mode E cache entries must not carry the ANTIC 4 attribute payload");
 }
+
+void TestCustomValueCache()
+{
+	struct trace_value
+	{
+		register_state new_state;
+		int span_count;
+	};
+	linear_allocator arena(65536);
+	line_cache cache;
+	line_cache_key key{};
+	key.entry_state.mem_regs[E_COLBAK] = 0x34;
+	const uint32_t hash = key.hash();
+	trace_value& inserted = cache.insert<line_cache_key, trace_value>(key, hash, arena);
+	inserted.span_count = 5;
+	const trace_value* found = cache.find<line_cache_key, trace_value>(key, hash);
+	Require(found == &inserted && found->span_count == 5,
+		"a cache must store values other than line results");
+	line_cache_key other = key;
+	other.entry_state.reg_y = 1;
+	Require(cache.find<line_cache_key, trace_value>(other, other.hash()) == NULL,
+		"a different key must not find the stored value");
+}
+
+void TestTableGrowsWithoutMovingValues()
+{
+	linear_allocator::statistics stats;
+	linear_allocator arena(65536, &stats);
+	line_cache cache;
+	auto keyFor = [](int i)
+	{
+		line_cache_key key{};
+		key.entry_state.reg_a = static_cast<unsigned char>(i);
+		key.entry_state.reg_x = static_cast<unsigned char>(i >> 8);
+		return key;
+	};
+	Require(cache.capacity() == 0 && cache.find(keyFor(0), keyFor(0).hash()) == NULL,
+		"an unused table must own no storage");
+
+	const int count = 10000;
+	std::vector<line_cache_result*> values(count);
+	int growths = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		line_cache_key key = keyFor(i);
+		bool grew = false;
+		values[i] = &cache.insert(key, key.hash(), arena, &grew);
+		values[i]->line_error = i;
+		growths += grew;
+	}
+	Require(cache.capacity() == 16384 && growths == 9,
+		"a table must double from its minimum whenever it passes 7/8 full");
+	Require(stats.resident_bytes == arena.size() + stats.table_bytes
+			&& stats.table_bytes == cache.capacity() * (1 + sizeof(line_cache::hash_node)),
+		"table storage must count as resident");
+	for (int i = 0; i < count; ++i)
+	{
+		line_cache_key key = keyFor(i);
+		Require(cache.find(key, key.hash()) == values[i],
+			"values must keep their address when the table grows");
+	}
+
+	for (int i = 0; i < count; i += 2)
+	{
+		line_cache_key key = keyFor(i);
+		cache.erase(key.hash(), reinterpret_cast<char*>(values[i])
+			- offsetof(line_cache::value_type, second));
+	}
+	Require(cache.size() == static_cast<size_t>(count / 2), "erase must drop exactly one node");
+	for (int i = 0; i < count; ++i)
+	{
+		line_cache_key key = keyFor(i);
+		const line_cache_result* found = cache.find(key, key.hash());
+		Require((i & 1) ? found == values[i] : found == NULL,
+			"erase must only drop the erased value");
+	}
+
+	cache.clear();
+	Require(cache.capacity() == 0 && cache.size() == 0,
+		"clearing must release a table's storage");
+	Require(stats.resident_bytes == arena.size() && stats.table_bytes == 0,
+		"clearing a table must release its resident bytes");
+}
+
+void TestSlotEvictionKeepsPinnedAndReferenced()
+{
+	const size_t slab = 8192;
+	linear_allocator::statistics stats;
+	line_cache_slots slots;
+	slots.configure(sizeof(line_cache::value_type), 160, slab, slab, &stats);
+	line_cache cache;
+
+	// One shared hash keeps every entry on a single probe sequence, so
+	// eviction has to drop nodes from the middle of it.
+	const uint32_t hash = 7;
+	auto keyFor = [](int i)
+	{
+		line_cache_key key{};
+		key.entry_state.reg_a = static_cast<unsigned char>(i);
+		key.entry_state.reg_x = static_cast<unsigned char>(i >> 8);
+		return key;
+	};
+	auto insert = [&](int i) -> line_cache_result&
+	{
+		slots.begin_render();
+		line_cache_result& result = cache.insert(keyFor(i), hash, slots);
+		result.line_error = i;
+		memset(result.color_row, i & 0xff, 160);
+		return result;
+	};
+
+	line_cache_result& pinned = insert(0);
+	slots.pin(pinned.slot);
+	insert(1);
+	for (int i = 2; i < 400; ++i)
+	{
+		insert(i);
+		const line_cache_result* hot = cache.find(keyFor(1), hash);
+		Require(hot != NULL, "an entry hit between inserts must keep its second chance");
+		slots.touch(*hot);
+	}
+
+	Require(slots.evictions() > 0, "a full pool must recycle slots");
+	Require(slots.overflows() == 0, "a pool with evictable slots must not outgrow its limit");
+	Require(slots.size() <= slab, "recycling must keep the pool within its limit");
+	Require(slots.slots() < 400, "slots must be reused rather than carved for every insert");
+	const line_cache_result* found = cache.find(keyFor(0), hash);
+	Require(found == &pinned && found->line_error == 0 && found->color_row[159] == 0,
+		"a pinned entry must survive eviction with its rows intact");
+	Require(cache.find(keyFor(2), hash) == NULL, "an unreferenced old entry must be evicted");
+	const line_cache_result* newest = cache.find(keyFor(399), hash);
+	Require(newest != NULL && newest->line_error == 399 && newest->color_row[0] == (399 & 0xff),
+		"the newest entry must be found with its own rows");
+	Require(newest->slot != pinned.slot,
+		"every live entry must own its slot");
+
+	slots.begin_render();
+	const int capacity = static_cast<int>(slots.slots());
+	for (int i = 400; i <= 400 + capacity; ++i)
+		cache.insert(keyFor(i), hash, slots);
+	Require(slots.overflows() > 0,
+		"slots returned by the current render must not be recycled by it");
+}
+
+void TestLeanSlotsHoldMoreResults()
+{
+	const size_t slab = 65536;
+	auto fill = [slab](size_t width, linear_allocator::statistics& stats, bool& rows)
+	{
+		line_cache_slots slots;
+		slots.configure(sizeof(line_cache::value_type), width, slab, slab, &stats);
+		line_cache cache;
+		rows = true;
+		for (int i = 0; i < 4000; ++i)
+		{
+			line_cache_key key{};
+			key.entry_state.reg_a = static_cast<unsigned char>(i);
+			key.entry_state.reg_x = static_cast<unsigned char>(i >> 8);
+			slots.begin_render();
+			line_cache_result& result = cache.insert(key, key.hash(), slots);
+			rows = rows && result.color_row != NULL && result.packed_target_row != NULL;
+		}
+		return slots.slots();
+	};
+
+	linear_allocator::statistics fullStats, leanStats;
+	bool fullRows = false, leanRows = true;
+	const size_t full = fill(160, fullStats, fullRows);
+	const size_t lean = fill(0, leanStats, leanRows);
+	Require(fullRows, "a pool configured with a width must give every result its rows");
+	Require(!leanRows, "a lean pool must give results no rows");
+	Require(leanStats.allocated_by_type[linear_allocator::LINE_CACHE_COLOR_ROW] == 0
+		&& leanStats.allocated_by_type[linear_allocator::LINE_CACHE_TARGET_ROW] == 0,
+		"a lean pool must not attribute row bytes");
+	Require(lean > 2 * full, "the same limit must hold several times more lean results");
+}
+
+void TestSharedLinesMatchByContent()
+{
+	const unsigned width = 160, height = 4;
+	shared_line_cache shared;
+	shared.configure(width, height, 0, 2);
+	Require(!shared.enabled(), "a zero budget must disable the shared tier");
+	shared.configure(width, height, 1024 * 1024, 2);
+	Require(shared.enabled() && shared.shards() == 2, "a budget must enable one shard per worker");
+
+	SRasterInstruction insns[2];
+	insns[0].packed = 0;
+	insns[0].loose.instruction = E_RASTER_LDA;
+	insns[0].loose.value = 0x34;
+	insns[1].packed = 0;
+	insns[1].loose.instruction = E_RASTER_STA;
+	insns[1].loose.target = E_COLOR0;
+	SRasterInstruction copies[2] = { insns[0], insns[1] };
+	const insn_sequence published_seq = { insns, 2, 99 };
+	const insn_sequence other_seq = { copies, 2, 99 };
+
+	line_cache_key key{};
+	key.entry_state.reg_x = 5;
+	key.insn_seq = &published_seq;
+	std::vector<unsigned char> colors(width), targets(width);
+	for (unsigned x = 0; x < width; ++x)
+	{
+		colors[x] = static_cast<unsigned char>(x * 3);
+		targets[x] = static_cast<unsigned char>(x & 7);
+	}
+	std::vector<unsigned char> packed(line_cache_result::packed_target_bytes(width));
+	line_cache_result::pack_target_row(packed.data(), targets.data(), width);
+	line_cache_result result{};
+	result.line_error = 4321;
+	result.new_state.reg_a = 0x34;
+	result.sprite_bits = 0x55;
+	result.color_row = colors.data();
+	result.packed_target_row = packed.data();
+
+	const uint64_t attributes = 0x0102030405060708ULL;
+	const uint32_t hash = shared_line_cache::hash(key, attributes);
+	Require(shared.publish(0, 2, key, attributes, hash, result), "publishing into an empty line must succeed");
+
+	line_cache_key other = key;
+	other.insn_seq = &other_seq;
+	Require(shared_line_cache::hash(other, attributes) == hash,
+		"workers that interned equal instructions separately must agree on the hash");
+	const shared_line_record* record = shared.find(2, other, attributes, hash);
+	Require(record != NULL, "a record must be found by instruction content");
+	Require(shared.find(1, other, attributes, hash) == NULL, "records belong to one line");
+	Require(shared.find(2, other, attributes + 1, shared_line_cache::hash(other, attributes + 1)) == NULL,
+		"a different attribute row must miss");
+	other.entry_state.reg_x = 6;
+	Require(shared.find(2, other, attributes, shared_line_cache::hash(other, attributes)) == NULL,
+		"a different entry state must miss");
+
+	std::vector<unsigned char> adopted_colors(width), adopted_packed(packed.size()), decoded(width);
+	line_cache_result adopted{};
+	adopted.color_row = adopted_colors.data();
+	adopted.packed_target_row = adopted_packed.data();
+	shared.copy(*record, adopted);
+	adopted.copy_target_row(decoded.data(), width);
+	Require(adopted.line_error == 4321 && adopted.new_state.reg_a == 0x34 && adopted.sprite_bits == 0x55,
+		"an adopted result must carry the published scalars");
+	Require(adopted_colors == colors && decoded == targets, "an adopted result must carry the published rows");
+
+	shared.clear();
+	Require(shared.find(2, key, attributes, hash) == NULL, "clear must drop every record");
+}
+
+void TestSharedLinesWithoutRows()
+{
+	shared_line_cache shared;
+	shared.configure(0, 1, 1024 * 1024, 1);
+	const insn_sequence seq = { NULL, 0, 1 };
+	line_cache_key key{};
+	key.insn_seq = &seq;
+	line_cache_result result{};
+	result.line_error = 77;
+	result.sprite_bits = 3;
+	const uint32_t hash = shared_line_cache::hash(key, 0);
+	Require(shared.publish(0, 0, key, 0, hash, result), "a result without rows must publish");
+	const shared_line_record* record = shared.find(0, key, 0, hash);
+	Require(record != NULL, "a result published without rows must be found");
+	line_cache_result adopted{};
+	shared.copy(*record, adopted);
+	Require(adopted.line_error == 77 && adopted.sprite_bits == 3,
+		"a lean adoption must carry the published scalars");
+}
+
+void TestSharedShardBudget()
+{
+	const unsigned width = 160;
+	shared_line_cache shared;
+	shared.configure(width, 1, 256 * 1024, 2);
+	std::vector<unsigned char> colors(width);
+	std::vector<unsigned char> packed(line_cache_result::packed_target_bytes(width));
+	line_cache_result result{};
+	result.color_row = colors.data();
+	result.packed_target_row = packed.data();
+	const insn_sequence seq = { NULL, 0, 1 };
+
+	bool rejected = false;
+	for (int i = 0; i < 65536 && !rejected; ++i)
+	{
+		line_cache_key key{};
+		key.entry_state.reg_a = static_cast<unsigned char>(i);
+		key.entry_state.reg_x = static_cast<unsigned char>(i >> 8);
+		key.insn_seq = &seq;
+		rejected = !shared.publish(1, 0, key, 0, shared_line_cache::hash(key, 0), result);
+	}
+	Require(rejected, "a shard must stop publishing once its budget or the table is full");
+}
+
+void TestInsnSequencesInternByContent()
+{
+	linear_allocator::statistics stats;
+	linear_allocator arena(65536, &stats);
+	insn_sequence_cache cache;
+	auto lineFor = [](int i)
+	{
+		raster_line line;
+		for (int k = 0; k < 1 + (i % 5); ++k)
+		{
+			SRasterInstruction insn{};
+			insn.loose.instruction = static_cast<e_raster_instruction>(E_RASTER_LDA + k % 3);
+			insn.loose.value = static_cast<unsigned char>(i >> (k * 2));
+			insn.loose.target = static_cast<e_target>(k);
+			line.instructions.push_back(insn);
+		}
+		line.rehash();
+		return line;
+	};
+
+	const int count = 5000;
+	std::vector<const insn_sequence*> keys(count);
+	for (int i = 0; i < count; ++i)
+	{
+		raster_line line = lineFor(i);
+		line.recache_insns(cache, arena);
+		keys[i] = line.cache_key;
+	}
+	Require(cache.capacity() >= 2 * cache.size() && cache.capacity() > insn_sequence_cache::MIN_CAPACITY,
+		"the intern table must grow to stay at most half full");
+	Require(stats.resident_bytes == arena.size() + cache.table_bytes() && stats.table_bytes == 0,
+		"intern table storage must count as resident but not as line cache tables");
+	for (int i = 0; i < count; ++i)
+	{
+		raster_line line = lineFor(i);
+		line.recache_insns(cache, arena);
+		Require(line.cache_key == keys[i], "equal instructions must intern to the same sequence");
+		for (int j = i + 1; j < i + 4 && j < count; ++j)
+		{
+			bool equal = lineFor(j).instructions.size() == line.instructions.size();
+			for (size_t k = 0; equal && k < line.instructions.size(); ++k)
+				equal = lineFor(j).instructions[k] == line.instructions[k];
+			Require((keys[j] == keys[i]) == equal, "different instructions must not share a sequence");
+		}
+	}
+
+	raster_line line = lineFor(4);
+	const SRasterInstruction before = line.instructions[1];
+	line.instructions[1].loose.value ^= 0x10;
+	line.instruction_changed(1, before);
+	Require(line.hash == line.content_hash(), "an in-place edit must update the hash like a rehash");
+	const SRasterInstruction first = line.instructions[0];
+	line.instructions[0] = line.instructions[3];
+	line.instructions[3] = first;
+	line.instruction_changed(0, first);
+	line.instruction_changed(3, line.instructions[0]);
+	Require(line.hash == line.content_hash(), "a swap must update the hash like a rehash");
+
+	cache.clear();
+	Require(cache.capacity() == 0 && cache.size() == 0 && cache.find(*keys[0]) == NULL,
+		"clearing must forget every sequence");
+	Require(stats.resident_bytes == arena.size(), "clearing must release the table's resident bytes");
+}
 }
 
 int main()
@@ -80,7 +470,17 @@ int main()
 	TestPackedTargetRow(160);
 	TestPackedTargetRow(159);
 	TestReclaimableLineArena();
+	TestArenaRetainsChunksAcrossClears(65536);
+	TestArenaRetainsChunksAcrossClears(linear_allocator::BLOCK_SIZE);
 	TestAntic4AttributeRowIsPartOfKey();
+	TestCustomValueCache();
+	TestTableGrowsWithoutMovingValues();
+	TestInsnSequencesInternByContent();
+	TestSlotEvictionKeepsPinnedAndReferenced();
+	TestLeanSlotsHoldMoreResults();
+	TestSharedLinesMatchByContent();
+	TestSharedLinesWithoutRows();
+	TestSharedShardBudget();
 	std::cout << "LineCache tests passed\n";
 	return 0;
 }
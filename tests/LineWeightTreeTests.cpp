@@ -0,0 +1,80 @@
+#include "LineWeightTree.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+void Require(bool condition, const char *message)
+{
+	if (!condition)
+	{
+		std::cerr << "FAILED: " << message << '\n';
+		std::exit(1);
+	}
+}
+
+unsigned long long LinearPrefix(const std::vector<unsigned long long>& weights, size_t end)
+{
+	unsigned long long sum = 0;
+	for (size_t i = 0; i < end; ++i)
+		sum += weights[i];
+	return sum;
+}
+
+void TestPrefixMatchesLinearSum()
+{
+	std::mt19937 random(5);
+	std::vector<unsigned long long> weights(240);
+	for (unsigned long long& weight : weights)
+		weight = random() % 1000;
+	LineWeightTree<unsigned long long> tree;
+	tree.Assign(weights);
+	for (size_t end = 0; end <= weights.size(); ++end)
+		Require(tree.Prefix(end) == LinearPrefix(weights, end), "prefix must match the linear sum");
+
+	for (int step = 0; step < 2000; ++step)
+	{
+		const size_t line = random() % weights.size();
+		weights[line] = random() % 1000;
+		tree.Set(line, weights[line]);
+	}
+	for (size_t end = 0; end <= weights.size(); ++end)
+		Require(tree.Prefix(end) == LinearPrefix(weights, end),
+			"prefix must follow lowered and raised weights");
+}
+
+void TestFindSkipsZeroWeights()
+{
+	LineWeightTree<unsigned long long> tree;
+	tree.Assign({ 0, 3, 0, 0, 2, 0, 1 });
+	const size_t expected[] = { 1, 1, 1, 4, 4, 6 };
+	for (unsigned long long target = 0; target < 6; ++target)
+		Require(tree.Find(target) == expected[target],
+			"each target must land on the line whose interval holds it");
+	Require(tree.Find(6) == tree.Size(), "a target past the total finds no line");
+
+	tree.Set(4, 0);
+	Require(tree.Find(3) == 6, "a line set to zero must no longer be found");
+}
+
+void TestFloatingWeights()
+{
+	LineWeightTree<double> tree;
+	tree.Assign({ 0.5, 0.0, 1.5, 2.0 });
+	Require(tree.Prefix(4) == 4.0, "floating weights must sum exactly here");
+	Require(tree.Find(0.25) == 0 && tree.Find(0.75) == 2 && tree.Find(3.5) == 3,
+		"floating targets must land on their lines");
+}
+}
+
+int main()
+{
+	TestPrefixMatchesLinearSum();
+	TestFindSkipsZeroWeights();
+	TestFloatingWeights();
+	std::cout << "LineWeightTree tests passed\n";
+	return 0;
+}
@@ -66,6 +66,26 @@ void TestDriftCanAdmitCandidate()
 	Require(state.currentCost == 10.25, "drift-accepted candidate must become current");
 }
 
+void TestAcceptanceLimitBoundsApply()
+{
+	for (OptimizerKind kind : { OptimizerKind::LAHC, OptimizerKind::DLAS })
+	{
+		OptimizerState state;
+		state.Initialize(10.0, 3);
+		Require(state.Apply(kind, 8.0), "improvement should be accepted");
+		Require(state.Apply(kind, 9.0), "history should admit worsening move");
+		const double limit = state.AcceptanceLimit(kind, 0.25);
+		Require(limit >= state.currentCost + 0.25, "the limit must admit every current improvement");
+
+		OptimizerState rejected = state;
+		Require(!rejected.Apply(kind, limit + 0.5, 0.25), "a cost above the limit must be rejected");
+		OptimizerState farRejected = state;
+		Require(!farRejected.Apply(kind, limit + 100.0, 0.25), "a cost far above the limit must be rejected");
+		Require(rejected.history == farRejected.history && rejected.costMax == farRejected.costMax,
+			"rejection must not depend on how far the cost exceeds the limit");
+	}
+}
+
 void TestDualAcceptedWorseFrameSurvivesFocusSwitch()
 {
 	DualOptimizerState<int> state;
@@ -145,6 +165,7 @@ int main()
 	TestLahcAlwaysAcceptsCurrentImprovement();
 	TestDlasAcceptedCandidateBecomesCurrent();
 	TestDriftCanAdmitCandidate();
+	TestAcceptanceLimitBoundsApply();
 	TestDualAcceptedWorseFrameSurvivesFocusSwitch();
 	TestDualRejectedFrameDoesNotReplaceCurrentPair();
 	TestDualInPlaceAcceptanceUpdatesOnlyOptimizerState();
@@ -0,0 +1,250 @@
+#include "PlayfieldSpan.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+void Require(bool condition, const char *message)
+{
+	if (!condition)
+	{
+		std::cerr << "FAILED: " << message << '\n';
+		std::exit(1);
+	}
+}
+
+struct SpanFixture
+{
+	std::vector<distance_t> planes[E_PLAYFIELD_SLOT_MAX];
+	PlayfieldSpanRegisters registers{};
+
+	SpanFixture(int width, distance_t range, uint64_t alternate, unsigned seed)
+	{
+		std::mt19937 random(seed);
+		for (int slot = 0; slot < E_PLAYFIELD_SLOT_MAX; ++slot)
+		{
+			planes[slot].resize(width);
+			for (distance_t& value : planes[slot])
+				value = static_cast<distance_t>(random() % range);
+			registers.rows[slot] = planes[slot].data();
+			registers.colors[slot] = static_cast<unsigned char>(10 + slot * 7);
+			registers.targets[slot] = static_cast<unsigned char>(slot == 0 ? 3 : slot - 1);
+		}
+		registers.alternate_columns = alternate;
+	}
+};
+
+void TestKernelMatchesScalar(playfield_span_kernel kernel,
+	distance_t range, uint64_t alternate)
+{
+	const int width = 176;
+	SpanFixture fixture(width, range, alternate, 1234u + range);
+	for (int first = 0; first < 12; ++first)
+	{
+		for (int end = first; end <= width; end += 5)
+		{
+			unsigned char expectedColors[width];
+			unsigned char expectedTargets[width];
+			unsigned char colors[width];
+			unsigned char targets[width];
+			memset(expectedColors, 0xEE, sizeof expectedColors);
+			memset(expectedTargets, 0xEE, sizeof expectedTargets);
+			memset(colors, 0xEE, sizeof colors);
+			memset(targets, 0xEE, sizeof targets);
+
+			const distance_accum_t expected = ScorePlayfieldSpanScalar(
+				fixture.registers, first, end, expectedColors, expectedTargets);
+			const distance_accum_t actual = kernel(
+				fixture.registers, first, end, colors, targets);
+			Require(actual == expected, "span kernel error sum must match scalar");
+			Require(memcmp(colors, expectedColors, width) == 0,
+				"span kernel colours must match scalar, and stay inside the run");
+			Require(memcmp(targets, expectedTargets, width) == 0,
+				"span kernel targets must match scalar, and stay inside the run");
+		}
+	}
+}
+
+void TestEverySupportedKernelMatchesScalar()
+{
+	const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::Sse41, SimdLevel::Avx2 };
+	for (SimdLevel level : levels)
+	{
+		if (level > DetectSimdLevel())
+			break;
+		const playfield_span_kernel kernel = SelectPlayfieldSpanKernel(level);
+		TestKernelMatchesScalar(kernel, 4, 0);
+		TestKernelMatchesScalar(kernel, 5000, 0);
+		TestKernelMatchesScalar(kernel, 6, 0x5A5A5A5A5Aull);
+		TestKernelMatchesScalar(kernel, 70000, 0xF0F0F0F0F0ull);
+	}
+}
+
+struct CompactSpanFixture
+{
+	std::vector<uint16_t> rows[E_PLAYFIELD_SLOT_MAX];
+	CompactPlayfieldSpanRegisters registers{};
+
+	CompactSpanFixture(int width, unsigned range, uint64_t alternate, unsigned shift,
+		unsigned seed)
+	{
+		std::mt19937 random(seed);
+		for (int slot = 0; slot < E_PLAYFIELD_SLOT_MAX; ++slot)
+		{
+			rows[slot].resize(width);
+			for (uint16_t& value : rows[slot])
+				value = static_cast<uint16_t>(random() % range);
+			registers.rows[slot] = rows[slot].data();
+			registers.colors[slot] = static_cast<unsigned char>(10 + slot * 7);
+			registers.targets[slot] = static_cast<unsigned char>(slot == 0 ? 3 : slot - 1);
+		}
+		registers.alternate_columns = alternate;
+		registers.shift = shift;
+	}
+};
+
+// The compact kernels against both their own scalar kernel and the exact
+// kernel run over the same values widened to 32 bits.
+void TestCompactKernelMatchesScalar(compact_playfield_span_kernel kernel,
+	unsigned range, uint64_t alternate, unsigned shift)
+{
+	const int width = 176;
+	CompactSpanFixture fixture(width, range, alternate, shift, 99u + range + shift);
+	std::vector<distance_t> widened[E_PLAYFIELD_SLOT_MAX];
+	PlayfieldSpanRegisters exact{};
+	for (int slot = 0; slot < E_PLAYFIELD_SLOT_MAX; ++slot)
+	{
+		for (uint16_t value : fixture.rows[slot])
+			widened[slot].push_back(distance_t{value} << shift);
+		exact.rows[slot] = widened[slot].data();
+		exact.colors[slot] = fixture.registers.colors[slot];
+		exact.targets[slot] = fixture.registers.targets[slot];
+	}
+	exact.alternate_columns = alternate;
+
+	for (int first = 0; first < 20; ++first)
+	{
+		for (int end = first; end <= width; end += 7)
+		{
+			unsigned char expectedColors[width];
+			unsigned char expectedTargets[width];
+			unsigned char colors[width];
+			unsigned char targets[width];
+			memset(expectedColors, 0xEE, sizeof expectedColors);
+			memset(expectedTargets, 0xEE, sizeof expectedTargets);
+			memset(colors, 0xEE, sizeof colors);
+			memset(targets, 0xEE, sizeof targets);
+
+			const distance_accum_t expected = ScorePlayfieldSpanScalar(
+				exact, first, end, expectedColors, expectedTargets);
+			Require(ScoreCompactPlayfieldSpanScalar(fixture.registers, first, end,
+				colors, targets) == expected,
+				"compact scalar kernel must score in exact-map units");
+			const distance_accum_t actual = kernel(
+				fixture.registers, first, end, colors, targets);
+			Require(actual == expected, "compact span kernel error sum must match scalar");
+			Require(memcmp(colors, expectedColors, width) == 0,
+				"compact span kernel colours must match scalar, and stay inside the run");
+			Require(memcmp(targets, expectedTargets, width) == 0,
+				"compact span kernel targets must match scalar, and stay inside the run");
+		}
+	}
+}
+
+void TestEverySupportedCompactKernelMatchesScalar()
+{
+	const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::Sse41, SimdLevel::Avx2 };
+	for (SimdLevel level : levels)
+	{
+		if (level > DetectSimdLevel())
+			break;
+		const compact_playfield_span_kernel kernel = SelectCompactPlayfieldSpanKernel(level);
+		TestCompactKernelMatchesScalar(kernel, 4, 0, 0);
+		TestCompactKernelMatchesScalar(kernel, 0x10000, 0, 5);
+		TestCompactKernelMatchesScalar(kernel, 6, 0x5A5A5A5A5Aull, 2);
+		TestCompactKernelMatchesScalar(kernel, 0x10000, 0xF0F0F0F0F0ull, 16);
+	}
+}
+
+void TestParseSimdLevel()
+{
+	SimdLevel level = SimdLevel::Avx2;
+	bool automatic = false;
+	Require(ParseSimdLevel("SSE4.1", level, automatic) && level == SimdLevel::Sse41
+		&& !automatic, "RASTA_SIMD values are case-insensitive");
+	Require(ParseSimdLevel("scalar", level, automatic) && level == SimdLevel::Scalar,
+		"scalar must select the portable kernels");
+	Require(ParseSimdLevel("auto", level, automatic) && automatic,
+		"auto must defer to detection");
+	Require(!ParseSimdLevel("avx512", level, automatic),
+		"unknown levels must be rejected, not guessed");
+	Require(!ParseSimdLevel(nullptr, level, automatic),
+		"an unset variable is not a request");
+	Require(ActiveSimdLevel() <= DetectSimdLevel(),
+		"the active level can never exceed what the machine supports");
+}
+
+void TestTiesKeepFirstCandidate()
+{
+	SpanFixture fixture(8, 1, 0, 1);
+	unsigned char colors[8];
+	unsigned char targets[8];
+	const distance_accum_t total = ScorePlayfieldSpan(
+		fixture.registers, 0, 8, colors, targets);
+	Require(total == 0, "all-zero rows must score zero");
+	for (int x = 0; x < 8; ++x)
+	{
+		Require(colors[x] == fixture.registers.colors[E_PLAYFIELD_SLOT_COLBAK],
+			"ties must resolve to COLBAK, the first candidate");
+	}
+}
+
+void TestAlternateColumnSelectsColor3()
+{
+	SpanFixture fixture(16, 1, uint64_t{1} << 1, 1);
+	for (int slot = 0; slot < E_PLAYFIELD_SLOT_MAX; ++slot)
+		fixture.planes[slot].assign(16, 100);
+	fixture.planes[E_PLAYFIELD_SLOT_COLOR2].assign(16, 5);
+	fixture.planes[E_PLAYFIELD_SLOT_COLOR3].assign(16, 1);
+	unsigned char colors[16];
+	unsigned char targets[16];
+	const distance_accum_t total = ScorePlayfieldSpan(
+		fixture.registers, 0, 16, colors, targets);
+	Require(total == 12 * 5 + 4 * 1, "only column 1 may use COLOR3");
+	for (int x = 0; x < 16; ++x)
+	{
+		const int slot = x / 4 == 1 ? E_PLAYFIELD_SLOT_COLOR3 : E_PLAYFIELD_SLOT_COLOR2;
+		Require(targets[x] == fixture.registers.targets[slot],
+			"attribute column must swap COLOR2 for COLOR3");
+	}
+}
+
+void TestLargeDistancesDoNotWrap()
+{
+	SpanFixture fixture(32, 1, 0, 1);
+	for (int slot = 0; slot < E_PLAYFIELD_SLOT_MAX; ++slot)
+		fixture.planes[slot].assign(32, DISTANCE_MAX - slot);
+	unsigned char colors[32];
+	unsigned char targets[32];
+	const distance_accum_t total = ScorePlayfieldSpan(
+		fixture.registers, 0, 32, colors, targets);
+	Require(total == distance_accum_t{32} * (DISTANCE_MAX - 3),
+		"errors above INT_MAX must compare and sum as unsigned");
+}
+}
+
+int main()
+{
+	TestEverySupportedKernelMatchesScalar();
+	TestEverySupportedCompactKernelMatchesScalar();
+	TestParseSimdLevel();
+	TestTiesKeepFirstCandidate();
+	TestAlternateColumnSelectsColor3();
+	TestLargeDistancesDoNotWrap();
+	std::cout << "PlayfieldSpan tests passed\n";
+	return 0;
+}
@@ -0,0 +1,151 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+void Require(bool condition, const char *message)
+{
+	if (!condition)
+	{
+		std::cerr << "FAILED: " << message << '\n';
+		std::exit(1);
+	}
+}
+
+void TestParallelForCoversRange()
+{
+	ThreadPool pool(4);
+	std::vector<std::atomic<int>> hits(1000);
+	ParallelFor(3, 1000, 7, 0, [&](int from, int to) {
+		for (int i = from; i < to; ++i)
+			hits[i].fetch_add(1);
+	}, CancellationToken(), pool);
+	for (int i = 0; i < 1000; ++i)
+		Require(hits[i].load() == (i >= 3 ? 1 : 0), "every index must be visited exactly once");
+}
+
+void TestCancelledTasksAreSkipped()
+{
+	ThreadPool pool(2);
+	CancellationToken token;
+	token.Cancel();
+	std::atomic<int> ran{0};
+	ParallelFor(0, 100, 1, 0, [&](int, int) { ran.fetch_add(1); }, token, pool);
+	Require(ran.load() == 0, "chunks must not start once the token is cancelled");
+
+	TaskGroup group(pool);
+	group.Cancel();
+	std::future<int> skipped = group.Async([] { return 1; });
+	group.Wait();
+	bool broken = false;
+	try
+	{
+		skipped.get();
+	}
+	catch (const std::future_error&)
+	{
+		broken = true;
+	}
+	Require(broken, "a skipped Async task must leave a broken promise");
+}
+
+void TestIdleThreadsSteal()
+{
+	// The child lands on the busy thread's own deque; only a steal can run it
+	// while the parent spins without helping.
+	ThreadPool pool(2);
+	std::atomic<bool> stolen{false};
+	std::atomic<bool> parent_done{false};
+	pool.Submit([&] {
+		pool.Submit([&] { stolen.store(true); });
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (!stolen.load() && std::chrono::steady_clock::now() < deadline)
+			std::this_thread::yield();
+		parent_done.store(true);
+	});
+	while (!parent_done.load())
+		std::this_thread::yield();
+	Require(stolen.load(), "an idle thread must steal from a busy one");
+}
+
+void TestConcurrencyCap()
+{
+	// /threads=2 on a larger machine: never more than two chunks at once.
+	ThreadPool pool(6);
+	std::atomic<int> active{0};
+	std::atomic<int> peak{0};
+	std::atomic<int> total{0};
+	ParallelFor(0, 64, 1, 2, [&](int from, int to) {
+		const int now = active.fetch_add(1) + 1;
+		int seen = peak.load();
+		while (now > seen && !peak.compare_exchange_weak(seen, now))
+			;
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+		total.fetch_add(to - from);
+		active.fetch_sub(1);
+	}, CancellationToken(), pool);
+	Require(total.load() == 64, "a capped loop must still cover the range");
+	Require(peak.load() <= 2, "a capped loop must not exceed its concurrency");
+
+	// A cap of one keeps the work on the calling thread.
+	const std::thread::id caller = std::this_thread::get_id();
+	bool elsewhere = false;
+	ParallelFor(0, 8, 1, 1, [&](int, int) {
+		elsewhere = elsewhere || std::this_thread::get_id() != caller;
+	}, CancellationToken(), pool);
+	Require(!elsewhere, "a concurrency of one must not use the pool");
+}
+
+void TestNestedGroupsDoNotDeadlock()
+{
+	// Every thread of a two-thread pool waits on an inner group, so the inner
+	// tasks only run because Wait helps.
+	ThreadPool pool(2);
+	std::atomic<int> total{0};
+	ParallelFor(0, 8, 1, 0, [&](int, int) {
+		ParallelFor(0, 16, 1, 0, [&](int from, int to) { total.fetch_add(to - from); },
+			CancellationToken(), pool);
+	}, CancellationToken(), pool);
+	Require(total.load() == 8 * 16, "nested loops must complete");
+}
+
+void TestResultsAndErrors()
+{
+	ThreadPool pool(2);
+	TaskGroup group(pool);
+	std::future<int> answer = group.Async([] { return 42; });
+	group.Run([] { throw std::runtime_error("task failed"); });
+	bool rethrown = false;
+	try
+	{
+		group.Wait();
+	}
+	catch (const std::runtime_error&)
+	{
+		rethrown = true;
+	}
+	Require(rethrown, "Wait must rethrow a task's exception");
+	Require(answer.get() == 42, "Async must deliver the result");
+	Require(group.Done(), "a waited group has nothing pending");
+	group.Wait();
+}
+}
+
+int main()
+{
+	TestParallelForCoversRange();
+	TestCancelledTasksAreSkipped();
+	TestIdleThreadsSteal();
+	TestConcurrencyCap();
+	TestNestedGroupsDoNotDeadlock();
+	TestResultsAndErrors();
+	std::cout << "ThreadPool tests passed\n";
+	return 0;
+}
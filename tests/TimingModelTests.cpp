@@ -1,9 +1,12 @@
 #include "Program.h"
+#include "RegisterState.h"
 
 #include <cstdlib>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <initializer_list>
+#include <vector>
 
 void create_cycles_table();
 
@@ -355,6 +358,103 @@ void TestGtiaPriority0Resolver()
 		"PRIOR 4 must keep PF1 above P2");
 }
 
+SRasterInstruction MakeInstruction(e_raster_instruction instruction,
+	e_target target = E_TARGET_MAX, unsigned char value = 0)
+{
+	SRasterInstruction result{};
+	result.loose.instruction = static_cast<unsigned short>(instruction);
+	result.loose.target = static_cast<unsigned char>(target);
+	result.loose.value = value;
+	return result;
+}
+
+void TestLineEntryLiveRegisters()
+{
+	const RasterLineSchedule schedule = GetRasterLineSchedule(GraphicsMode::AnticE, 10);
+	const int lineEnd = 160 + 16;
+	const SRasterInstruction insns[] = {
+		MakeInstruction(E_RASTER_LDA, E_TARGET_MAX, 0x24),
+		MakeInstruction(E_RASTER_STA, E_COLOR0),
+		MakeInstruction(E_RASTER_STX, E_COLBAK),
+		MakeInstruction(E_RASTER_LDX, E_TARGET_MAX, 0x10),
+		MakeInstruction(E_RASTER_STA, E_HPOSP0),
+	};
+	const unsigned count = sizeof insns / sizeof insns[0];
+	Require(RasterInstructionCompletionOffset(schedule.timing->cycles.data(),
+			2, insns[1], false) < 0,
+		"the first store must land before the first pixel for this test");
+	const register_state live = LineEntryLiveRegisters(insns, count, schedule, false, lineEnd);
+	Require(live.reg_a == 0, "A loaded before any store is dead on entry");
+	Require(live.reg_x == 0xFF, "X stored before it is loaded is observed");
+	Require(live.reg_y == 0xFF, "an untouched Y passes through and stays live");
+	Require(live.mem_regs[E_COLOR0] == 0, "a colour stored before the first pixel is dead");
+	Require(live.mem_regs[E_COLOR1] == 0xFF, "an untouched colour passes through");
+	Require(live.mem_regs[E_HPOSP0] == 0xFF, "player positions are always observed");
+
+	int cycle = 0;
+	int storeAfterPixels = -1;
+	for (int i = 0; i < 8; ++i)
+	{
+		const int offset = RasterInstructionCompletionOffset(
+			schedule.timing->cycles.data(), cycle, insns[1], false);
+		if (offset >= 0 && offset < lineEnd - 1)
+		{
+			storeAfterPixels = cycle;
+			break;
+		}
+		cycle += 4;
+	}
+	Require(storeAfterPixels >= 0, "a store must be able to land on the playfield");
+	std::vector<SRasterInstruction> late;
+	for (int nops = 0; nops < storeAfterPixels / 2; ++nops)
+		late.push_back(MakeInstruction(E_RASTER_NOP));
+	late.push_back(MakeInstruction(E_RASTER_STA, E_COLOR2));
+	const register_state lateLive = LineEntryLiveRegisters(late.data(),
+		static_cast<unsigned>(late.size()), schedule, false, lineEnd);
+	Require(lateLive.mem_regs[E_COLOR2] == 0xFF,
+		"a colour stored after the first pixel is still observed");
+
+	const SRasterInstruction passThrough[] = {
+		MakeInstruction(E_RASTER_STA, E_COLOR1),
+	};
+	RasterLineSchedule transition = GetRasterLineSchedule(GraphicsMode::Antic4, 23, 240);
+	Require(transition.chbase_transition, "line 23 must switch ANTIC 4 character sets");
+	Require(LineEntryLiveRegisters(nullptr, 0, transition, true, lineEnd).reg_a == 0,
+		"the CHBASE suffix clobbers an untouched A");
+	Require(LineEntryLiveRegisters(passThrough, 1, transition, true, lineEnd).reg_a == 0xFF,
+		"A stored before the CHBASE suffix is observed");
+
+	register_state state1{}, state2{};
+	state2.reg_a = 7;
+	state2.mem_regs[E_COLOR0] = 9;
+	Require(MaskedRegisterStatesEqual(state1, state2, live),
+		"states differing only in dead registers must compare equal");
+	state2.reg_y = 1;
+	Require(!MaskedRegisterStatesEqual(state1, state2, live),
+		"states differing in a live register must differ");
+	MaskRegisterState(state2, live);
+	Require(state2.reg_a == 0 && state2.mem_regs[E_COLOR0] == 0 && state2.reg_y == 1,
+		"masking clears exactly the dead registers");
+}
+
+void TestSpriteRowPacking()
+{
+	sprites_row_memory_t row{};
+	row[0][0] = 1;
+	row[1][7] = 1;
+	row[3][4] = 1;
+	const uint32_t bits = PackSpriteRow(row);
+	Require(bits == (SpriteRowBit(0, 0) | SpriteRowBit(1, 7) | SpriteRowBit(3, 4)),
+		"each set data byte must map to its own bit");
+	Require(SpriteRowPlayerBits(bits, 1) == 0x80 && SpriteRowPlayerBits(bits, 2) == 0,
+		"player bits must come from the player's own byte");
+	sprites_row_memory_t unpacked;
+	memset(unpacked, 0xAA, sizeof unpacked);
+	UnpackSpriteRow(unpacked, bits);
+	Require(memcmp(unpacked, row, sizeof row) == 0,
+		"unpacking must restore every data byte");
+}
+
 }
 
 int main()
@@ -379,6 +479,8 @@ int main()
 	TestAntic4TimingProfiles();
 	TestAntic4EncodingPrimitives();
 	TestGtiaPriority0Resolver();
+	TestLineEntryLiveRegisters();
+	TestSpriteRowPacking();
 
 	std::cout << "Timing model tests passed\n";
 	return 0;
@@ -0,0 +1,108 @@
+#include "WorkerPlacement.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+void Require(bool condition, const char *message)
+{
+	if (!condition)
+	{
+		std::cerr << "FAILED: " << message << '\n';
+		std::exit(1);
+	}
+}
+
+// Two nodes of two cores with two hardware threads each, numbered the way
+// Linux usually does: first threads 0-3, their siblings 4-7.
+CpuTopology TwoNodeSmtTopology()
+{
+	CpuTopology topology;
+	for (int id = 0; id < 8; ++id)
+	{
+		CpuTopology::Cpu cpu;
+		cpu.id = id;
+		cpu.core = id % 2;
+		cpu.package = (id % 4) / 2;
+		cpu.node = cpu.package;
+		topology.cpus.push_back(cpu);
+	}
+	return topology;
+}
+
+void TestParseCpuList()
+{
+	Require(ParseCpuList("0-3,8,10-11") == std::vector<int>({0, 1, 2, 3, 8, 10, 11}),
+		"ranges and single CPUs must both be expanded");
+	Require(ParseCpuList("").empty(), "an empty list has no CPUs");
+	Require(ParseCpuList("5\n") == std::vector<int>({5}),
+		"the trailing newline of a sysfs file must be ignored");
+}
+
+void TestNoneLeavesWorkersFloating()
+{
+	const WorkerPlacement placement =
+		PlanWorkerPlacement(TwoNodeSmtTopology(), PinPolicy::None, 4);
+	Require(placement.cpu.size() == 4 && !placement.Pinned(),
+		"/pin=none must not pin any worker");
+	Require(placement.Nodes().empty(), "unpinned workers have no node");
+}
+
+void TestCoresBeforeSiblings()
+{
+	const WorkerPlacement placement =
+		PlanWorkerPlacement(TwoNodeSmtTopology(), PinPolicy::Cores, 4);
+	Require(placement.cpu == std::vector<int>({0, 2, 1, 3}),
+		"cores policy must alternate nodes and take one thread per core first");
+	Require(placement.node == std::vector<int>({0, 1, 0, 1}),
+		"workers must be spread round-robin over the nodes");
+	Require(placement.Nodes() == std::vector<int>({0, 1}),
+		"both nodes hold workers");
+}
+
+void TestSmtFillsCores()
+{
+	const WorkerPlacement placement =
+		PlanWorkerPlacement(TwoNodeSmtTopology(), PinPolicy::Smt, 4);
+	Require(placement.cpu == std::vector<int>({0, 2, 4, 6}),
+		"smt policy must use both threads of a core before the next core");
+}
+
+void TestWrapAround()
+{
+	const WorkerPlacement placement =
+		PlanWorkerPlacement(TwoNodeSmtTopology(), PinPolicy::Cores, 10);
+	Require(placement.cpu.size() == 10, "every worker gets a CPU");
+	Require(placement.cpu[8] == placement.cpu[0] && placement.cpu[9] == placement.cpu[1],
+		"more workers than CPUs must repeat the order");
+	std::vector<int> used(placement.cpu.begin(), placement.cpu.begin() + 8);
+	for (int id = 0; id < 8; ++id)
+		Require(std::count(used.begin(), used.end(), id) == 1,
+			"the first pass must use every CPU exactly once");
+}
+
+void TestDescription()
+{
+	const CpuTopology topology = TwoNodeSmtTopology();
+	const std::string text = DescribeWorkerPlacement(topology,
+		PlanWorkerPlacement(topology, PinPolicy::Cores, 4), PinPolicy::Cores);
+	Require(text == "4 worker(s) on 8 CPU(s), 2 node(s), pinned cores first: "
+		"node 0 cpu 0,1; node 1 cpu 2,3", "unexpected placement description");
+}
+}
+
+int main()
+{
+	TestParseCpuList();
+	TestNoneLeavesWorkersFloating();
+	TestCoresBeforeSiblings();
+	TestSmtFillsCores();
+	TestWrapAround();
+	TestDescription();
+	std::cout << "WorkerPlacement tests passed\n";
+	return 0;
+}